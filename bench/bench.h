@@ -0,0 +1,15 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_BENCH_H
+#define HASP_BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* ===== Heap Accounting ===== */
+size_t bench_heap_used();
+size_t bench_heap_peak();
+void bench_heap_reset_peak();
+
+#endif
@@ -0,0 +1,117 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Heap accounting for the host benchmarks
+ * The bench environment links with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+ * so every allocation made by the firmware code passes through here. */
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+#include "bench.h"
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+}
+
+static size_t heap_used = 0;
+static size_t heap_peak = 0;
+
+static inline void bench_heap_add(void* ptr)
+{
+    if(!ptr) return;
+    heap_used += malloc_usable_size(ptr);
+    if(heap_used > heap_peak) heap_peak = heap_used;
+}
+
+static inline void bench_heap_sub(void* ptr)
+{
+    if(ptr) heap_used -= malloc_usable_size(ptr);
+}
+
+extern "C" {
+
+void* __wrap_malloc(size_t size)
+{
+    void* ptr = __real_malloc(size);
+    bench_heap_add(ptr);
+    return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    void* ptr = __real_calloc(count, size);
+    bench_heap_add(ptr);
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void* grown = __real_realloc(ptr, size);
+    if(grown || size == 0) {
+        heap_used -= old;
+        bench_heap_add(grown);
+    }
+    return grown;
+}
+
+void __wrap_free(void* ptr)
+{
+    bench_heap_sub(ptr);
+    __real_free(ptr);
+}
+}
+
+/* Route new and delete through the wrapped allocator as well */
+void* operator new(size_t size)
+{
+    void* ptr = __wrap_malloc(size ? size : 1);
+    if(!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    __wrap_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    __wrap_free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    __wrap_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    __wrap_free(ptr);
+}
+
+size_t bench_heap_used()
+{
+    return heap_used;
+}
+
+size_t bench_heap_peak()
+{
+    return heap_peak;
+}
+
+void bench_heap_reset_peak()
+{
+    heap_peak = heap_used;
+}
@@ -0,0 +1,619 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Host benchmarks for the dispatch and attribute hot path
+ *
+ * Build and run with the bench_64bits environment on a Linux host:
+ *   pio run -e bench_64bits && .pio/build/bench_64bits/program [options] [filter]
+ *
+ * Options:
+ *   -n <scale>  multiply the number of iterations, default 1
+ *   --csv       print the results as csv for regression tracking
+ *   --dump <f>  render the test page once more and write the framebuffer to a bitmap
+ *
+ * Only the benchmarks whose name contains the filter are run.
+ * The file benchmarks write a scratch file to LV_FS_PC_PATH and read it through lv_fs, once straight from the
+ * pc driver and once through the handle pool and read-ahead cache of lv_fs_cache.
+ * The syslog benchmark sends its datagrams to a listener on an ephemeral port of the loopback interface.
+ * The pagebin benchmarks compile the test page with tools/jsonl2bin.py, run the bench from the project folder.
+ */
+
+#if defined(POSIX)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "hasplib.h"
+#include "hasp_gui.h"
+#include "hasp_debug.h"
+#include "dev/device.h"
+
+#include "bench.h"
+
+#if LV_USE_FS_IF && LV_FS_IF_PC != '\0'
+#include "lv_fs_cache.h"
+
+#ifndef LV_FS_PC_PATH
+#define LV_FS_PC_PATH "/fs"
+#endif
+#endif
+
+#if HASP_USE_SYSLOG > 0
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "log/hasp_syslog.h"
+#endif
+
+#ifndef BENCH_JSONL2BIN
+#define BENCH_JSONL2BIN "python3 tools/jsonl2bin.py"
+#endif
+
+typedef std::chrono::steady_clock bench_clock;
+
+static const char* bench_filter = NULL;
+static size_t bench_scale       = 1;
+static bool bench_csv           = false;
+static const char* bench_dump   = NULL;
+
+/* ===== Runner ===== */
+
+static void bench_report(const char* name, size_t ops, double ns, size_t heap, size_t lvmem)
+{
+    if(bench_csv) {
+        printf("%s,%zu,%.1f,%zu,%zu\n", name, ops, ns, heap, lvmem);
+    } else {
+        printf("%-44s %9zu ops %12.1f ns/op %9zu B heap %9zu B lvmem\n", name, ops, ns, heap, lvmem);
+    }
+    fflush(stdout);
+}
+
+static size_t bench_lvmem_used()
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+/**
+ * Time a benchmark in rounds, only the body is measured
+ * @param name the name of the benchmark
+ * @param rounds the number of times to run the body
+ * @param ops the number of operations performed by one run of the body
+ * @param setup prepares a round, not timed
+ * @param body the code under test
+ * @param teardown cleans up a round, not timed
+ * @note the reported heap is the peak malloc usage and the lvmem the lvgl pool usage during the body
+ */
+template <typename Setup, typename Body, typename Teardown>
+static void bench_rounds(const char* name, size_t rounds, size_t ops, Setup setup, Body body, Teardown teardown)
+{
+    if(bench_filter && !strstr(name, bench_filter)) return;
+
+    rounds *= bench_scale;
+    bench_clock::duration elapsed(0);
+    size_t heap  = 0;
+    size_t lvmem = 0;
+
+    for(size_t r = 0; r < rounds; r++) {
+        setup();
+        size_t heap_start  = bench_heap_used();
+        size_t lvmem_start = bench_lvmem_used();
+        bench_heap_reset_peak();
+
+        bench_clock::time_point start = bench_clock::now();
+        body();
+        elapsed += bench_clock::now() - start;
+
+        size_t lvmem_end = bench_lvmem_used();
+        if(bench_heap_peak() - heap_start > heap) heap = bench_heap_peak() - heap_start;
+        if(lvmem_end > lvmem_start && lvmem_end - lvmem_start > lvmem) lvmem = lvmem_end - lvmem_start;
+        teardown();
+    }
+
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * ops);
+    bench_report(name, rounds * ops, ns, heap, lvmem);
+}
+
+/* Time a body that is called once per operation */
+template <typename Body>
+static void bench_loop(const char* name, size_t ops, Body body)
+{
+    bench_rounds(
+        name, 1, ops, [] {},
+        [&] {
+            for(size_t i = 0; i < ops; i++) body(i);
+        },
+        [] {});
+}
+
+/* ===== Test Pages ===== */
+
+enum bench_value_type_t { BENCH_INT, BENCH_STRING };
+
+struct bench_attr_t
+{
+    const char* name;
+    bench_value_type_t type;
+    std::string value;
+};
+
+struct bench_obj_t
+{
+    const char* obj;
+    uint8_t id;
+    std::vector<bench_attr_t> attrs;
+};
+
+static const uint8_t BENCH_PAGE = 2;
+
+/* A mix of the objects found on typical pages, laid out in a grid */
+static std::vector<bench_obj_t> bench_page_objects(size_t count)
+{
+    static const char* colors[] = {"#2196F3", "#FF9800", "#4CAF50", "#F44336", "#9E9E9E"};
+    std::vector<bench_obj_t> objects;
+
+    for(size_t i = 0; i < count && i < 250; i++) {
+        bench_obj_t o;
+        o.id              = i + 1;
+        std::string x     = std::to_string(10 + (i % 4) * 56);
+        std::string y     = std::to_string(10 + (i / 4) % 8 * 38);
+        std::string color = colors[i % 5];
+
+        o.attrs.push_back({"x", BENCH_INT, x});
+        o.attrs.push_back({"y", BENCH_INT, y});
+        o.attrs.push_back({"w", BENCH_INT, "50"});
+        o.attrs.push_back({"h", BENCH_INT, "32"});
+
+        switch(i % 6) {
+            case 0:
+                o.obj = "btn";
+                o.attrs.push_back({"text", BENCH_STRING, "Button " + std::to_string(i)});
+                o.attrs.push_back({"radius", BENCH_INT, "8"});
+                o.attrs.push_back({"bg_color", BENCH_STRING, color});
+                break;
+            case 1:
+                o.obj = "label";
+                o.attrs.push_back({"text", BENCH_STRING, "Temperature 21.5\xC2\xB0" "C"});
+                o.attrs.push_back({"text_color", BENCH_STRING, "white"});
+                o.attrs.push_back({"text_font", BENCH_INT, "2"});
+                break;
+            case 2:
+                o.obj = "slider";
+                o.attrs.push_back({"min", BENCH_INT, "0"});
+                o.attrs.push_back({"max", BENCH_INT, "255"});
+                o.attrs.push_back({"val", BENCH_INT, std::to_string(i % 256)});
+                o.attrs.push_back({"bg_color", BENCH_STRING, color});
+                break;
+            case 3:
+                o.obj = "switch";
+                o.attrs.push_back({"val", BENCH_INT, std::to_string(i % 2)});
+                o.attrs.push_back({"bg_color10", BENCH_STRING, color});
+                break;
+            case 4:
+                o.obj = "arc";
+                o.attrs.push_back({"min", BENCH_INT, "0"});
+                o.attrs.push_back({"max", BENCH_INT, "100"});
+                o.attrs.push_back({"val", BENCH_INT, std::to_string(i % 101)});
+                o.attrs.push_back({"line_color10", BENCH_STRING, color});
+                break;
+            default:
+                o.obj = "dropdown";
+                o.attrs.push_back({"options", BENCH_STRING, "Off\\nLow\\nMedium\\nHigh"});
+                o.attrs.push_back({"val", BENCH_INT, "1"});
+                break;
+        }
+        objects.push_back(o);
+    }
+    return objects;
+}
+
+static std::string bench_object_json(const bench_obj_t& o, bool page)
+{
+    std::string json = "{";
+    if(page) json += "\"page\":" + std::to_string(BENCH_PAGE) + ",";
+    json += "\"id\":" + std::to_string(o.id) + ",\"obj\":\"" + o.obj + "\"";
+    for(const bench_attr_t& a : o.attrs) {
+        json += ",\"" + std::string(a.name) + "\":";
+        json += a.type == BENCH_INT ? a.value : "\"" + a.value + "\"";
+    }
+    return json + "}";
+}
+
+static std::string bench_page_jsonl(const std::vector<bench_obj_t>& objects)
+{
+    std::string jsonl;
+    for(const bench_obj_t& o : objects) jsonl += bench_object_json(o, &o == &objects.front()) + "\n";
+    return jsonl;
+}
+
+/* The same page compiled by tools/jsonl2bin.py, the only pages.bin encoder. Empty if the tool fails to run. */
+static std::string bench_page_bin(const std::string& jsonl)
+{
+    std::string source = P_tmpdir "/hasp_bench_page.jsonl";
+    std::string target = P_tmpdir "/hasp_bench_page.bin";
+    std::string bin;
+
+    FILE* file = fopen(source.c_str(), "wb");
+    if(!file) return bin;
+    fwrite(jsonl.data(), 1, jsonl.size(), file);
+    fclose(file);
+
+    std::string command = BENCH_JSONL2BIN " " + source + " " + target + " >/dev/null";
+    if(system(command.c_str()) == 0 && (file = fopen(target.c_str(), "rb"))) {
+        char buffer[4096];
+        for(size_t len; (len = fread(buffer, 1, sizeof(buffer), file)) > 0;) bin.append(buffer, len);
+        fclose(file);
+    }
+
+    remove(source.c_str());
+    remove(target.c_str());
+    return bin;
+}
+
+/* Fill the test page with objects that the update benchmarks can address */
+static void bench_load_page(size_t count)
+{
+    haspClearPage(BENCH_PAGE);
+    std::istringstream stream(bench_page_jsonl(bench_page_objects(count)));
+    dispatch_parse_jsonl(stream);
+}
+
+/* ===== Benchmarks ===== */
+
+static void bench_colors()
+{
+    lv_color32_t color;
+    bench_loop("color/hex6", 100000, [&](size_t) { Parser::haspPayloadToColor("#FF8800", color); });
+    bench_loop("color/hex3", 100000, [&](size_t) { Parser::haspPayloadToColor("#F80", color); });
+    bench_loop("color/rgb565", 100000, [&](size_t) { Parser::haspPayloadToColor("64512", color); });
+    bench_loop("color/named", 100000, [&](size_t) { Parser::haspPayloadToColor("magenta", color); });
+    bench_loop("color/unknown", 100000, [&](size_t) { Parser::haspPayloadToColor("nocolor", color); });
+}
+
+static void bench_text_lines()
+{
+    bench_load_page(24);
+
+    bench_loop("text_line/text", 20000, [](size_t) { dispatch_text_line("p2b1.text=Hello World"); });
+    bench_loop("text_line/val", 20000, [](size_t i) { dispatch_text_line(i & 1 ? "p2b3.val=10" : "p2b3.val=200"); });
+    bench_loop("text_line/bg_color", 20000, [](size_t i) {
+        dispatch_text_line(i & 1 ? "p2b1.bg_color=#FF0000" : "p2b1.bg_color=#0000FF");
+    });
+    bench_loop("text_line/hidden", 20000, [](size_t i) { dispatch_text_line(i & 1 ? "p2b2.hidden=1" : "p2b2.hidden=0"); });
+    bench_loop("text_line/get_val", 20000, [](size_t) { dispatch_text_line("p2b3.val"); });
+    bench_loop("text_line/unknown_obj", 20000, [](size_t) { dispatch_text_line("p2b251.text=Missing"); });
+}
+
+static void bench_json()
+{
+    static const size_t sizes[] = {1, 10, 50};
+
+    bench_load_page(60);
+
+    for(size_t size : sizes) {
+        std::string json = "[";
+        for(size_t i = 0; i < size; i++) {
+            if(i) json += ",";
+            json += "\"p2b" + std::to_string(i % 60 + 1) + ".text=Item " + std::to_string(i) + "\"";
+        }
+        json += "]";
+
+        std::string name = "json/array_" + std::to_string(size);
+        bench_loop(name.c_str(), 20000 / size, [&](size_t) { dispatch_parse_json(NULL, json.c_str()); });
+    }
+
+    std::string object = bench_object_json(bench_page_objects(1).front(), true);
+    bench_loop("json/object_update", 10000, [&](size_t) { dispatch_parse_json(NULL, object.c_str()); });
+}
+
+static void bench_pages()
+{
+    static const size_t sizes[] = {10, 50, 200};
+
+    for(size_t size : sizes) {
+        std::vector<bench_obj_t> objects = bench_page_objects(size);
+        std::string jsonl                = bench_page_jsonl(objects);
+        std::string bin                  = bench_page_bin(jsonl);
+        std::string name;
+        size_t rounds = 2000 / size;
+
+        name = "jsonl/page_" + std::to_string(size);
+        bench_rounds(
+            name.c_str(), rounds, size, [] { haspClearPage(BENCH_PAGE); },
+            [&] {
+                std::istringstream stream(jsonl);
+                dispatch_parse_jsonl(stream);
+            },
+            [] {});
+
+        name = "pagebin/page_" + std::to_string(size);
+        if(bin.empty()) {
+            if(!bench_csv) printf("%-44s skipped, %s failed\n", name.c_str(), BENCH_JSONL2BIN);
+        } else {
+            bench_rounds(
+                name.c_str(), rounds, size, [] { haspClearPage(BENCH_PAGE); },
+                [&] {
+                    std::istringstream stream(bin);
+                    hasp_pagebin_load(stream);
+                },
+                [] {});
+        }
+
+        /* Object creation only, the json documents are parsed up front */
+        std::vector<DynamicJsonDocument*> docs;
+        name = "new_object/page_" + std::to_string(size);
+        bench_rounds(
+            name.c_str(), rounds, size,
+            [&] {
+                haspClearPage(BENCH_PAGE);
+                for(const bench_obj_t& o : objects) {
+                    DynamicJsonDocument* doc = new DynamicJsonDocument(512);
+                    deserializeJson(*doc, bench_object_json(o, true));
+                    docs.push_back(doc);
+                }
+            },
+            [&] {
+                uint8_t saved_page_id = BENCH_PAGE;
+                for(DynamicJsonDocument* doc : docs) hasp_new_object(doc->as<JsonObject>(), saved_page_id);
+            },
+            [&] {
+                for(DynamicJsonDocument* doc : docs) delete doc;
+                docs.clear();
+            });
+    }
+
+    haspClearPage(BENCH_PAGE);
+}
+
+/* Render the active screen once, the headless driver measures the pass */
+static void bench_refresh()
+{
+    haspTft.frame_begin();
+    lv_refr_now(NULL);
+    haspTft.frame_end();
+}
+
+/* Print the render metrics of the frames since the last reset */
+static void bench_render_report(const char* name)
+{
+    if(bench_filter && !strstr(name, bench_filter)) return;
+
+    const dev::headless_stats_t& stats = haspTft.get_stats();
+    if(bench_csv || stats.frames == 0) return;
+
+    printf("%-44s %9u frames %8llu px/frame %6.1f flushes/frame %8u us max\n", "", stats.frames,
+           (unsigned long long)(stats.pixels / stats.frames), (double)stats.flushes / stats.frames,
+           stats.render_us_max);
+}
+
+static void bench_render()
+{
+    bench_load_page(24);
+    haspSetPage(BENCH_PAGE);
+    bench_refresh();
+
+    haspTft.reset_stats();
+    bench_rounds(
+        "render/full_screen", 200, 1, [] { lv_obj_invalidate(lv_scr_act()); }, [] { bench_refresh(); }, [] {});
+    bench_render_report("render/full_screen");
+
+    size_t i = 0;
+    haspTft.reset_stats();
+    bench_rounds(
+        "render/label_text", 1000, 1,
+        [&] { dispatch_text_line(i++ & 1 ? "p2b2.text=Temperature 21.5" : "p2b2.text=Temperature 22.0"); },
+        [] { bench_refresh(); }, [] {});
+    bench_render_report("render/label_text");
+
+    haspTft.reset_stats();
+    bench_rounds(
+        "render/slider_val", 1000, 1, [&] { dispatch_text_line(i++ & 1 ? "p2b3.val=10" : "p2b3.val=200"); },
+        [] { bench_refresh(); }, [] {});
+    bench_render_report("render/slider_val");
+
+    haspTft.reset_stats();
+    bench_rounds(
+        "render/button_color", 1000, 1,
+        [&] { dispatch_text_line(i++ & 1 ? "p2b1.bg_color=#FF0000" : "p2b1.bg_color=#0000FF"); },
+        [] { bench_refresh(); }, [] {});
+    bench_render_report("render/button_color");
+}
+
+#if LV_USE_FS_IF && LV_FS_IF_PC != '\0'
+/* Open, read and close a file the way images and fonts are loaded, with and without the handle pool */
+static void bench_fs()
+{
+    const size_t file_size = 64 * 1024;
+    const char* file_name  = "hasp_bench.bin";
+    char path[64]          = {LV_FS_IF_PC, ':', '/'};
+    strncat(path, file_name, sizeof(path) - 4);
+
+    std::string native = std::string(LV_FS_PC_PATH "/") + file_name;
+    FILE* scratch      = fopen(native.c_str(), "wb");
+    if(!scratch) {
+        printf("%-44s cannot write %s\n", "fs/", native.c_str());
+        return;
+    }
+    for(size_t i = 0; i < file_size; i++) fputc(i & 0xFF, scratch);
+    fclose(scratch);
+
+    uint8_t buffer[4096];
+    uint32_t br;
+
+    // An image header followed by a few small reads, like the decoders probe a file
+    auto header = [&](size_t) {
+        lv_fs_file_t file;
+        if(lv_fs_open(&file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return;
+        lv_fs_read(&file, buffer, 4, &br);
+        lv_fs_read(&file, buffer, 24, &br);
+        lv_fs_seek(&file, 1024);
+        lv_fs_read(&file, buffer, 16, &br);
+        lv_fs_close(&file);
+    };
+
+    // The whole file in chunks of a given size
+    auto stream = [&](uint32_t chunk) {
+        lv_fs_file_t file;
+        if(lv_fs_open(&file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return;
+        do {
+            lv_fs_read(&file, buffer, chunk, &br);
+        } while(br == chunk);
+        lv_fs_close(&file);
+    };
+
+    for(int cached = 0; cached < 2; cached++) {
+        lv_fs_cache_enable(cached);
+        std::string prefix = cached ? "fs/cached/" : "fs/direct/";
+
+        bench_loop((prefix + "header").c_str(), 10000, header);
+        bench_rounds(
+            (prefix + "stream_64").c_str(), 200, file_size / 64, [] {}, [&] { stream(64); }, [] {});
+        bench_rounds(
+            (prefix + "stream_4096").c_str(), 200, file_size / 4096, [] {}, [&] { stream(4096); }, [] {});
+    }
+
+    lv_fs_cache_info_t info;
+    lv_fs_cache_info(&info);
+    if(!bench_csv && info.handle_hits + info.handle_misses > 0) {
+        printf("%-44s %9u handle hits %9u misses %9u block hits %9u misses %9u bypassed\n", "", info.handle_hits,
+               info.handle_misses, info.block_hits, info.block_misses, info.bypassed);
+    }
+
+    remove(native.c_str());
+}
+#endif
+
+#if HASP_USE_SYSLOG > 0
+/* Send log lines to a listener on the loopback interface and count what arrives */
+static void bench_syslog()
+{
+    const char* name = "syslog/message";
+    if(bench_filter && !strstr(name, bench_filter)) return;
+
+    int listener = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in address;
+    socklen_t address_len = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int rcvbuf              = 4 * 1024 * 1024;
+    setsockopt(listener, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if(listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+       getsockname(listener, (struct sockaddr*)&address, &address_len) != 0 ||
+       !syslogStart("127.0.0.1", ntohs(address.sin_port))) {
+        printf("%-44s listener failed\n", name);
+        if(listener >= 0) close(listener);
+        return;
+    }
+
+    static const char line[] = "<134>1 - plate DISP - - - [12345/67890 12] p2b3.val=200";
+    size_t received          = 0;
+    size_t datagrams         = 0;
+    char buffer[SYSLOG_BATCH_SIZE];
+
+    // Drain the socket between rounds so the receive buffer never overflows
+    auto receive = [&] {
+        ssize_t len;
+        while((len = recv(listener, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            datagrams++;
+            for(ssize_t i = 0; i < len; i++) received += buffer[i] == '\n';
+        }
+    };
+
+    bench_rounds(
+        name, 20, 1000, [] {},
+        [&] {
+            for(size_t i = 0; i < 1000; i++) {
+                syslogMessageBegin();
+                syslogWrite((const uint8_t*)line, sizeof(line) - 1);
+                syslogMessageEnd();
+            }
+        },
+        [&] {
+            syslogFlush();
+            receive();
+        });
+
+    syslog_stats_t stats;
+    syslogGetStats(&stats);
+    syslogStop();
+    receive();
+    close(listener);
+
+    if(!bench_csv) {
+        printf("%-44s %9zu received %6.1f msg/datagram %8u dropped\n", "", received,
+               datagrams ? (double)received / datagrams : 0.0, stats.dropped);
+    }
+}
+#endif
+
+/* ===== Main ===== */
+
+static void bench_usage(const char* progname)
+{
+    printf("%s [-n scale] [--csv] [--dump file.bmp] [filter]\n", progname);
+}
+
+int main(int argc, char* argv[])
+{
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+            bench_usage(argv[0]);
+            return 0;
+        } else if(!strcmp(argv[i], "--csv")) {
+            bench_csv = true;
+        } else if(!strcmp(argv[i], "--dump") && i + 1 < argc) {
+            bench_dump = argv[++i];
+        } else if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+            bench_scale = atoi(argv[++i]);
+            if(bench_scale < 1) bench_scale = 1;
+        } else if(argv[i][0] == '-') {
+            bench_usage(argv[0]);
+            return 1;
+        } else {
+            bench_filter = argv[i];
+        }
+    }
+
+    haspDevice.init();
+    guiSetup();
+    dispatchSetup();
+    haspSetup();
+
+    if(bench_csv) {
+        printf("name,ops,ns_per_op,heap_bytes,lvmem_bytes\n");
+    } else {
+        haspDevice.show_info();
+    }
+
+    bench_colors();
+    bench_text_lines();
+    bench_json();
+    bench_pages();
+    bench_render();
+#if LV_USE_FS_IF && LV_FS_IF_PC != '\0'
+    bench_fs();
+#endif
+#if HASP_USE_SYSLOG > 0
+    bench_syslog();
+#endif
+
+    if(bench_dump) {
+        bench_load_page(24);
+        haspSetPage(BENCH_PAGE);
+        lv_obj_invalidate(lv_scr_act());
+        bench_refresh();
+        if(!haspTft.dump(bench_dump)) return 1;
+    }
+
+    return 0;
+}
+
+#endif // POSIX
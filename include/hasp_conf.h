@@ -81,6 +81,10 @@
 #define HASP_USE_PNGDECODE 0
 #endif
 
+#ifndef HASP_USE_PROFILER
+#define HASP_USE_PROFILER 0 // Main loop timing histograms, see the profiler command
+#endif
+
 #ifndef HASP_NUM_GPIO_CONFIG
 #define HASP_NUM_GPIO_CONFIG 8
 #endif
@@ -101,13 +105,29 @@
 #endif
 #endif
 
+#ifndef HASP_JSONL_CHUNK_SIZE
+#define HASP_JSONL_CHUNK_SIZE 512 // Initial size of the jsonl read buffer and parse arena
+#endif
+
+#ifndef HASP_JSONL_MAX_LINE
+#if defined(ARDUINO_ARCH_ESP8266)
+#define HASP_JSONL_MAX_LINE 2048 // Longest jsonl line that can be loaded
+#else
+#define HASP_JSONL_MAX_LINE 8192
+#endif
+#endif
+
+#ifndef HASP_JSONL_MAX_ARENA
+#define HASP_JSONL_MAX_ARENA (HASP_JSONL_MAX_LINE * 2) // Largest parse arena for one jsonl line
+#endif
+
 #define HASP_OBJECT_NOTATION "p%ub%u"
 
 /* Includes */
-#ifdef WINDOWS
+#if defined(WINDOWS)
 #include "winsock2.h"
 #include "Windows.h"
-#else
+#elif !defined(POSIX)
 #include "Arduino.h"
 #endif
 
@@ -183,7 +203,7 @@ static WiFiSpiClass WiFi;
 #if HASP_USE_MQTT > 0
 #include "mqtt/hasp_mqtt.h"
 
-#ifdef WINDOWS
+#if defined(WINDOWS) || defined(POSIX)
 #define USE_PAHO
 #else
 #define USE_PUBSUBCLIENT
@@ -230,7 +250,7 @@ static WiFiSpiClass WiFi;
 #define PGM_P const char*
 #endif
 
-#if defined(WINDOWS)
+#if defined(WINDOWS) || defined(POSIX)
 #ifndef __FlashStringHelper
 #define __FlashStringHelper char
 #endif
@@ -248,21 +268,44 @@ static WiFiSpiClass WiFi;
 #endif
 #endif
 
-#ifdef WINDOWS
+#if defined(WINDOWS) || defined(POSIX)
 #include <string.h>
 #include <strings.h>
 #include <stdio.h>
+
+#if defined(WINDOWS)
 #include <Windows.h>
 #include <SDL2/SDL.h>
 
+#define delay Sleep
+#define millis SDL_GetTicks
+#define micros() (SDL_GetTicks() * 1000)
+#else
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+static inline uint32_t millis(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+static inline uint32_t micros(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+#define delay(ms) usleep((ms)*1000)
+#endif
+
 #define snprintf_P snprintf
 #define memcpy_P memcpy
 #define strcasecmp_P strcasecmp
 #define strcmp_P strcmp
 #define strstr_P strstr
 #define halRestartMcu()
-#define delay Sleep
-#define millis SDL_GetTicks
 
 #define DEC 10
 #define HEX 16
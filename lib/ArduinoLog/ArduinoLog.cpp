@@ -33,6 +33,75 @@ SOFTWARE.
 
     #include "ArduinoLog.h"
 
+    #if LOG_DEFERRED_SLOTS > 0 && !defined(DISABLE_LOGGING)
+        #if !defined(ARDUINO_ARCH_ESP8266)
+            #include <atomic>
+        #endif
+
+static_assert((LOG_DEFERRED_SLOTS & (LOG_DEFERRED_SLOTS - 1)) == 0, "LOG_DEFERRED_SLOTS must be a power of 2");
+
+        #define LOG_RECORD_DATA 48
+
+        #if defined(ARDUINO_ARCH_ESP8266)
+// Single core and log calls are not made from interrupts, plain variables are enough
+typedef volatile uint32_t log_index_t;
+static inline uint32_t logLoad(const log_index_t & index)
+{
+    return index;
+}
+static inline void logStore(log_index_t & index, uint32_t value)
+{
+    index = value;
+}
+static inline bool logClaim(log_index_t & head, uint32_t & expected)
+{
+    head = expected + 1;
+    return true;
+}
+static inline void logIncrement(log_index_t & counter)
+{
+    counter = counter + 1;
+}
+        #else
+// Log calls can come from other tasks, slots are claimed with a compare-and-swap on the head
+typedef std::atomic<uint32_t> log_index_t;
+static inline uint32_t logLoad(const log_index_t & index)
+{
+    return index.load(std::memory_order_acquire);
+}
+static inline void logStore(log_index_t & index, uint32_t value)
+{
+    index.store(value, std::memory_order_release);
+}
+static inline bool logClaim(log_index_t & head, uint32_t & expected)
+{
+    return head.compare_exchange_weak(expected, expected + 1, std::memory_order_relaxed);
+}
+static inline void logIncrement(log_index_t & counter)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+}
+        #endif
+
+struct LogRecord
+{
+    log_index_t seq;                    // claim index + 1 once the record is complete
+    uint32_t millis;                    // time of the log call
+    const __FlashStringHelper * format; // NULL when the format is stored as the first argument
+    uint8_t tag;
+    int8_t level;
+    uint8_t size;   // bytes used in data
+    bool truncated; // an argument did not fit, the following ones were not stored
+    uint8_t data[LOG_RECORD_DATA];
+};
+
+static LogRecord logRecords[LOG_DEFERRED_SLOTS];
+static log_index_t logHead(0);     // next slot to claim
+static log_index_t logTail(0);     // next slot to print, only advanced by drain()
+static log_index_t logOverflow(0); // log calls dropped while the ring was full
+static uint16_t logDepthMax = 0;   // approximate, updated without synchronization
+    #endif
+
 void Logging::begin(int level, bool showLevel)
 {
     #ifndef DISABLE_LOGGING
@@ -50,6 +119,9 @@ void Logging::registerOutput(uint8_t slot, Print * logOutput, int level, bool sh
     setLevel(slot, level);
     setShowLevel(slot, showLevel);
     _logOutput[slot] = logOutput;
+        #if LOG_DEFERRED_SLOTS > 0
+    updateDeferLevel();
+        #endif
     #endif
 }
 
@@ -58,6 +130,9 @@ void Logging::unregisterOutput(uint8_t slot)
     #ifndef DISABLE_LOGGING
     if(slot >= 3) return;
     _logOutput[slot] = NULL;
+        #if LOG_DEFERRED_SLOTS > 0
+    updateDeferLevel();
+        #endif
     #endif
 }
 
@@ -65,6 +140,9 @@ void Logging::setLevel(uint8_t slot, int level)
 {
     #ifndef DISABLE_LOGGING
     _level[slot] = constrain(level, LOG_LEVEL_SILENT, LOG_LEVEL_OUTPUT);
+        #if LOG_DEFERRED_SLOTS > 0
+    updateDeferLevel();
+        #endif
     #endif
 }
 
@@ -184,6 +262,294 @@ void Logging::printFormat(Print * logOutput, const char format, va_list * args)
     #endif
 }
 
+uint32_t Logging::getTimestamp() const
+{
+    #if LOG_DEFERRED_SLOTS > 0 && !defined(DISABLE_LOGGING)
+    if(_draining) return _timestamp;
+    #endif
+    return millis();
+}
+
+void Logging::setDeferred(bool deferred)
+{
+    #if LOG_DEFERRED_SLOTS > 0 && !defined(DISABLE_LOGGING)
+    if(!deferred) drain(LOG_DEFERRED_SLOTS); // print what is pending before switching
+    _deferred = deferred;
+    #endif
+}
+
+void Logging::getDeferredStats(LogDeferredStats * stats)
+{
+    #if LOG_DEFERRED_SLOTS > 0 && !defined(DISABLE_LOGGING)
+    uint32_t tail    = logLoad(logTail);
+    uint32_t head    = logLoad(logHead);
+    stats->captured  = head;
+    stats->overflow  = logLoad(logOverflow);
+    stats->depth     = head - tail;
+    stats->depth_max = logDepthMax;
+    #else
+    memset(stats, 0, sizeof(LogDeferredStats));
+    #endif
+}
+
+    #if LOG_DEFERRED_SLOTS > 0 && !defined(DISABLE_LOGGING)
+void Logging::updateDeferLevel()
+{
+    _deferLevel = LOG_LEVEL_SILENT;
+    for(int i = 0; i < 3; i++) {
+        if(_logOutput[i] != NULL && _level[i] > _deferLevel) _deferLevel = _level[i];
+    }
+}
+
+LogRecord * Logging::deferClaim(uint32_t & index, const __FlashStringHelper * format)
+{
+    index = logLoad(logHead);
+    do {
+        uint32_t depth = index - logLoad(logTail);
+        if(depth >= LOG_DEFERRED_SLOTS) {
+            logIncrement(logOverflow);
+            return NULL;
+        }
+        if(depth >= logDepthMax) logDepthMax = depth + 1;
+    } while(!logClaim(logHead, index));
+
+    LogRecord * record = &logRecords[index % LOG_DEFERRED_SLOTS];
+    record->millis     = millis();
+    record->format     = format;
+    record->size       = 0;
+    record->truncated  = false;
+    return record;
+}
+
+void Logging::deferCommit(LogRecord * record, uint32_t index, uint8_t tag, int level)
+{
+    record->tag   = tag;
+    record->level = level;
+    logStore(record->seq, index + 1); // publish the record to drain()
+}
+
+void Logging::deferValue(LogRecord * record, char type, uint32_t value)
+{
+    if(record->truncated) return;
+    if(record->size + 1 + sizeof(value) > LOG_RECORD_DATA) {
+        record->truncated = true;
+        return;
+    }
+    record->data[record->size] = type;
+    memcpy(record->data + record->size + 1, &value, sizeof(value));
+    record->size += 1 + sizeof(value);
+}
+
+void Logging::deferValue(LogRecord * record, char type, uint64_t value)
+{
+    if(record->truncated) return;
+    if(record->size + 1 + sizeof(value) > LOG_RECORD_DATA) {
+        record->truncated = true;
+        return;
+    }
+    record->data[record->size] = type;
+    memcpy(record->data + record->size + 1, &value, sizeof(value));
+    record->size += 1 + sizeof(value);
+}
+
+void Logging::deferArg(LogRecord * record, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    deferValue(record, 'f', bits);
+}
+
+void Logging::deferArg(LogRecord * record, const void * value)
+{
+    deferValue(record, 'p', (uint64_t)(uintptr_t)value);
+}
+
+void Logging::deferArg(LogRecord * record, const __FlashStringHelper * value)
+{
+    deferValue(record, 'S', (uint64_t)(uintptr_t)value);
+}
+
+// Strings are copied, a string cut to the space left in the record truncates the record
+void Logging::deferArg(LogRecord * record, const char * value)
+{
+    if(record->truncated) return;
+    if(record->size + 3 > LOG_RECORD_DATA) {
+        record->truncated = true;
+        return;
+    }
+    if(!value) value = "(null)";
+
+    size_t max = LOG_RECORD_DATA - record->size - 2;
+    size_t len = strnlen(value, max);
+    if(len == max) {
+        len--;
+        record->truncated = true;
+    }
+    record->data[record->size] = 's';
+    memcpy(record->data + record->size + 1, value, len);
+    record->data[record->size + 1 + len] = 0;
+    record->size += len + 2;
+}
+
+/* Walks the stored arguments of a record in order */
+struct LogReader
+{
+    const uint8_t * pos;
+    const uint8_t * end;
+    bool truncated; // the marker is still to be printed after the last stored argument
+
+    bool next(char & type, uint64_t & value, const char *& str)
+    {
+        if(pos >= end) return false;
+        type = *pos++;
+        if(type == 's') {
+            str = (const char *)pos;
+            pos += strlen(str) + 1;
+        } else if(type == 'i') {
+            uint32_t small;
+            memcpy(&small, pos, sizeof(small));
+            value = small;
+            pos += sizeof(small);
+        } else {
+            memcpy(&value, pos, sizeof(value));
+            pos += sizeof(value);
+        }
+        return true;
+    }
+};
+
+// Mark where the stored arguments of a truncated record end
+static void printTruncated(Print * logOutput, LogReader & reader)
+{
+    if(!reader.truncated || reader.pos < reader.end) return;
+    logOutput->print(F("\xE2\x80\xA6")); // ellipsis
+    reader.truncated = false;
+}
+
+static void printDeferredArg(Print * logOutput, const char format, LogReader & reader)
+{
+    char type;
+    uint64_t value  = 0;
+    const char * str = NULL;
+
+    if(format == '%') {
+        logOutput->print(format);
+        return;
+    }
+    if(!reader.next(type, value, str)) { // argument did not fit in the record
+        printTruncated(logOutput, reader);
+        return;
+    }
+
+    int32_t number = (int32_t)value;
+    if(format == 's' || format == 'S') {
+        /*Only stored strings and flash strings are used as pointers*/
+        if(type == 's')
+            logOutput->print(str);
+        else if(type == 'S')
+            logOutput->print((const __FlashStringHelper *)(uintptr_t)value);
+        else
+            logOutput->print('?');
+    } else if(format == 'd' || format == 'i') {
+        if(type == 'q')
+            logOutput->print((long)value, DEC);
+        else
+            logOutput->print(number, DEC);
+    } else if(format == 'u') {
+        logOutput->print((uint32_t)value, DEC);
+    } else if(format == 'D' || format == 'F') {
+        double d;
+        memcpy(&d, &value, sizeof(d));
+        logOutput->print(d);
+    } else if(format == 'x') {
+        logOutput->print(number, HEX);
+    } else if(format == 'X') {
+        logOutput->print("0x");
+        logOutput->print(number, HEX);
+    } else if(format == 'b') {
+        logOutput->print(number, BIN);
+    } else if(format == 'B') {
+        logOutput->print("0b");
+        logOutput->print(number, BIN);
+    } else if(format == 'l') {
+        logOutput->print((long)value, DEC);
+    } else if(format == 'c') {
+        logOutput->print((char)number);
+    } else if(format == 't') {
+        logOutput->print(number == 1 ? "T" : "F");
+    } else if(format == 'T') {
+        logOutput->print(number == 1 ? F("true") : F("false"));
+    }
+    printTruncated(logOutput, reader);
+}
+
+void Logging::printRecord(LogRecord * record)
+{
+    for(int i = 0; i < 3; i++) {
+        if(_logOutput[i] == NULL || record->level > _level[i]) continue;
+
+        if(_prefix != NULL) {
+            _prefix(record->tag, record->level, _logOutput[i]);
+        }
+
+        LogReader reader = {record->data, record->data + record->size, record->truncated};
+        if(record->format) {
+            PGM_P p = reinterpret_cast<PGM_P>(record->format);
+            char c  = pgm_read_byte(p++);
+            for(; c != 0; c = pgm_read_byte(p++)) {
+                if(c == '%') {
+                    c = pgm_read_byte(p++);
+                    printDeferredArg(_logOutput[i], c, reader);
+                } else {
+                    _logOutput[i]->print(c);
+                }
+            }
+        } else {
+            char type;
+            uint64_t value;
+            const char * format = "";
+            reader.next(type, value, format); // the format is the first stored string
+            for(; *format != 0; ++format) {
+                if(*format == '%') {
+                    ++format;
+                    printDeferredArg(_logOutput[i], *format, reader);
+                } else {
+                    _logOutput[i]->print(*format);
+                }
+            }
+        }
+        printTruncated(_logOutput[i], reader);
+
+        if(_suffix != NULL) {
+            _suffix(record->tag, record->level, _logOutput[i]);
+        }
+    }
+}
+    #endif
+
+uint16_t Logging::drain(uint16_t budget)
+{
+    uint16_t count = 0;
+    #if LOG_DEFERRED_SLOTS > 0 && !defined(DISABLE_LOGGING)
+    if(_draining) return 0; // a prefix or output that logs itself
+    _draining = true;
+
+    while(count < budget) {
+        uint32_t tail      = logLoad(logTail);
+        LogRecord * record = &logRecords[tail % LOG_DEFERRED_SLOTS];
+        if(logLoad(record->seq) != tail + 1) break; // empty, or still being written
+
+        _timestamp = record->millis;
+        printRecord(record);
+        logStore(logTail, tail + 1); // release the slot
+        count++;
+    }
+
+    _draining = false;
+    #endif
+    return count;
+}
+
 Logging Log = Logging();
 
 #endif // ARDUINO
\ No newline at end of file
@@ -22,6 +22,7 @@ Licensed under the MIT License <http://opensource.org/licenses/MIT>.
 #include "WProgram.h"
 #endif
 //#include "StringStream.h"
+#include <type_traits>
 typedef void (*printfunction)(uint8_t tag, int level, Print*);
 
 //#include <stdint.h>
@@ -31,6 +32,15 @@ typedef void (*printfunction)(uint8_t tag, int level, Print*);
 // ************************************************************************
 //#define DISABLE_LOGGING
 
+// *************************************************************************
+//  Set LOG_DEFERRED_SLOTS to a power of 2 to compile in the deferred mode:
+//  log calls then only store their arguments in a ring of this many records
+//  and the lines are formatted and printed later by drain()
+// ************************************************************************
+#ifndef LOG_DEFERRED_SLOTS
+#define LOG_DEFERRED_SLOTS 0
+#endif
+
 #define LOG_LEVEL_SILENT -1
 
 #define LOG_LEVEL_FATAL 0
@@ -85,6 +95,19 @@ typedef void (*printfunction)(uint8_t tag, int level, Print*);
  * 7 - LOG_LEVEL_DEBUG      all
  */
 
+struct LogRecord;
+
+/**
+ * Counters of the deferred log ring
+ */
+struct LogDeferredStats
+{
+    uint32_t captured; // records stored in the ring
+    uint32_t overflow; // log calls dropped because the ring was full
+    uint16_t depth;    // records waiting to be printed
+    uint16_t depth_max;
+};
+
 class Logging {
   public:
     /**
@@ -188,7 +211,7 @@ class Logging {
     template <class T, typename... Args> void fatal(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_FATAL, msg, args...);
+        logLevel(tag, LOG_LEVEL_FATAL, msg, args...);
 #endif
     }
 
@@ -205,7 +228,7 @@ class Logging {
     template <class T, typename... Args> void error(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_ERROR, msg, args...);
+        logLevel(tag, LOG_LEVEL_ERROR, msg, args...);
 #endif
     }
 
@@ -222,7 +245,7 @@ class Logging {
     template <class T, typename... Args> void warning(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_WARNING, msg, args...);
+        logLevel(tag, LOG_LEVEL_WARNING, msg, args...);
 #endif
     }
 
@@ -239,7 +262,7 @@ class Logging {
     template <class T, typename... Args> void notice(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_NOTICE, msg, args...);
+        logLevel(tag, LOG_LEVEL_NOTICE, msg, args...);
 #endif
     }
 
@@ -256,7 +279,7 @@ class Logging {
     template <class T, typename... Args> void trace(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_TRACE, msg, args...);
+        logLevel(tag, LOG_LEVEL_TRACE, msg, args...);
 #endif
     }
 
@@ -273,7 +296,7 @@ class Logging {
     template <class T, typename... Args> void verbose(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_VERBOSE, msg, args...);
+        logLevel(tag, LOG_LEVEL_VERBOSE, msg, args...);
 #endif
     }
 
@@ -290,7 +313,7 @@ class Logging {
     template <class T, typename... Args> void debug(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_DEBUG, msg, args...);
+        logLevel(tag, LOG_LEVEL_DEBUG, msg, args...);
 #endif
     }
 
@@ -306,11 +329,109 @@ class Logging {
     template <class T, typename... Args> void output(uint8_t tag, T msg, Args... args)
     {
 #ifndef DISABLE_LOGGING
-        printLevel(tag, LOG_LEVEL_OUTPUT, msg, args...);
+        logLevel(tag, LOG_LEVEL_OUTPUT, msg, args...);
 #endif
     }
 
+    /**
+     * Switch between printing log lines immediately and storing them in the deferred ring.
+     * Fatal messages are always printed immediately, after the ring has been drained.
+     *
+     * \param deferred - true to store log calls and print them from drain()
+     * \return void
+     */
+    void setDeferred(bool deferred);
+
+    /**
+     * Format and print the oldest deferred log records
+     *
+     * \param budget - maximum number of records to print
+     * \return number of records printed
+     */
+    uint16_t drain(uint16_t budget);
+
+    /**
+     * Get the counters of the deferred log ring
+     *
+     * \param stats - receives the counters
+     * \return void
+     */
+    void getDeferredStats(LogDeferredStats* stats);
+
+    /**
+     * Get the time the current log line was issued, for use in the prefix function.
+     *
+     * \return millis() when the log call was made
+     */
+    uint32_t getTimestamp() const;
+
   private:
+    template <class T, typename... Args> void logLevel(uint8_t tag, int level, T msg, Args... args)
+    {
+#if LOG_DEFERRED_SLOTS > 0
+        if(_deferred) {
+            if(level > _deferLevel) return;
+            if(level != LOG_LEVEL_FATAL) {
+                defer(tag, level, msg, args...);
+                return;
+            }
+            drain(LOG_DEFERRED_SLOTS); // keep the order before halting
+        }
+#endif
+        printLevel(tag, level, msg, args...);
+    }
+
+#if LOG_DEFERRED_SLOTS > 0
+    template <typename... Args> void defer(uint8_t tag, int level, const __FlashStringHelper* msg, Args... args)
+    {
+        uint32_t index;
+        LogRecord* record = deferClaim(index, msg);
+        if(!record) return;
+        deferArgs(record, args...);
+        deferCommit(record, index, tag, level);
+    }
+
+    // Formats in RAM may live on the stack of the caller, they are copied into the record
+    template <typename... Args> void defer(uint8_t tag, int level, const char* msg, Args... args)
+    {
+        uint32_t index;
+        LogRecord* record = deferClaim(index, NULL);
+        if(!record) return;
+        deferArg(record, msg);
+        deferArgs(record, args...);
+        deferCommit(record, index, tag, level);
+    }
+
+    void deferArgs(LogRecord*)
+    {}
+    template <class A, typename... Args> void deferArgs(LogRecord* record, A arg, Args... args)
+    {
+        deferArg(record, arg);
+        deferArgs(record, args...);
+    }
+
+    template <class A>
+    typename std::enable_if<std::is_integral<A>::value || std::is_enum<A>::value>::type deferArg(LogRecord* record,
+                                                                                                 A value)
+    {
+        if(sizeof(A) > sizeof(uint32_t))
+            deferValue(record, 'q', (uint64_t)value);
+        else
+            deferValue(record, 'i', (uint32_t)value);
+    }
+    void deferArg(LogRecord* record, const char* value);
+    void deferArg(LogRecord* record, const __FlashStringHelper* value);
+    void deferArg(LogRecord* record, const void* value);
+    void deferArg(LogRecord* record, double value);
+    void deferValue(LogRecord* record, char type, uint32_t value);
+    void deferValue(LogRecord* record, char type, uint64_t value);
+
+    LogRecord* deferClaim(uint32_t& index, const __FlashStringHelper* format);
+    void deferCommit(LogRecord* record, uint32_t index, uint8_t tag, int level);
+    void printRecord(LogRecord* record);
+    void updateDeferLevel();
+#endif
+
     void print(Print* logOutput, const char* format, va_list args);
 
     void print(Print* logOutput, const __FlashStringHelper* format, va_list args);
@@ -347,6 +468,13 @@ class Logging {
 
     printfunction _prefix = NULL;
     printfunction _suffix = NULL;
+
+#if LOG_DEFERRED_SLOTS > 0
+    bool _deferred      = false;
+    bool _draining      = false;
+    int _deferLevel     = LOG_LEVEL_SILENT; // highest level of the registered outputs
+    uint32_t _timestamp = 0;                // issue time of the record being drained
+#endif
 #endif
 };
 
@@ -0,0 +1,564 @@
+/**
+ * @file lv_fs_cache.c
+ *
+ * Handle pool and read-ahead cache shared by the lv_fs_if drivers.
+ * Files opened for reading stay open after lv_fs_close, a later open of the same path reuses the handle.
+ * Reads smaller than a block are served from blocks read ahead from the file, least recently used blocks
+ * are replaced first. Files opened for writing are never pooled and drop the pooled copy of the same path.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_cache.h"
+
+#if LV_USE_FS_IF
+
+#include <stdlib.h>
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define LV_FS_CACHE_BACKENDS 3 /*fatfs, pc and spiffs*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* An open file of the underlying driver */
+typedef struct
+{
+    const lv_fs_drv_t * native; /*callbacks of the underlying driver*/
+    void * file;                /*file handle of the underlying driver*/
+    uint32_t size;
+    uint32_t pos;       /*position of the underlying file handle*/
+    uint32_t last_used; /*tick of the last open, for eviction*/
+    uint8_t refs;       /*lv_fs files using the handle*/
+    bool pooled;        /*part of the pool, only read from*/
+    bool stale;         /*the file changed while in use, close once released*/
+    char path[LV_FS_CACHE_PATH_LEN];
+} lv_fs_cache_handle_t;
+
+/* The file_t of the cached drivers, what lv_fs allocates per open file */
+typedef struct
+{
+    lv_fs_cache_handle_t * handle;
+    uint32_t pos; /*read position of this lv_fs file*/
+} lv_fs_cache_file_t;
+
+typedef struct
+{
+    lv_fs_cache_handle_t * handle; /*NULL if the block is free*/
+    uint32_t index;                /*block number in the file*/
+    uint32_t len;                  /*valid bytes, less than a block at the end of the file*/
+    uint32_t last_used;
+    uint8_t * data;
+} lv_fs_cache_block_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static lv_fs_res_t fs_open(lv_fs_drv_t * drv, void * file_p, const char * path, lv_fs_mode_t mode);
+static lv_fs_res_t fs_close(lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br);
+static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw);
+static lv_fs_res_t fs_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos);
+static lv_fs_res_t fs_size(lv_fs_drv_t * drv, void * file_p, uint32_t * size_p);
+static lv_fs_res_t fs_tell(lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p);
+static lv_fs_res_t fs_remove(lv_fs_drv_t * drv, const char * path);
+static lv_fs_res_t fs_trunc(lv_fs_drv_t * drv, void * file_p);
+static lv_fs_res_t fs_rename(lv_fs_drv_t * drv, const char * oldname, const char * newname);
+static const char * real_path(const char * path);
+static void blocks_drop(const lv_fs_cache_handle_t * handle);
+static void handle_close(lv_fs_cache_handle_t * handle);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_fs_drv_t backends[LV_FS_CACHE_BACKENDS];
+static uint8_t backend_count;
+
+static lv_fs_cache_handle_t handles[LV_FS_CACHE_HANDLES];
+#if LV_FS_CACHE_BLOCK_COUNT > 0
+static lv_fs_cache_block_t blocks[LV_FS_CACHE_BLOCK_COUNT];
+#endif
+
+static lv_fs_cache_info_t cache_info;
+static uint32_t cache_tick;
+static bool cache_enabled = true;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_fs_cache_register(lv_fs_drv_t * drv)
+{
+    if(backend_count >= LV_FS_CACHE_BACKENDS) {
+        lv_fs_drv_register(drv); /*Not cached*/
+        return;
+    }
+
+    backends[backend_count++] = *drv;
+
+    drv->file_size = sizeof(lv_fs_cache_file_t);
+    drv->open_cb   = fs_open;
+    drv->close_cb  = fs_close;
+    drv->read_cb   = drv->read_cb ? fs_read : NULL;
+    drv->write_cb  = drv->write_cb ? fs_write : NULL;
+    drv->seek_cb   = drv->seek_cb ? fs_seek : NULL;
+    drv->tell_cb   = drv->tell_cb ? fs_tell : NULL;
+    drv->size_cb   = drv->size_cb ? fs_size : NULL;
+    drv->trunc_cb  = drv->trunc_cb ? fs_trunc : NULL;
+    drv->remove_cb = drv->remove_cb ? fs_remove : NULL;
+    drv->rename_cb = drv->rename_cb ? fs_rename : NULL;
+
+    lv_fs_drv_register(drv);
+}
+
+void lv_fs_cache_enable(bool enable)
+{
+    cache_enabled = enable;
+    if(!enable) lv_fs_cache_invalidate(NULL);
+}
+
+void lv_fs_cache_invalidate(const char * path)
+{
+    if(path) path = real_path(path);
+
+    for(uint8_t i = 0; i < LV_FS_CACHE_HANDLES; i++) {
+        lv_fs_cache_handle_t * handle = &handles[i];
+        if(!handle->file || (path && strcmp(handle->path, path))) continue;
+
+        if(handle->refs == 0) {
+            handle_close(handle);
+        } else {
+            blocks_drop(handle);
+            handle->stale = true;
+        }
+    }
+}
+
+void lv_fs_cache_info(lv_fs_cache_info_t * info)
+{
+    cache_info.open = 0;
+    for(uint8_t i = 0; i < LV_FS_CACHE_HANDLES; i++) {
+        if(handles[i].file) cache_info.open++;
+    }
+    *info = cache_info;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static const lv_fs_drv_t * native_drv(const lv_fs_drv_t * drv)
+{
+    for(uint8_t i = 0; i < backend_count; i++) {
+        if(backends[i].letter == drv->letter) return &backends[i];
+    }
+    return NULL;
+}
+
+/* Strip the driver letter and the leading slash, like lv_fs does before calling the driver */
+static const char * real_path(const char * path)
+{
+    if(path[0] != '\0' && path[1] == ':') path += 2;
+    while(*path == '/' || *path == '\\') path++;
+    return path;
+}
+
+/* ===== Blocks ===== */
+
+static void blocks_drop(const lv_fs_cache_handle_t * handle)
+{
+#if LV_FS_CACHE_BLOCK_COUNT > 0
+    for(uint8_t i = 0; i < LV_FS_CACHE_BLOCK_COUNT; i++) {
+        if(blocks[i].handle == handle) blocks[i].handle = NULL;
+    }
+#endif
+}
+
+#if LV_FS_CACHE_BLOCK_COUNT > 0
+/* Move the underlying file handle and read from it */
+static lv_fs_res_t native_read(lv_fs_drv_t * drv, lv_fs_cache_handle_t * handle, uint32_t pos, void * buf,
+                               uint32_t btr, uint32_t * br)
+{
+    lv_fs_res_t res;
+    if(handle->pos != pos) {
+        res = handle->native->seek_cb(drv, handle->file, pos);
+        if(res != LV_FS_RES_OK) return res;
+        handle->pos = pos;
+    }
+
+    res = handle->native->read_cb(drv, handle->file, buf, btr, br);
+    if(res == LV_FS_RES_OK)
+        handle->pos += *br;
+    else
+        handle->pos = UINT32_MAX; /*Unknown, seek before the next read*/
+    return res;
+}
+
+/* Find a block of a pooled file, read it from the file on a miss */
+static lv_fs_cache_block_t * block_get(lv_fs_drv_t * drv, lv_fs_cache_handle_t * handle, uint32_t index)
+{
+    lv_fs_cache_block_t * victim = &blocks[0];
+
+    for(uint8_t i = 0; i < LV_FS_CACHE_BLOCK_COUNT; i++) {
+        lv_fs_cache_block_t * block = &blocks[i];
+        if(block->handle == handle && block->index == index) {
+            block->last_used = ++cache_tick;
+            cache_info.block_hits++;
+            return block;
+        }
+        if(victim->handle && (!block->handle || block->last_used < victim->last_used)) victim = block;
+    }
+
+    if(victim->handle) cache_info.evictions++;
+    victim->handle = NULL;
+
+    if(!victim->data) {
+        victim->data = malloc(LV_FS_CACHE_BLOCK_SIZE);
+        if(!victim->data) return NULL;
+    }
+
+    uint32_t len;
+    if(native_read(drv, handle, index * LV_FS_CACHE_BLOCK_SIZE, victim->data, LV_FS_CACHE_BLOCK_SIZE, &len) !=
+       LV_FS_RES_OK)
+        return NULL;
+
+    victim->handle    = handle;
+    victim->index     = index;
+    victim->len       = len;
+    victim->last_used = ++cache_tick;
+    cache_info.block_misses++;
+    return victim;
+}
+#endif
+
+/* ===== Handles ===== */
+
+static void handle_close(lv_fs_cache_handle_t * handle)
+{
+    blocks_drop(handle);
+    handle->native->close_cb((lv_fs_drv_t *)handle->native, handle->file);
+    lv_mem_free(handle->file);
+    handle->file  = NULL;
+    handle->stale = false;
+    if(!handle->pooled) lv_mem_free(handle);
+}
+
+/* Open a file of the underlying driver into a handle */
+static lv_fs_res_t handle_open(lv_fs_drv_t * drv, const lv_fs_drv_t * native, lv_fs_cache_handle_t * handle,
+                               const char * path, lv_fs_mode_t mode)
+{
+    handle->file = lv_mem_alloc(native->file_size);
+    if(!handle->file) return LV_FS_RES_OUT_OF_MEM;
+    _lv_memset_00(handle->file, native->file_size); /*lv_mem_alloc might be dirty*/
+
+    lv_fs_res_t res = native->open_cb(drv, handle->file, path, mode);
+    if(res != LV_FS_RES_OK) {
+        lv_mem_free(handle->file);
+        handle->file = NULL;
+        return res;
+    }
+
+    handle->native = native;
+    handle->pos    = 0;
+    handle->size   = 0;
+    if(handle->pooled && native->size_cb) native->size_cb(drv, handle->file, &handle->size);
+    cache_info.handle_misses++;
+    return LV_FS_RES_OK;
+}
+
+/* Find an idle slot of the pool, closing the least recently used file if needed */
+static lv_fs_cache_handle_t * handle_slot(void)
+{
+    lv_fs_cache_handle_t * victim = NULL;
+
+    for(uint8_t i = 0; i < LV_FS_CACHE_HANDLES; i++) {
+        lv_fs_cache_handle_t * handle = &handles[i];
+        if(!handle->file) return handle;
+        if(handle->refs == 0 && (!victim || handle->last_used < victim->last_used)) victim = handle;
+    }
+
+    if(victim) {
+        cache_info.evictions++;
+        handle_close(victim);
+    }
+    return victim;
+}
+
+static void handle_release(lv_fs_cache_handle_t * handle)
+{
+    if(handle->refs > 0) handle->refs--;
+    if(!handle->pooled || (handle->stale && handle->refs == 0)) handle_close(handle);
+}
+
+/**
+ * Open a file
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @param path path to the file without the driver letter
+ * @param mode read: FS_MODE_RD, write: FS_MODE_WR, both: FS_MODE_RD | FS_MODE_WR
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_open(lv_fs_drv_t * drv, void * file_p, const char * path, lv_fs_mode_t mode)
+{
+    const lv_fs_drv_t * native = native_drv(drv);
+    lv_fs_cache_file_t * fp    = (lv_fs_cache_file_t *)file_p;
+    if(!native || !fp) return LV_FS_RES_INV_PARAM;
+
+    fp->pos    = 0;
+    fp->handle = NULL;
+
+    bool poolable = cache_enabled && mode == LV_FS_MODE_RD && strlen(path) < LV_FS_CACHE_PATH_LEN &&
+                    native->seek_cb && native->read_cb;
+
+    if(poolable) {
+        for(uint8_t i = 0; i < LV_FS_CACHE_HANDLES; i++) {
+            lv_fs_cache_handle_t * handle = &handles[i];
+            if(handle->file && !handle->stale && handle->native == native && !strcmp(handle->path, path)) {
+                handle->refs++;
+                handle->last_used = ++cache_tick;
+                cache_info.handle_hits++;
+                fp->handle = handle;
+                return LV_FS_RES_OK;
+            }
+        }
+
+        lv_fs_cache_handle_t * handle = handle_slot();
+        if(handle) {
+            handle->pooled  = true;
+            lv_fs_res_t res = handle_open(drv, native, handle, path, mode);
+            if(res != LV_FS_RES_OK) return res;
+
+            strcpy(handle->path, path);
+            handle->refs      = 1;
+            handle->last_used = ++cache_tick;
+            fp->handle        = handle;
+            return LV_FS_RES_OK;
+        }
+    } else if(mode & LV_FS_MODE_WR) {
+        lv_fs_cache_invalidate(path);
+    }
+
+    /* Not pooled, all calls go to the underlying driver */
+    lv_fs_cache_handle_t * handle = lv_mem_alloc(sizeof(lv_fs_cache_handle_t));
+    if(!handle) return LV_FS_RES_OUT_OF_MEM;
+    _lv_memset_00(handle, sizeof(lv_fs_cache_handle_t)); /*lv_mem_alloc might be dirty*/
+
+    lv_fs_res_t res = handle_open(drv, native, handle, path, mode);
+    if(res != LV_FS_RES_OK) {
+        lv_mem_free(handle);
+        return res;
+    }
+
+    handle->refs = 1;
+    fp->handle   = handle;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Close an opened file, a pooled file stays open for the next lv_fs_open
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_close(lv_fs_drv_t * drv, void * file_p)
+{
+    lv_fs_cache_file_t * fp = (lv_fs_cache_file_t *)file_p;
+    if(!fp->handle) return LV_FS_RES_INV_PARAM;
+
+    handle_release(fp->handle);
+    fp->handle = NULL;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Read data from an opened file, small reads of a pooled file are served from the read-ahead blocks
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @param buf pointer to a memory block where to store the read data
+ * @param btr number of Bytes To Read
+ * @param br the real number of read bytes (Byte Read)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    lv_fs_cache_file_t * fp        = (lv_fs_cache_file_t *)file_p;
+    lv_fs_cache_handle_t * handle = fp->handle;
+    if(!handle) return LV_FS_RES_INV_PARAM;
+
+    if(!handle->pooled) return handle->native->read_cb(drv, handle->file, buf, btr, br);
+
+    uint8_t * dest = (uint8_t *)buf;
+    *br            = 0;
+    if(fp->pos >= handle->size) return LV_FS_RES_OK;
+    if(btr > handle->size - fp->pos) btr = handle->size - fp->pos;
+
+#if LV_FS_CACHE_BLOCK_COUNT > 0
+    while(btr > 0) {
+        uint32_t offset = fp->pos % LV_FS_CACHE_BLOCK_SIZE;
+        uint32_t len;
+
+        if(offset == 0 && btr >= LV_FS_CACHE_BLOCK_SIZE) {
+            /* Whole blocks are read straight into the destination */
+            lv_fs_res_t res = native_read(drv, handle, fp->pos, dest, btr - btr % LV_FS_CACHE_BLOCK_SIZE, &len);
+            if(res != LV_FS_RES_OK) return res;
+            cache_info.bypassed++;
+
+        } else {
+            lv_fs_cache_block_t * block = block_get(drv, handle, fp->pos / LV_FS_CACHE_BLOCK_SIZE);
+            if(!block) return *br > 0 ? LV_FS_RES_OK : LV_FS_RES_HW_ERR;
+
+            len = block->len > offset ? block->len - offset : 0;
+            if(len > btr) len = btr;
+            memcpy(dest, block->data + offset, len);
+        }
+
+        if(len == 0) break; /*End of file*/
+        dest += len;
+        btr -= len;
+        fp->pos += len;
+        *br += len;
+    }
+    return LV_FS_RES_OK;
+
+#else
+    lv_fs_res_t res;
+    if(handle->pos != fp->pos) {
+        res = handle->native->seek_cb(drv, handle->file, fp->pos);
+        if(res != LV_FS_RES_OK) return res;
+    }
+    res = handle->native->read_cb(drv, handle->file, dest, btr, br);
+    if(res == LV_FS_RES_OK) fp->pos += *br;
+    handle->pos = res == LV_FS_RES_OK ? fp->pos : UINT32_MAX; /*Unknown, seek before the next read*/
+    return res;
+#endif
+}
+
+/**
+ * Write into a file, files opened for writing are never pooled
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @param buf pointer to a buffer with the bytes to write
+ * @param btw Bytes To Write
+ * @param bw the number of real written bytes (Bytes Written)
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
+{
+    lv_fs_cache_file_t * fp = (lv_fs_cache_file_t *)file_p;
+    if(!fp->handle) return LV_FS_RES_INV_PARAM;
+    if(fp->handle->pooled) return LV_FS_RES_DENIED;
+
+    return fp->handle->native->write_cb(drv, fp->handle->file, buf, btw, bw);
+}
+
+/**
+ * Set the read write pointer, pooled files only move their own position
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @param pos the new position of read write pointer
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos)
+{
+    lv_fs_cache_file_t * fp = (lv_fs_cache_file_t *)file_p;
+    if(!fp->handle) return LV_FS_RES_INV_PARAM;
+
+    if(!fp->handle->pooled) return fp->handle->native->seek_cb(drv, fp->handle->file, pos);
+
+    fp->pos = pos;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the size of a file bytes
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @param size_p pointer to a variable to store the size
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_size(lv_fs_drv_t * drv, void * file_p, uint32_t * size_p)
+{
+    lv_fs_cache_file_t * fp = (lv_fs_cache_file_t *)file_p;
+    if(!fp->handle) return LV_FS_RES_INV_PARAM;
+
+    if(!fp->handle->pooled) return fp->handle->native->size_cb(drv, fp->handle->file, size_p);
+
+    *size_p = fp->handle->size;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Give the position of the read write pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @param pos_p pointer to to store the result
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_tell(lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
+{
+    lv_fs_cache_file_t * fp = (lv_fs_cache_file_t *)file_p;
+    if(!fp->handle) return LV_FS_RES_INV_PARAM;
+
+    if(!fp->handle->pooled) return fp->handle->native->tell_cb(drv, fp->handle->file, pos_p);
+
+    *pos_p = fp->pos;
+    return LV_FS_RES_OK;
+}
+
+/**
+ * Truncate the file size to the current position of the read write pointer
+ * @param drv pointer to a driver where this function belongs
+ * @param file_p pointer to a lv_fs_cache_file_t variable
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_trunc(lv_fs_drv_t * drv, void * file_p)
+{
+    lv_fs_cache_file_t * fp = (lv_fs_cache_file_t *)file_p;
+    if(!fp->handle) return LV_FS_RES_INV_PARAM;
+    if(fp->handle->pooled) return LV_FS_RES_DENIED;
+
+    return fp->handle->native->trunc_cb(drv, fp->handle->file);
+}
+
+/**
+ * Delete a file
+ * @param drv pointer to a driver where this function belongs
+ * @param path path of the file to delete
+ * @return LV_FS_RES_OK or any error from lv_fs_res_t enum
+ */
+static lv_fs_res_t fs_remove(lv_fs_drv_t * drv, const char * path)
+{
+    const lv_fs_drv_t * native = native_drv(drv);
+    if(!native) return LV_FS_RES_INV_PARAM;
+
+    lv_fs_cache_invalidate(path);
+    return native->remove_cb(drv, path);
+}
+
+/**
+ * Rename a file
+ * @param drv pointer to a driver where this function belongs
+ * @param oldname path to the file
+ * @param newname path with the new name
+ * @return LV_FS_RES_OK or any error from 'fs_res_t'
+ */
+static lv_fs_res_t fs_rename(lv_fs_drv_t * drv, const char * oldname, const char * newname)
+{
+    const lv_fs_drv_t * native = native_drv(drv);
+    if(!native) return LV_FS_RES_INV_PARAM;
+
+    lv_fs_cache_invalidate(oldname);
+    lv_fs_cache_invalidate(newname);
+    return native->rename_cb(drv, oldname, newname);
+}
+
+#endif /*LV_USE_FS_IF*/
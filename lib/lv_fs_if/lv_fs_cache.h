@@ -0,0 +1,91 @@
+/**
+ * @file lv_fs_cache.h
+ *
+ */
+
+#ifndef LV_FS_CACHE_H
+#define LV_FS_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_fs_if.h"
+
+#if LV_USE_FS_IF
+
+/*********************
+ *      DEFINES
+ *********************/
+#ifndef LV_FS_CACHE_HANDLES
+#define LV_FS_CACHE_HANDLES 4 /*Files kept open between lv_fs_open calls*/
+#endif
+
+#ifndef LV_FS_CACHE_BLOCK_SIZE
+#define LV_FS_CACHE_BLOCK_SIZE 512 /*Bytes read ahead at once*/
+#endif
+
+#ifndef LV_FS_CACHE_BLOCK_COUNT
+#if defined(ARDUINO_ARCH_ESP8266)
+#define LV_FS_CACHE_BLOCK_COUNT 4 /*Blocks shared by all pooled files, 0 disables the read-ahead*/
+#else
+#define LV_FS_CACHE_BLOCK_COUNT 16 /*Blocks shared by all pooled files, 0 disables the read-ahead*/
+#endif
+#endif
+
+#ifndef LV_FS_CACHE_PATH_LEN
+#define LV_FS_CACHE_PATH_LEN 32 /*Longer paths are opened without pooling*/
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+{
+    uint32_t handle_hits;   /*opens served by a pooled handle*/
+    uint32_t handle_misses; /*opens passed to the file system*/
+    uint32_t block_hits;    /*block reads served from the cache*/
+    uint32_t block_misses;  /*blocks read from the file system*/
+    uint32_t bypassed;      /*reads of whole blocks passed to the file system*/
+    uint32_t evictions;     /*handles and blocks dropped to make room*/
+    uint8_t open;           /*pooled handles holding an open file*/
+} lv_fs_cache_info_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Register a file system driver behind the handle pool and the read-ahead cache.
+ * Use instead of `lv_fs_drv_register`, the directory callbacks are left untouched.
+ * @param drv pointer to an initialized driver
+ */
+void lv_fs_cache_register(lv_fs_drv_t * drv);
+
+/**
+ * Drop the pooled handle and the cached blocks of a file changed outside of lv_fs
+ * @param path path of the file, with or without the driver letter, NULL for all files
+ */
+void lv_fs_cache_invalidate(const char * path);
+
+/**
+ * Enable or disable pooling, files opened while disabled go straight to the file system
+ */
+void lv_fs_cache_enable(bool enable);
+
+void lv_fs_cache_info(lv_fs_cache_info_t * info);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#endif /*LV_USE_FS_IF*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_FS_CACHE_H*/
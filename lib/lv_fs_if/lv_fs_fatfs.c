@@ -7,6 +7,7 @@
  *      INCLUDES
  *********************/
 #include "lv_fs_if.h"
+#include "lv_fs_cache.h"
 
 #if LV_USE_FS_IF
 #if LV_FS_IF_FATFS != '\0'
@@ -93,7 +94,7 @@ void lv_fs_if_fatfs_init(void)
     fs_drv.dir_open_cb = fs_dir_open;
     fs_drv.dir_read_cb = fs_dir_read;
 
-    lv_fs_drv_register(&fs_drv);
+    lv_fs_cache_register(&fs_drv);
 }
 
 /**********************
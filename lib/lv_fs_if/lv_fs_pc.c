@@ -7,6 +7,7 @@
  *      INCLUDES
  *********************/
 #include "lv_fs_if.h"
+#include "lv_fs_cache.h"
 #if LV_USE_FS_IF
 #if LV_FS_IF_PC != '\0'
 
@@ -110,7 +111,7 @@ void lv_fs_if_pc_init(void)
     fs_drv.dir_open_cb  = fs_dir_open;
     fs_drv.dir_read_cb  = fs_dir_read;
 
-    lv_fs_drv_register(&fs_drv);
+    lv_fs_cache_register(&fs_drv);
 }
 
 /**********************
@@ -144,7 +145,6 @@ static lv_fs_res_t fs_open(lv_fs_drv_t* drv, void* file_p, const char* path, lv_
 #ifndef WIN32
     char buf[256];
     sprintf(buf, LV_FS_PC_PATH "/%s", path);
-    printf("%s\n", buf);
 #else
     char buf[256];
     sprintf(buf, LV_FS_PC_PATH "\\%s", path);
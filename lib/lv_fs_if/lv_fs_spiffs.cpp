@@ -11,6 +11,7 @@
 #include <Arduino.h>
 #include "lv_fs_if.h"
 #include "lv_fs_spiffs.h"
+#include "lv_fs_cache.h"
 #include "ArduinoLog.h"
 
 #if LV_USE_FS_IF
@@ -123,7 +124,7 @@ void lv_fs_if_spiffs_init(void)
     fs_drv.dir_open_cb  = fs_dir_open;
     fs_drv.dir_read_cb  = fs_dir_read;
 
-    lv_fs_drv_register(&fs_drv);
+    lv_fs_cache_register(&fs_drv);
 }
 
 /**********************
@@ -223,7 +224,7 @@ static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_
     lv_spiffs_file_t * fp = (lv_spiffs_file_t *)file_p;
     if(fp == NULL) return LV_FS_RES_INV_PARAM;
 
-    lv_spiffs_file_t file = *fp;
+    lv_spiffs_file_t & file = *fp;
 
     if(!file) {
         LOG_ERROR(TAG_LVFS, F("Invalid file"));
@@ -243,7 +244,6 @@ static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_
         else
             LOG_VERBOSE(TAG_LVFS, F("BYTESREAD is NULL"), btr, file.name(), file.position());
 
-        Serial.print("!");
         return LV_FS_RES_OK;
     }
 }
@@ -260,8 +260,7 @@ static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
 {
     (void)drv; /*Unused*/
-    lv_spiffs_file_t file = *(lv_spiffs_file_t *)file_p;
-    // File file           = fp;
+    lv_spiffs_file_t & file = *(lv_spiffs_file_t *)file_p;
 
     if(!file) {
         // LOG_VERBOSE(TAG_LVFS,F("Invalid file"));
@@ -284,8 +283,7 @@ static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf,
 static lv_fs_res_t fs_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos)
 {
     (void)drv; /*Unused*/
-    lv_spiffs_file_t file = *(lv_spiffs_file_t *)file_p;
-    // File file           = fp;
+    lv_spiffs_file_t & file = *(lv_spiffs_file_t *)file_p;
 
     if(!file) {
         // LOG_VERBOSE(TAG_LVFS,F("Invalid file"));
@@ -307,8 +305,7 @@ static lv_fs_res_t fs_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos)
 static lv_fs_res_t fs_size(lv_fs_drv_t * drv, void * file_p, uint32_t * size_p)
 {
     (void)drv; /*Unused*/
-    lv_spiffs_file_t file = *(lv_spiffs_file_t *)file_p;
-    // File file           = fp;
+    lv_spiffs_file_t & file = *(lv_spiffs_file_t *)file_p;
 
     if(!file) {
         // LOG_VERBOSE(TAG_LVFS,F("Invalid file"));
@@ -331,8 +328,7 @@ static lv_fs_res_t fs_size(lv_fs_drv_t * drv, void * file_p, uint32_t * size_p)
 static lv_fs_res_t fs_tell(lv_fs_drv_t * drv, void * file_p, uint32_t * pos_p)
 {
     (void)drv; /*Unused*/
-    lv_spiffs_file_t file = *(lv_spiffs_file_t *)file_p;
-    // File file           = fp;
+    lv_spiffs_file_t & file = *(lv_spiffs_file_t *)file_p;
 
     if(!file) {
         // LOG_VERBOSE(TAG_LVFS,F("Invalid file"));
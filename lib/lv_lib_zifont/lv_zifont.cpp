@@ -39,6 +39,28 @@
 
 #define TAG_FONT 92
 
+#ifndef ZIFONT_CACHE_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define ZIFONT_CACHE_SIZE (16 * 1024) // Byte budget of the glyph bitmap cache
+#else
+#define ZIFONT_CACHE_SIZE (2 * 1024) // Byte budget of the glyph bitmap cache
+#endif
+#endif
+
+#ifndef ZIFONT_DSC_CACHE_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define ZIFONT_DSC_CACHE_SIZE 256 // Glyph descriptors cached per font, power of 2
+#else
+#define ZIFONT_DSC_CACHE_SIZE 128 // Glyph descriptors cached per font, power of 2
+#endif
+#endif
+
+#define ZIFONT_CACHE_BUCKETS 32     // Power of 2
+#define ZIFONT_OPEN_FILES 2         // Font files kept open, the text font and fontawesome
+#define ZIFONT_CHARMAP_CHUNK 16     // Charmap entries read at once while loading a font
+#define ZIFONT_AWESOME_FIRST 0xF000 // Glyphs in this range are read from the fontawesome file
+#define ZIFONT_AWESOME_LAST 0xF8FF
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -52,6 +74,17 @@ enum zifont_error_t {
 
 enum zifont_codepage_t8_t { ASCII = 0x01, ISO_8859_1 = 0x03, UTF_8 = 0x18 };
 
+/* A decoded glyph bitmap, the bitmap data follows the entry */
+typedef struct zifont_glyph_t
+{
+    struct zifont_glyph_t * lru_prev; // more recently used
+    struct zifont_glyph_t * lru_next; // less recently used
+    struct zifont_glyph_t * bucket_next;
+    const lv_font_t * font;
+    uint32_t letter;
+    uint16_t size; // bytes in the bitmap
+} zifont_glyph_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -62,18 +95,17 @@ bool IRAM_ATTR lv_font_get_glyph_dsc_fmt_zifont(const lv_font_t * font, lv_font_
 /**********************
  *  STATIC VARIABLES
  **********************/
-uint32_t charInBuffer = 0; // Last Character ID in the Bitmap Buffer
 // uint8_t filecharBitmap_p[20 * 1024];
-lv_zifont_char_t lastCharInfo; // Holds the last Glyph DSC
+static uint8_t * charBitmap_p; // Bitmap of a glyph too large for the cache
 
-#if ESP32
-// static lv_zifont_char_t charCache[256 - 32]; // glyphID DSC cache
-#define CHAR_CACHE_SIZE 224
-#else
-#define CHAR_CACHE_SIZE 95
-// static lv_zifont_char_t charCache[256 - 32]; // glyphID DSC cache
-#endif
-static uint8_t * charBitmap_p;
+static zifont_glyph_t * glyphBuckets[ZIFONT_CACHE_BUCKETS];
+static zifont_glyph_t * glyphLruHead; // most recently used
+static zifont_glyph_t * glyphLruTail; // least recently used
+static lv_zifont_cache_info_t glyphCache = {0, 0, 0, 0, ZIFONT_CACHE_SIZE, 0};
+
+static File fontFile[ZIFONT_OPEN_FILES];
+static char fontFileName[ZIFONT_OPEN_FILES][32];
+static uint8_t fontFileLast; // Slot of the most recently used file
 
 /**********************
  *      MACROS
@@ -83,8 +115,8 @@ static uint8_t * charBitmap_p;
  *   GLOBAL FUNCTIONS
  **********************/
 
-static void IRAM_ATTR blackAdd(uint8_t * charBitmap_p, uint16_t pos);
-static void IRAM_ATTR colorsAdd(uint8_t * charBitmap_p, uint8_t color1, uint16_t pos);
+static void IRAM_ATTR blackAdd(uint8_t * charBitmap_p, uint16_t pos, uint16_t limit);
+static void IRAM_ATTR colorsAdd(uint8_t * charBitmap_p, uint8_t color1, uint16_t pos, uint16_t limit);
 // static uint16_t unicode2codepoint(uint32_t unicode, uint8_t codepage);
 // static void printBuffer(uint8_t * charBitmap_p, uint8_t w, uint8_t h);
 
@@ -94,16 +126,156 @@ int lv_zifont_init(void)
     return LV_RES_OK; // OK
 }
 
-static inline bool openFont(File & file, const char * filename)
+/* ===== Glyph Bitmap Cache ===== */
+
+static inline uint8_t * glyphBitmap(zifont_glyph_t * glyph)
+{
+    return (uint8_t *)(glyph + 1);
+}
+
+static inline zifont_glyph_t ** glyphBucket(const lv_font_t * font, uint32_t letter)
+{
+    return &glyphBuckets[(letter ^ ((uintptr_t)font >> 4)) & (ZIFONT_CACHE_BUCKETS - 1)];
+}
+
+static void glyphLruUnlink(zifont_glyph_t * glyph)
 {
-    if(*filename != '/') return false;
+    if(glyph->lru_prev)
+        glyph->lru_prev->lru_next = glyph->lru_next;
+    else
+        glyphLruHead = glyph->lru_next;
+
+    if(glyph->lru_next)
+        glyph->lru_next->lru_prev = glyph->lru_prev;
+    else
+        glyphLruTail = glyph->lru_prev;
+}
+
+static void glyphLruPush(zifont_glyph_t * glyph)
+{
+    glyph->lru_prev = NULL;
+    glyph->lru_next = glyphLruHead;
+    if(glyphLruHead)
+        glyphLruHead->lru_prev = glyph;
+    else
+        glyphLruTail = glyph;
+    glyphLruHead = glyph;
+}
+
+static void glyphCacheRemove(zifont_glyph_t * glyph)
+{
+    zifont_glyph_t ** link = glyphBucket(glyph->font, glyph->letter);
+    while(*link != glyph) link = &(*link)->bucket_next;
+    *link = glyph->bucket_next;
+
+    glyphLruUnlink(glyph);
+    glyphCache.used -= sizeof(zifont_glyph_t) + glyph->size;
+    glyphCache.count--;
+    free(glyph);
+}
+
+/* Find a cached bitmap and mark it as most recently used */
+static zifont_glyph_t * glyphCacheFind(const lv_font_t * font, uint32_t letter)
+{
+    for(zifont_glyph_t * glyph = *glyphBucket(font, letter); glyph; glyph = glyph->bucket_next) {
+        if(glyph->letter == letter && glyph->font == font) {
+            if(glyph != glyphLruHead) {
+                glyphLruUnlink(glyph);
+                glyphLruPush(glyph);
+            }
+            return glyph;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Add an empty bitmap to the cache, evicting the least recently used bitmaps to stay within the budget
+ * @return the cache entry with a zeroed bitmap or NULL if it does not fit in the cache
+ */
+static zifont_glyph_t * glyphCacheAdd(const lv_font_t * font, uint32_t letter, uint16_t size)
+{
+    size_t needed = sizeof(zifont_glyph_t) + size;
+    if(needed > glyphCache.size) return NULL;
+
+    while(glyphCache.used + needed > glyphCache.size && glyphLruTail) {
+        glyphCacheRemove(glyphLruTail);
+        glyphCache.evictions++;
+    }
+
+    zifont_glyph_t * glyph = (zifont_glyph_t *)calloc(1, needed);
+    if(!glyph) return NULL;
+
+    zifont_glyph_t ** bucket = glyphBucket(font, letter);
+    glyph->font              = font;
+    glyph->letter            = letter;
+    glyph->size              = size;
+    glyph->bucket_next       = *bucket;
+    *bucket                  = glyph;
+    glyphLruPush(glyph);
+
+    glyphCache.used += needed;
+    glyphCache.count++;
+    return glyph;
+}
 
-    file = FS.open(filename, "r");
-    if(!file) {
+/* Drop the cached bitmaps of a font, or of all fonts if font is NULL */
+static void glyphCacheRemoveFont(const lv_font_t * font)
+{
+    zifont_glyph_t * glyph = glyphLruHead;
+    while(glyph) {
+        zifont_glyph_t * next = glyph->lru_next;
+        if(!font || glyph->font == font) glyphCacheRemove(glyph);
+        glyph = next;
+    }
+}
+
+void lv_zifont_cache_info(lv_zifont_cache_info_t * info)
+{
+    *info = glyphCache;
+}
+
+void lv_zifont_cache_clear(void)
+{
+    glyphCacheRemoveFont(NULL);
+}
+
+/* ===== Font Files ===== */
+
+/* Get an open handle to the font file, the files stay open between glyph lookups */
+static File * openFont(const char * filename)
+{
+    if(*filename != '/') return NULL;
+
+    for(uint8_t i = 0; i < ZIFONT_OPEN_FILES; i++) {
+        if(fontFile[i] && !strcmp(fontFileName[i], filename)) {
+            fontFileLast = i;
+            return &fontFile[i];
+        }
+    }
+
+    /* Replace the least recently used handle */
+    uint8_t i = (fontFileLast + 1) % ZIFONT_OPEN_FILES;
+    if(fontFile[i]) fontFile[i].close();
+
+    fontFile[i] = FS.open(filename, "r");
+    if(!fontFile[i]) {
         LOG_ERROR(TAG_FONT, F("Opening font: %s"), filename);
-        return false;
+        return NULL;
+    }
+
+    strncpy(fontFileName[i], filename, sizeof(fontFileName[i]) - 1);
+    fontFileName[i][sizeof(fontFileName[i]) - 1] = '\0';
+    fontFileLast                                 = i;
+    return &fontFile[i];
+}
+
+/* Close the handle to a font file, so a replaced file is opened again */
+static void closeFont(const char * filename)
+{
+    for(uint8_t i = 0; i < ZIFONT_OPEN_FILES; i++) {
+        if(fontFile[i] && !strcmp(fontFileName[i], filename)) fontFile[i].close();
     }
-    return file;
 }
 
 static inline bool initCharacterFrame(size_t size)
@@ -123,10 +295,147 @@ static inline bool initCharacterFrame(size_t size)
     }
 }
 
-int lv_zifont_font_init(lv_font_t ** font, const char * font_path, uint16_t size)
+/* ===== Glyph Descriptors ===== */
+
+/* The cache is direct mapped, a slot holds the last glyph read with that low codepoint */
+static inline lv_zifont_char_t * dscCacheSlot(const lv_font_fmt_zifont_dsc_t * fdsc, uint32_t letter)
+{
+    return &fdsc->glyph_dsc_cache[letter & (ZIFONT_DSC_CACHE_SIZE - 1)];
+}
+
+/* Position of a letter in the charmap of the text font, -1 if the font has no glyph for it */
+static int32_t charmapIndex(const lv_font_fmt_zifont_dsc_t * fdsc, uint32_t letter)
+{
+    if(!fdsc->codepoints) { // dense charmap, space is charNum=0
+        if(letter < 0x20 || letter - 0x20 >= fdsc->glyph_count) return -1;
+        return letter - 0x20;
+    }
+
+    int32_t low  = 0;
+    int32_t high = fdsc->glyph_count - 1;
+    while(low <= high) {
+        int32_t mid = (low + high) / 2;
+        if(fdsc->codepoints[mid] < letter)
+            low = mid + 1;
+        else if(fdsc->codepoints[mid] > letter)
+            high = mid - 1;
+        else
+            return mid;
+    }
+    return -1;
+}
+
+/**
+ * Read the charmap once, to index the codepoints of a sparse charmap and to fill the descriptor cache
+ * @param sparse true if the charmap is sorted by codepoint, false if it is dense from the space
+ */
+static int loadCharmap(File * file, lv_font_fmt_zifont_dsc_t * dsc, bool sparse)
+{
+    if(dsc->codepoints) {
+        free(dsc->codepoints);
+        dsc->codepoints = NULL;
+    }
+
+    uint16_t count = dsc->glyph_count;
+    if(sparse) {
+        dsc->codepoints = (uint16_t *)malloc(sizeof(uint16_t) * count);
+        if(!dsc->codepoints && count > 0) {
+            LOG_ERROR(TAG_FONT, F("Failed to allocate the index of %u characters"), count);
+            return ZIFONT_ERROR_OUT_OF_MEMORY;
+        }
+    } else if(count > ZIFONT_DSC_CACHE_SIZE) {
+        count = ZIFONT_DSC_CACHE_SIZE; // only preload the cache
+    }
+
+    lv_zifont_char_t chunk[ZIFONT_CHARMAP_CHUNK];
+    file->seek(dsc->Startdataaddress, SeekSet);
+
+    for(uint16_t i = 0; i < count; i += ZIFONT_CHARMAP_CHUNK) {
+        uint16_t len    = count - i < ZIFONT_CHARMAP_CHUNK ? count - i : ZIFONT_CHARMAP_CHUNK;
+        size_t readSize = file->readBytes((char *)chunk, sizeof(lv_zifont_char_t) * len);
+
+        /* Check that we read the correct size */
+        if(readSize != sizeof(lv_zifont_char_t) * len) {
+            LOG_ERROR(TAG_FONT, F("Error reading ziFont character map"));
+            return ZIFONT_ERROR_READING_DATA;
+        }
+
+        for(uint16_t j = 0; j < len; j++) {
+            if(sparse) {
+                if(i + j > 0 && chunk[j].character <= dsc->codepoints[i + j - 1]) {
+                    LOG_ERROR(TAG_FONT, F("Character map is not sorted at %u"), chunk[j].character);
+                    return ZIFONT_ERROR_UNKNOWN_HEADER;
+                }
+                dsc->codepoints[i + j] = chunk[j].character;
+            }
+
+            /* Lower codepoints come first and keep their slot */
+            lv_zifont_char_t * slot = dscCacheSlot(dsc, chunk[j].character);
+            if(slot->width == 0) *slot = chunk[j];
+        }
+    }
+
+    return ZIFONT_NO_ERROR;
+}
+
+/**
+ * Get the descriptor of a glyph from the cache, or with a single read from the font file
+ * @param filename receives the name of the file holding the glyph
+ * @param charmap_position receives the offset of the charmap in that file
+ * @return false if the font has no glyph for the letter
+ */
+static bool IRAM_ATTR getCharInfo(const lv_font_t * font, uint32_t letter, lv_zifont_char_t * charInfo,
+                                  char * filename, size_t size, uint32_t * charmap_position)
 {
-    charInBuffer = 0; // invalidate any previous cache
+    lv_font_fmt_zifont_dsc_t * fdsc = (lv_font_fmt_zifont_dsc_t *)font->dsc; /* header data struct */
+    int32_t glyphID;
+
+    if(letter >= ZIFONT_AWESOME_FIRST && letter <= ZIFONT_AWESOME_LAST) {
+        snprintf_P(filename, size, PSTR("/fontawesome%u.zi"), fdsc->CharHeight);
+        *charmap_position = 25 + sizeof(zi_font_header_t);
+        glyphID           = letter - ZIFONT_AWESOME_FIRST; // start of fontawesome
+    } else {
+        strncpy(filename, (char *)font->user_data, size - 1);
+        filename[size - 1] = '\0';
+        *charmap_position  = fdsc->Startdataaddress;
+        glyphID            = charmapIndex(fdsc, letter);
+        if(glyphID < 0) return false;
+    }
+
+    /* Check the descriptor cache */
+    lv_zifont_char_t * slot = dscCacheSlot(fdsc, letter);
+    if(slot->width > 0 && slot->character == letter) {
+        *charInfo = *slot;
+        return true;
+    }
+
+    File * file = openFont(filename);
+    if(!file) return false;
+
+    /* Read Character Table */
+    file->seek(*charmap_position + glyphID * sizeof(lv_zifont_char_t), SeekSet);
+    size_t readSize = file->readBytes((char *)charInfo, sizeof(lv_zifont_char_t));
 
+    /* Check that we read the correct size */
+    if(readSize != sizeof(lv_zifont_char_t)) {
+        LOG_ERROR(TAG_FONT, F("Wrong number of bytes read from flash"));
+        return false;
+    }
+
+    /* Double-check that we got the correct letter */
+    if(charInfo->character != letter) {
+        LOG_ERROR(TAG_FONT, F("Incorrect letter read from flash"));
+        return false;
+    }
+
+    *slot = *charInfo;
+    return true;
+}
+
+/* ===== Font Loading ===== */
+
+int lv_zifont_font_init(lv_font_t ** font, const char * font_path, uint16_t size)
+{
     if(!*font) {
         *font = (lv_font_t *)lv_mem_alloc(sizeof(lv_font_t));
         LV_ASSERT_MEM(*font);
@@ -144,33 +453,38 @@ int lv_zifont_font_init(lv_font_t ** font, const char * font_path, uint16_t size
     LV_ASSERT_MEM(dsc);
     if(!dsc) return ZIFONT_ERROR_OUT_OF_MEMORY;
 
-    /* Initialize Last Glyph DSC */
-    dsc->last_glyph_dsc = (lv_zifont_char_t *)lv_mem_alloc(sizeof(lv_zifont_char_t));
-    _lv_memset_00(dsc->last_glyph_dsc, sizeof(lv_zifont_char_t)); // lv_mem_alloc might be dirty
+    /* Initialize the Glyph DSC Cache */
+    if(!dsc->glyph_dsc_cache) {
+        dsc->glyph_dsc_cache = (lv_zifont_char_t *)lv_mem_alloc(sizeof(lv_zifont_char_t) * ZIFONT_DSC_CACHE_SIZE);
+        LV_ASSERT_MEM(dsc->glyph_dsc_cache);
+        if(dsc->glyph_dsc_cache == NULL) return ZIFONT_ERROR_OUT_OF_MEMORY;
+    }
+    _lv_memset_00(dsc->glyph_dsc_cache, sizeof(lv_zifont_char_t) * ZIFONT_DSC_CACHE_SIZE);
 
-    if(dsc->last_glyph_dsc == NULL) return ZIFONT_ERROR_OUT_OF_MEMORY;
-    dsc->last_glyph_dsc->width = 0;
-    dsc->last_glyph_id         = 0;
+    /* Invalidate the bitmaps of a previously loaded font */
+    glyphCacheRemoveFont(*font);
 
     /* Open the font for reading */
-    File file;
-    if(!openFont(file, font_path)) return ZIFONT_ERROR_OPENING_FILE;
+    closeFont(font_path); // the file may have been replaced
+    File * file = openFont(font_path);
+    if(!file) return ZIFONT_ERROR_OPENING_FILE;
 
     /* Read file header as dsc */
     zi_font_header_t header;
-    size_t readSize = file.readBytes((char *)&header, sizeof(zi_font_header_t));
+    file->seek(0, SeekSet);
+    size_t readSize = file->readBytes((char *)&header, sizeof(zi_font_header_t));
 
     /* Check that we read the correct size */
     if(readSize != sizeof(zi_font_header_t)) {
         LOG_ERROR(TAG_FONT, F("Error reading ziFont Header"));
-        file.close();
+        closeFont(font_path);
         return ZIFONT_ERROR_READING_DATA;
     }
 
     /* Check ziFile Header Format */
     if(header.Password != 4 || header.Version != 5) {
         LOG_ERROR(TAG_FONT, F("Unknown font file format"));
-        file.close();
+        closeFont(font_path);
         return ZIFONT_ERROR_UNKNOWN_HEADER;
     }
 
@@ -182,32 +496,24 @@ int lv_zifont_font_init(lv_font_t ** font, const char * font_path, uint16_t size
     dsc->Startdataaddress = header.Startdataaddress + header.Descriptionlength;
     dsc->Fontdataadd8byte = header.Fontdataadd8byte;
 
-    if(!dsc->ascii_glyph_dsc) {
-        dsc->ascii_glyph_dsc = (lv_zifont_char_t *)lv_mem_alloc(sizeof(lv_zifont_char_t) * CHAR_CACHE_SIZE);
-        LV_ASSERT_MEM(dsc->ascii_glyph_dsc);
-        _lv_memset_00(dsc->ascii_glyph_dsc, sizeof(lv_zifont_char_t) * CHAR_CACHE_SIZE); // lv_mem_alloc might be dirty
-    }
-    if(dsc->ascii_glyph_dsc == NULL) {
-        file.close();
-        return ZIFONT_ERROR_OUT_OF_MEMORY;
+    /* A UTF-8 font has a sparse charmap sorted by codepoint, the other codepages a dense one from the space */
+    bool sparse      = header.Codepageid == UTF_8;
+    uint32_t entries = sparse ? header.Actualnumchars : header.Maximumnumchars;
+    if(entries > UINT16_MAX) {
+        LOG_ERROR(TAG_FONT, F("Too many characters in font: %u"), entries);
+        closeFont(font_path);
+        return ZIFONT_ERROR_UNKNOWN_HEADER;
     }
+    dsc->glyph_count = entries;
 
-    /* read charmap into cache */
-    file.seek(0 * sizeof(zi_font_header_t) + dsc->Startdataaddress, SeekSet);
-    //* read and fill charmap cache
-    readSize = file.readBytes((char *)dsc->ascii_glyph_dsc, sizeof(lv_zifont_char_t) * CHAR_CACHE_SIZE);
-
-    //* Check that we read the correct size
-    if(readSize != sizeof(lv_zifont_char_t) * CHAR_CACHE_SIZE) {
-        LOG_ERROR(TAG_FONT, F("Error reading ziFont character map"));
-        file.close();
-        return ZIFONT_ERROR_READING_DATA;
+    int error = loadCharmap(file, dsc, sparse);
+    if(error != ZIFONT_NO_ERROR) {
+        closeFont(font_path);
+        return error;
     }
 
     LOG_VERBOSE(TAG_FONT, F("Loaded V%d Font File: %s containing %d characters"), header.Version, font_path,
-                header.Maximumnumchars);
-
-    file.close();
+                dsc->glyph_count);
 
     /*
         sprintf_P(msg, PSTR("password: %u - skipL0: %u - skipLH: %u - state: %u\n"), dsc->Password, dsc->SkipL0,
@@ -224,10 +530,6 @@ int lv_zifont_font_init(lv_font_t ** font, const char * font_path, uint16_t size
        PSTR("FontnameAndCmapLength: %u - FontnameStartAddr: %u - temp0: %u - temp1: %u\n"), dsc->Totaldatalength,
        dsc->Startdataaddress, dsc->CodeT0, dsc->CodeDec); Serial.printf(msg);*/
 
-    /* Init Glyph Cache */
-    dsc->last_glyph_dsc = NULL;
-    dsc->last_glyph_id  = 0;
-
     (*font)->get_glyph_dsc    = lv_font_get_glyph_dsc_fmt_zifont; /*Function pointer to get glyph's data*/
     (*font)->get_glyph_bitmap = lv_font_get_bitmap_fmt_zifont;    /*Function pointer to get glyph's bitmap*/
     (*font)->line_height      = dsc->CharHeight;                  /*The maximum line height required by the font*/
@@ -256,107 +558,49 @@ int lv_zifont_font_init(lv_font_t ** font, const char * font_path, uint16_t size
  */
 const uint8_t * IRAM_ATTR lv_font_get_bitmap_fmt_zifont(const lv_font_t * font, uint32_t unicode_letter)
 {
-    /* Bitmap still in buffer */
-    if(charInBuffer == unicode_letter && charBitmap_p) {
-        // Serial.printf("CacheLetter %c\n", (char)(uint8_t)unicode_letter);
-        // Serial.printf("#%c", (char)(uint8_t)unicode_letter);
-        return charBitmap_p;
+    /* Bitmap in the cache */
+    zifont_glyph_t * glyph = glyphCacheFind(font, unicode_letter);
+    if(glyph) {
+        glyphCache.hits++;
+        return glyphBitmap(glyph);
     }
+    glyphCache.misses++;
 
     lv_font_fmt_zifont_dsc_t * fdsc = (lv_font_fmt_zifont_dsc_t *)font->dsc; /* header data struct */
-    lv_zifont_char_t * charInfo;
-
-    /* Space */
-    if(unicode_letter == 0x20) {
-        charInfo    = &fdsc->ascii_glyph_dsc[0];
-        size_t size = (charInfo->width * fdsc->CharHeight + 1) / 2; // add 1 for rounding up
-        if(initCharacterFrame(size)) {
-            charInBuffer = unicode_letter;
-        } else {
-            charInBuffer = 0;
-        }
-        return charBitmap_p;
-    }
-
-    File file;
+    lv_zifont_char_t charInfo;
     char filename[32];
-    uint32_t glyphID;
-    uint16_t charmap_position;
-
-    if(unicode_letter >= 0xF000) {
-        // return NULL;
-        snprintf_P(filename, sizeof(filename), PSTR("/fontawesome%u.zi"), fdsc->CharHeight);
-        charmap_position = 25 + sizeof(zi_font_header_t);
-        glyphID          = unicode_letter - 0xf000; // start of fontawesome
-    } else {
-        strcpy(filename, (char *)font->user_data);
-        charmap_position = fdsc->Startdataaddress;
-        glyphID          = unicode_letter - 0x20; // simple unicode to ascii - space is charNum=0
-    }
+    uint32_t charmap_position;
+    if(!getCharInfo(font, unicode_letter, &charInfo, filename, sizeof(filename), &charmap_position)) return NULL;
 
-    if(!openFont(file, filename)) return NULL;
+    File * file = NULL;
+    if(unicode_letter != 0x20 && !(file = openFont(filename))) return NULL;
 
-    /* Check Last Glyph in chache is valid and Matches currentGlyphID */
-    if(fdsc->last_glyph_id == glyphID && fdsc->last_glyph_dsc && fdsc->last_glyph_dsc->width > 0) {
-        // Serial.print("@");
-        charInfo = fdsc->last_glyph_dsc;
+    /* Allocate & Initialize Buffer for 4bpp */
+    uint32_t size          = (charInfo.width * fdsc->CharHeight + 1) / 2; // add 1 for rounding up
+    uint16_t pixels        = size * 2;
+    zifont_glyph_t * entry = glyphCacheAdd(font, unicode_letter, size);
+    uint8_t * bitmap;
+    if(entry) {
+        bitmap = glyphBitmap(entry);
     } else {
-        Serial.print("%");
-        /* Read Character Table */
-        charInfo = (lv_zifont_char_t *)lv_mem_alloc(sizeof(lv_zifont_char_t));
-        // lv_memset(charInfo, 0x00, sizeof(lv_zifont_char_t)); // lv_mem_alloc might be dirty
-        uint32_t char_position = glyphID * sizeof(lv_zifont_char_t) + charmap_position;
-        file.seek(char_position, SeekSet);
-        size_t readSize = file.readBytes((char *)charInfo, sizeof(lv_zifont_char_t));
-
-        /* Check that we read the correct size */
-        if(readSize != sizeof(lv_zifont_char_t)) {
-            file.close();
-            lv_mem_free(charInfo);
-            LOG_ERROR(TAG_FONT, F("Wrong number of bytes read from flash"));
-            return NULL;
-        }
-
-        /* Double-check that we got the correct letter */
-        if(charInfo->character != unicode_letter) {
-            file.close();
-            lv_mem_free(charInfo);
-            LOG_ERROR(TAG_FONT, F("Incorrect letter read from flash"));
-            return NULL;
-        }
+        if(!initCharacterFrame(size)) return NULL;
+        bitmap = charBitmap_p;
     }
 
-    long datapos = charmap_position + (charInfo->pos[2] << 16) + (charInfo->pos[1] << 8) + charInfo->pos[0];
+    /* Space */
+    if(unicode_letter == 0x20) return bitmap;
 
-    /* Allocate & Initialize Buffer for 4bpp */
-    uint32_t size = (charInfo->width * fdsc->CharHeight + 1) / 2; // add 1 for rounding up
-    if(!initCharacterFrame(size)) {
-        return NULL;
-    }
+    long datapos = charmap_position + (charInfo.pos[2] << 16) + (charInfo.pos[1] << 8) + charInfo.pos[0];
 
     char data[256];
-    file.seek(datapos + 1, SeekSet); // +1 for skipping bpp byte
-
-    /* Speed optimization, skip BPP check
-    char b[1];
-    file.seek(datapos, SeekSet);
-    file.readBytes(b, 1); // check first byte = bpp
-
-    if((uint8_t)b[0] != 3) {
-        file.close();
-        lv_mem_free(charInfo);
-        snprintf_P(data, sizeof(data), PSTR("[ERROR] Character %u at %u is not 3bpp encoded but %u"), glyphID,
-                   datapos, b[0]);
-        debugPrintln(data);
-
-        // Serial.printf("  adv_w %u (%u) - bpp %u  -  ", dsc_out->adv_w, charInfo->width, dsc_out->bpp);
-        // Serial.printf("  box_w %u  -  box_h %u   -  ", dsc_out->box_w, dsc_out->box_h);
-        // Serial.printf("  kernL %u  -  kernR %u   \n", charInfo->kerningL, charInfo->kerningR);
-        // Serial.printf("  ofs_x %u - ofs_y %u \n\n", dsc_out->ofs_x, dsc_out->ofs_x);
-
+    file->seek(datapos, SeekSet);
+    int bpp = file->read(); // check first byte = bpp
+    if(bpp != 3) {
+        LOG_ERROR(TAG_FONT, F("Character %u at %u is not 3bpp encoded but %d"), unicode_letter, (uint32_t)datapos,
+                  bpp);
+        if(entry) glyphCacheRemove(entry);
         return NULL;
     }
-    */
 
     // uint8_t w          = charInfo->width + charInfo->kerningL + charInfo->kerningR;
     // char data[256];
@@ -366,15 +610,15 @@ const uint8_t * IRAM_ATTR lv_font_get_bitmap_fmt_zifont(const lv_font_t * font,
     uint8_t color1, color2;
 
     // while((fileindex < charInfo->length) && len > 0) { //} && !feof(file)) {
-    while((arrindex < size * 2) && (len > 0)) { // read untill the bitmap is full, no need for datalength
-        if((int32_t)sizeof(data) < (charInfo->length - fileindex)) {
-            len = file.readBytes(data, sizeof(data));
+    while((arrindex < pixels) && (len > 0)) { // read untill the bitmap is full, no need for datalength
+        if((int32_t)sizeof(data) < (charInfo.length - fileindex)) {
+            len = file->readBytes(data, sizeof(data));
         } else {
-            len = file.readBytes(data, (charInfo->length - fileindex));
+            len = file->readBytes(data, (charInfo.length - fileindex));
         }
         fileindex += len;
 
-        for(k = 0; k < len; k++) {
+        for(k = 0; k < len && arrindex < pixels; k++) {
             uint8_t b = data[k];
             // Serial.printf("%d - %d > %x = %x  arrindex:%d\n", fileindex, arrindex, b, ch[0], ftell(file));
 
@@ -386,19 +630,19 @@ const uint8_t * IRAM_ATTR lv_font_get_bitmap_fmt_zifont(const lv_font_t * font,
 
                 case(0b001):
                     for(int i = 0; i < repeats; i++) { // repeats are black
-                        blackAdd(charBitmap_p, arrindex++);
+                        blackAdd(bitmap, arrindex++, pixels);
                     }
                     break;
 
                 case(0b010):
                     arrindex += repeats; // repeats are white
-                    blackAdd(charBitmap_p, arrindex++);
+                    blackAdd(bitmap, arrindex++, pixels);
                     break;
 
                 case(0b011):
                     arrindex += repeats; // repeats are white
-                    blackAdd(charBitmap_p, arrindex++);
-                    blackAdd(charBitmap_p, arrindex++);
+                    blackAdd(bitmap, arrindex++, pixels);
+                    blackAdd(bitmap, arrindex++, pixels);
                     break;
 
                 case(0b100):
@@ -406,14 +650,14 @@ const uint8_t * IRAM_ATTR lv_font_get_bitmap_fmt_zifont(const lv_font_t * font,
                     repeats = (uint8_t)((b & (0b111000)) >> 3); /* 3 bits indicate repetition as the same color */
                     color1  = (uint8_t)(b & (0b0111));
                     arrindex += repeats;
-                    colorsAdd(charBitmap_p, color1, arrindex++);
+                    colorsAdd(bitmap, color1, arrindex++, pixels);
                     break;
 
                 default:
                     color1 = (b & 0b111000) >> 3;
                     color2 = b & 0b000111;
-                    colorsAdd(charBitmap_p, color1, arrindex++);
-                    colorsAdd(charBitmap_p, color2, arrindex++);
+                    colorsAdd(bitmap, color1, arrindex++, pixels);
+                    colorsAdd(bitmap, color2, arrindex++, pixels);
             }
             // if(unicode_letter == 0xf015)
             //     LOG_VERBOSE(TAG_FONT, F("read %d => %d / %d (%d / %d) %d"), len, fileindex, charInfo->length,
@@ -422,15 +666,17 @@ const uint8_t * IRAM_ATTR lv_font_get_bitmap_fmt_zifont(const lv_font_t * font,
         }
     }
 
-    // Serial.printf("[OK] Letter %c - %d\n", (char)(uint8_t)unicode_letter, arrindex);
-    // printBuffer(charBitmap_p, charInfo->width, fdsc->CharHeight);
-
-    file.close();
+    /* A short read leaves a partial bitmap, do not serve it from the cache */
+    if(arrindex < pixels && fileindex < charInfo.length) {
+        LOG_ERROR(TAG_FONT, F("Character %u at %u is truncated"), unicode_letter, (uint32_t)datapos);
+        if(entry) glyphCacheRemove(entry);
+        return NULL;
+    }
 
-    lv_mem_free(charInfo);
-    charInBuffer = unicode_letter;
+    // Serial.printf("[OK] Letter %c - %d\n", (char)(uint8_t)unicode_letter, arrindex);
+    // printBuffer(bitmap, charInfo.width, fdsc->CharHeight);
 
-    return charBitmap_p;
+    return bitmap;
 }
 
 /**
@@ -444,83 +690,23 @@ const uint8_t * IRAM_ATTR lv_font_get_bitmap_fmt_zifont(const lv_font_t * font,
 bool IRAM_ATTR lv_font_get_glyph_dsc_fmt_zifont(const lv_font_t * font, lv_font_glyph_dsc_t * dsc_out,
                                                 uint32_t unicode_letter, uint32_t unicode_letter_next)
 {
-    /* Only ascii characteres supported for now */
     // returning true with a box_h of 0 does not display an error
     dsc_out->box_w = dsc_out->box_h = 0; // Prevents glyph not found error messages when true is returned
     if(unicode_letter < 0x20) return true;
-    if(unicode_letter > 0xff && unicode_letter < 0xf000) return true;
-    // if(unicode_letter > 0xff) Serial.printf("Char# %u\n", unicode_letter);
 
-    // ulong startMillis               = millis();
     lv_font_fmt_zifont_dsc_t * fdsc = (lv_font_fmt_zifont_dsc_t *)font->dsc; /* header data struct */
-
-    uint16_t glyphID;
-    File file;
-    uint8_t charmap_position;
-    uint8_t charwidth;
-    if(unicode_letter >= 0xF000) {
-        charmap_position = 25 + sizeof(zi_font_header_t);
-        glyphID          = unicode_letter - 0xf000; // start of fontawesome
-        charwidth        = 0;
-    } else {
-        charmap_position = fdsc->Startdataaddress; // Descriptionlength + sizeof(lv_font_fmt_zifont_dsc_t);
-        glyphID          = unicode_letter - 0x20;  // simple unicode to ascii - space is charNum=0
-        // if(glyphID < sizeof(fdsc->ascii_glyph_dsc) / sizeof(lv_zifont_char_t))
-        if(glyphID < CHAR_CACHE_SIZE)
-            charwidth = fdsc->ascii_glyph_dsc[glyphID].width;
-        else
-            charwidth = 0;
-    }
-
-    // if(charwidth == 0 || glyphID >= sizeof(fdsc->ascii_glyph_dsc) / sizeof(lv_zifont_char_t)) {
-    if(charwidth == 0 || glyphID >= CHAR_CACHE_SIZE) {
-
-        /* Open the font for reading */
-        if(unicode_letter >= 0xF000) {
-            // return false;
-            char filename[32];
-            snprintf_P(filename, sizeof(filename), PSTR("/fontawesome%u.zi"), fdsc->CharHeight);
-            if(!openFont(file, filename)) return false;
-        } else {
-            if(!openFont(file, (char *)font->user_data)) return false;
-        }
-
-        /* read 10 bytes charmap */
-        // lv_zifont_char_t * myCharIndex = (lv_zifont_char_t *)lv_mem_alloc(sizeof(lv_zifont_char_t));
-        lv_zifont_char_t myCharIndex;
-        uint32_t char_position = glyphID * sizeof(lv_zifont_char_t) + charmap_position;
-        file.seek(char_position, SeekSet);
-        size_t readSize = file.readBytes((char *)&myCharIndex, sizeof(lv_zifont_char_t));
-        file.close();
-
-        /* Check that we read the correct size */
-        if(readSize != sizeof(lv_zifont_char_t)) {
-            // lv_mem_free(myCharIndex);
-            return false;
-        }
-
-        /* Double-check that we got the correct letter */
-        if(fdsc->last_glyph_dsc->character != unicode_letter) {
-            // lv_mem_free(myCharIndex);
-            // return false;
-        }
-
-        if(unicode_letter <= 0xff && glyphID < CHAR_CACHE_SIZE) fdsc->ascii_glyph_dsc[glyphID] = myCharIndex;
-        lastCharInfo = myCharIndex;
-        // lv_mem_free(myCharIndex);
-
-    } else {
-        lastCharInfo = fdsc->ascii_glyph_dsc[glyphID];
+    lv_zifont_char_t charInfo;
+    char filename[32];
+    uint32_t charmap_position;
+    if(!getCharInfo(font, unicode_letter, &charInfo, filename, sizeof(filename), &charmap_position)) {
+        dsc_out->adv_w = 0;
+        return true; // glyphs missing from the font take no space
     }
 
-    /*cache glyph data*/
-    fdsc->last_glyph_id  = glyphID;
-    fdsc->last_glyph_dsc = &lastCharInfo;
-
-    dsc_out->adv_w = lastCharInfo.width; //-myCharIndex->righroverlap)*16; /* 8 bit integer 4 bit fractional*/
-    dsc_out->box_w = lastCharInfo.width + lastCharInfo.kerningL + lastCharInfo.kerningR;
+    dsc_out->adv_w = charInfo.width; //-myCharIndex->righroverlap)*16; /* 8 bit integer 4 bit fractional*/
+    dsc_out->box_w = charInfo.width + charInfo.kerningL + charInfo.kerningR;
     dsc_out->box_h = fdsc->CharHeight;
-    dsc_out->ofs_x = -lastCharInfo.kerningL;
+    dsc_out->ofs_x = -charInfo.kerningL;
     dsc_out->ofs_y = 0;
     dsc_out->bpp   = 4; /**< Bit-per-pixel: 1, 2, 4, 8*/
 
@@ -536,8 +722,10 @@ bool IRAM_ATTR lv_font_get_glyph_dsc_fmt_zifont(const lv_font_t * font, lv_font_
     return true;
 }
 
-static void IRAM_ATTR blackAdd(uint8_t * charBitmap_p, uint16_t pos)
+static void IRAM_ATTR blackAdd(uint8_t * charBitmap_p, uint16_t pos, uint16_t limit)
 {
+    if(pos >= limit) return; // past the end of the bitmap
+
     uint8_t col    = pos & 0x0001; // remainder
     uint16_t map_p = pos >> 1;     // devide by 2
 
@@ -548,8 +736,10 @@ static void IRAM_ATTR blackAdd(uint8_t * charBitmap_p, uint16_t pos)
     }
 }
 
-static inline void IRAM_ATTR colorsAdd(uint8_t * charBitmap_p, uint8_t color1, uint16_t pos)
+static inline void IRAM_ATTR colorsAdd(uint8_t * charBitmap_p, uint8_t color1, uint16_t pos, uint16_t limit)
 {
+    if(pos >= limit) return; // past the end of the bitmap
+
     uint32_t col   = pos & 0x0001; // remainder
     uint32_t map_p = pos >> 1;     // devide by 2
 
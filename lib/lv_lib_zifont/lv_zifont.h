@@ -78,16 +78,28 @@ typedef struct
     uint32_t Totaldatalength;
     uint32_t Startdataaddress;
     uint8_t Fontdataadd8byte;
-    uint16_t last_glyph_id;
-    lv_zifont_char_t * last_glyph_dsc;
-    lv_zifont_char_t * ascii_glyph_dsc;
+    uint16_t glyph_count;               // entries in the character map
+    uint16_t * codepoints;              // sorted codepoints of a sparse character map, NULL if dense
+    lv_zifont_char_t * glyph_dsc_cache; // recently used glyph descriptors, indexed by codepoint
 } lv_font_fmt_zifont_dsc_t;
 
+typedef struct
+{
+    uint32_t hits;      // bitmaps served from the cache
+    uint32_t misses;    // bitmaps decoded from flash
+    uint32_t evictions; // bitmaps dropped to stay within the budget
+    uint32_t used;      // bytes in use, including the entry overhead
+    uint32_t size;      // byte budget
+    uint16_t count;     // number of cached bitmaps
+} lv_zifont_cache_info_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
 int lv_zifont_init(void);
 int lv_zifont_font_init(lv_font_t ** font, const char * font_path, uint16_t size);
+void lv_zifont_cache_info(lv_zifont_cache_info_t * info);
+void lv_zifont_cache_clear(void);
 
 /**********************
  *      MACROS
@@ -13,6 +13,11 @@
 #include "Windows.h"
 #endif
 
+#ifdef POSIX
+#include <cstdint>
+#include <cstddef>
+#endif
+
 namespace dev {
 
 class BaseDevice {
@@ -97,6 +102,9 @@ class BaseDevice {
 #elif defined(WINDOWS)
 #warning Building for Win32 Devices
 #include "win32/hasp_win32.h"
+#elif defined(POSIX)
+#warning Building for Posix Devices
+#include "posix/hasp_posix.h"
 #else
 #warning Building for Generic Devices
 using dev::BaseDevice;
@@ -0,0 +1,121 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#if defined(POSIX)
+
+#include <cstdint>
+#include <unistd.h>
+#include <sys/sysinfo.h>
+#include <sys/utsname.h>
+
+#include "hasp_posix.h"
+
+#include "hasp_conf.h"
+#include "hasp/hasp_utilities.h"
+#include "hasp_debug.h"
+
+namespace dev {
+
+PosixDevice::PosixDevice()
+{
+    char buffer[64];
+
+    if(gethostname(buffer, sizeof(buffer)) == 0) {
+        buffer[sizeof(buffer) - 1] = '\0';
+        _hostname                  = buffer;
+    } else {
+        _hostname = "localhost";
+    }
+
+    _backlight_pin   = -1;
+    _backlight_power = 1;
+    _backlight_level = 100;
+}
+
+void PosixDevice::reboot()
+{}
+
+void PosixDevice::show_info()
+{
+    struct utsname info;
+    if(uname(&info) == 0) {
+        LOG_VERBOSE(0, F("System     : %s %s"), info.sysname, info.release);
+        LOG_VERBOSE(0, F("Machine    : %s"), info.machine);
+    }
+    LOG_VERBOSE(0, F("CPU cores  : %ld"), sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+const char* PosixDevice::get_hostname()
+{
+    return _hostname.c_str();
+}
+void PosixDevice::set_hostname(const char* hostname)
+{
+    _hostname = hostname;
+}
+const char* PosixDevice::get_core_version()
+{
+    return "posix";
+}
+const char* PosixDevice::get_display_driver()
+{
+    return "Headless";
+}
+
+void PosixDevice::set_backlight_pin(uint8_t pin)
+{
+    // PosixDevice::_backlight_pin = pin;
+}
+
+void PosixDevice::set_backlight_level(uint8_t level)
+{
+    _backlight_level = level <= 100 ? level : 100;
+}
+
+uint8_t PosixDevice::get_backlight_level()
+{
+    return _backlight_level;
+}
+
+void PosixDevice::set_backlight_power(bool power)
+{
+    _backlight_power = power;
+}
+
+bool PosixDevice::get_backlight_power()
+{
+    return _backlight_power != 0;
+}
+
+size_t PosixDevice::get_free_max_block()
+{
+    return 0;
+}
+
+size_t PosixDevice::get_free_heap(void)
+{
+    struct sysinfo info;
+    if(sysinfo(&info) != 0) return 0;
+    return info.freeram * info.mem_unit;
+}
+
+uint8_t PosixDevice::get_heap_fragmentation()
+{
+    return 0;
+}
+
+uint16_t PosixDevice::get_cpu_frequency()
+{
+    return 0;
+}
+
+bool PosixDevice::is_system_pin(uint8_t pin)
+{
+    return false;
+}
+
+} // namespace dev
+
+dev::PosixDevice haspDevice;
+
+#endif // POSIX
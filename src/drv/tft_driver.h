@@ -23,6 +23,10 @@ class BaseTft {
     {}
     static void flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
     {}
+    virtual void flush_poll()
+    {}
+    virtual void flush_sync()
+    {}
     virtual bool is_driver_pin(uint8_t)
     {
         return false;
@@ -43,6 +47,9 @@ class BaseTft {
 #elif defined(WINDOWS)
 #warning Building for Win32 Devices
 #include "tft_driver_sdl2.h"
+#elif defined(POSIX)
+#warning Building for Posix Devices
+#include "tft_driver_headless.h"
 #else
 #warning Building for Generic Devices
 using dev::BaseTft;
@@ -0,0 +1,263 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#if defined(POSIX)
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tft_driver_headless.h"
+
+namespace dev {
+
+uint16_t* TftHeadless::framebuffer = NULL;
+lv_coord_t TftHeadless::fb_width   = 0;
+lv_coord_t TftHeadless::fb_height  = 0;
+
+headless_frame_t TftHeadless::frame;
+headless_stats_t TftHeadless::stats;
+headless_frame_t TftHeadless::history[HEADLESS_FRAME_HISTORY];
+uint32_t TftHeadless::history_count = 0;
+uint32_t TftHeadless::frame_start   = 0;
+
+/**
+ * A task to measure the elapsed time for LittlevGL
+ * @param data unused
+ * @return never return
+ */
+static void* tick_thread(void* data)
+{
+    (void)data;
+
+    while(1) {
+        usleep(5000);   /*Sleep for 5 millisecond*/
+        lv_tick_inc(5); /*Tell LittelvGL that 5 milliseconds were elapsed*/
+    }
+
+    return NULL;
+}
+
+static uint32_t headless_micros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+static void headless_put_u16(FILE* file, uint16_t value)
+{
+    fputc(value & 0xFF, file);
+    fputc(value >> 8, file);
+}
+
+static void headless_put_u32(FILE* file, uint32_t value)
+{
+    headless_put_u16(file, value & 0xFFFF);
+    headless_put_u16(file, value >> 16);
+}
+
+void TftHeadless::init(int w, int h)
+{
+    reset_stats();
+
+    pthread_t thread;
+    if(pthread_create(&thread, NULL, tick_thread, NULL) == 0) pthread_detach(thread);
+}
+
+void TftHeadless::show_info()
+{
+    LOG_VERBOSE(TAG_TFT, F("Driver     : Headless"));
+    LOG_VERBOSE(TAG_TFT, F("Resolution : %ux%u RGB565"), TFT_WIDTH, TFT_HEIGHT);
+}
+
+/**
+ * Copy the flushed area into the framebuffer
+ * @note the framebuffer follows the resolution of the display, including rotation
+ */
+void TftHeadless::flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_coord_t width  = disp->rotated ? disp->ver_res : disp->hor_res;
+    lv_coord_t height = disp->rotated ? disp->hor_res : disp->ver_res;
+
+    if(!framebuffer || width != fb_width || height != fb_height) {
+        uint16_t* buffer = (uint16_t*)realloc(framebuffer, width * height * sizeof(uint16_t));
+        if(buffer) {
+            memset(buffer, 0, width * height * sizeof(uint16_t));
+            framebuffer = buffer;
+            fb_width    = width;
+            fb_height   = height;
+        }
+    }
+
+    lv_coord_t x1 = LV_MATH_MAX(area->x1, 0);
+    lv_coord_t x2 = LV_MATH_MIN(area->x2, fb_width - 1);
+    lv_coord_t w  = area->x2 - area->x1 + 1;
+    uint32_t len  = w * (area->y2 - area->y1 + 1);
+
+    if(framebuffer && x1 <= x2) {
+        for(lv_coord_t y = LV_MATH_MAX(area->y1, 0); y <= area->y2 && y < fb_height; y++) {
+            const lv_color_t* src = color_p + (y - area->y1) * w + (x1 - area->x1);
+            uint16_t* dst         = framebuffer + y * fb_width + x1;
+            for(lv_coord_t x = x1; x <= x2; x++) *dst++ = lv_color_to16(*src++);
+        }
+    }
+
+    frame.flushes++;
+    frame.pixels += len;
+    if(len > frame.largest_area) frame.largest_area = len;
+
+    uint8_t bucket = 0;
+    for(uint32_t size = 64; bucket < HEADLESS_AREA_BUCKETS - 1 && len >= size; size <<= 2) bucket++;
+    stats.area_buckets[bucket]++;
+
+    lv_disp_flush_ready(disp);
+}
+
+/* ===== Render Metrics ===== */
+
+/* Run the lvgl tasks and measure the render pass */
+void TftHeadless::task_handler()
+{
+    frame_begin();
+    lv_task_handler();
+    frame_end();
+}
+
+void TftHeadless::frame_begin()
+{
+    memset(&frame, 0, sizeof(frame));
+    frame_start = headless_micros();
+}
+
+void TftHeadless::frame_end()
+{
+    frame.render_us = headless_micros() - frame_start;
+
+    if(frame.flushes == 0) {
+        stats.idle_passes++;
+        return;
+    }
+
+    stats.frames++;
+    stats.flushes += frame.flushes;
+    stats.pixels += frame.pixels;
+    stats.render_us += frame.render_us;
+    if(frame.render_us > stats.render_us_max) stats.render_us_max = frame.render_us;
+
+    history[history_count++ % HEADLESS_FRAME_HISTORY] = frame;
+}
+
+/**
+ * Get the metrics of a recent frame
+ * @param age 0 for the last frame, 1 for the one before, ...
+ * @return the frame or NULL if it is no longer kept
+ */
+const headless_frame_t* TftHeadless::get_frame(uint16_t age)
+{
+    if(age >= HEADLESS_FRAME_HISTORY || age >= history_count) return NULL;
+    return &history[(history_count - 1 - age) % HEADLESS_FRAME_HISTORY];
+}
+
+const headless_stats_t& TftHeadless::get_stats()
+{
+    return stats;
+}
+
+void TftHeadless::reset_stats()
+{
+    memset(&stats, 0, sizeof(stats));
+    history_count = 0;
+}
+
+void TftHeadless::log_stats()
+{
+    if(stats.frames == 0) {
+        LOG_INFO(TAG_TFT, F("No frames rendered, %u idle passes"), stats.idle_passes);
+        return;
+    }
+
+    LOG_INFO(TAG_TFT, F("Frames     : %u rendered, %u idle passes"), stats.frames, stats.idle_passes);
+    LOG_INFO(TAG_TFT, F("Render     : %llu us avg, %u us max"),
+             (unsigned long long)(stats.render_us / stats.frames), stats.render_us_max);
+    LOG_INFO(TAG_TFT, F("Flushes    : %llu, %llu pixels, %llu px/frame"), (unsigned long long)stats.flushes,
+             (unsigned long long)stats.pixels, (unsigned long long)(stats.pixels / stats.frames));
+    LOG_INFO(TAG_TFT, F("Areas      : <64 %u, <256 %u, <1k %u, <4k %u, <16k %u, <64k %u, <256k %u, more %u"),
+             stats.area_buckets[0], stats.area_buckets[1], stats.area_buckets[2], stats.area_buckets[3],
+             stats.area_buckets[4], stats.area_buckets[5], stats.area_buckets[6], stats.area_buckets[7]);
+}
+
+/* ===== Framebuffer ===== */
+
+/**
+ * Write the framebuffer to a file
+ * @param filename the name of the bitmap file
+ * @return true if the file was written
+ * @note the format is a 16 bit RGB565 bitmap, the same as the screenshots taken on the device
+ */
+bool TftHeadless::dump(const char* filename)
+{
+    if(!framebuffer) {
+        LOG_WARNING(TAG_TFT, F("Nothing rendered yet"));
+        return false;
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if(!file) {
+        LOG_WARNING(TAG_TFT, F("%s cannot be opened"), filename);
+        return false;
+    }
+
+    uint32_t stride = (fb_width * 2 + 3) & ~3;
+    uint32_t size   = stride * fb_height;
+
+    /* File header */
+    fputs("BM", file);
+    headless_put_u32(file, 122 + size);
+    headless_put_u32(file, 0);
+    headless_put_u32(file, 122); // full header size
+
+    /* BITMAPV4HEADER */
+    headless_put_u32(file, 122 - 14);
+    headless_put_u32(file, fb_width);
+    headless_put_u32(file, -fb_height); // top-down
+    headless_put_u16(file, 1);          // number of color planes
+    headless_put_u16(file, 16);         // bpp
+    headless_put_u32(file, 3);          // compression, 3 = bitfields
+    headless_put_u32(file, size);
+    headless_put_u32(file, 2836); // horizontal pixels per meter
+    headless_put_u32(file, 2836); // vertical pixels per meter
+    headless_put_u32(file, 0);
+    headless_put_u32(file, 0);
+    headless_put_u32(file, 0xF800); // Red bitmask
+    headless_put_u32(file, 0x07E0); // Green bitmask
+    headless_put_u32(file, 0x001F); // Blue bitmask
+    headless_put_u32(file, 0x0000); // No Alpha Mask
+    fputs(" niW", file);            // "Win " color space
+    for(int i = 0; i < 48; i++) fputc(0, file);
+
+    for(lv_coord_t y = 0; y < fb_height; y++) {
+        const uint16_t* row = framebuffer + y * fb_width;
+        for(lv_coord_t x = 0; x < fb_width; x++) headless_put_u16(file, row[x]);
+        for(uint32_t pad = fb_width * 2; pad < stride; pad++) fputc(0, file);
+    }
+
+    bool ok = !ferror(file);
+    fclose(file);
+
+    if(ok) {
+        LOG_VERBOSE(TAG_TFT, F("Framebuffer written to %s"), filename);
+    } else {
+        LOG_ERROR(TAG_TFT, F("Failed to write %s"), filename);
+    }
+    return ok;
+}
+
+} // namespace dev
+
+dev::TftHeadless haspTft;
+
+#endif // POSIX
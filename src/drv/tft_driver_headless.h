@@ -0,0 +1,104 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_HEADLESS_DRIVER_H
+#define HASP_HEADLESS_DRIVER_H
+
+#include "lvgl.h"
+
+#include "tft_driver.h"
+#include "dev/device.h"
+#include "hasp_debug.h"
+
+#ifndef HEADLESS_FRAME_HISTORY
+#define HEADLESS_FRAME_HISTORY 64 // number of frames kept for inspection
+#endif
+
+#define HEADLESS_AREA_BUCKETS 8 // dirty area sizes < 64, 256, 1k, 4k, 16k, 64k, 256k and larger
+
+namespace dev {
+
+/* Metrics of one render pass */
+struct headless_frame_t
+{
+    uint32_t render_us;    // time spent in the render pass
+    uint32_t flushes;      // number of flush_cb calls
+    uint32_t pixels;       // pixels pushed to the framebuffer
+    uint32_t largest_area; // pixels in the largest flushed area
+};
+
+/* Totals since the last reset */
+struct headless_stats_t
+{
+    uint32_t frames;      // render passes that flushed pixels
+    uint32_t idle_passes; // render passes without anything to redraw
+    uint64_t flushes;
+    uint64_t pixels;
+    uint64_t render_us;
+    uint32_t render_us_max;
+    uint32_t area_buckets[HEADLESS_AREA_BUCKETS]; // histogram of the flushed area sizes
+};
+
+/* Display driver without a screen, for host builds that run without a windowing system
+ * The pixels are kept in an in-memory RGB565 framebuffer and every render pass is measured */
+class TftHeadless : BaseTft {
+  public:
+    void init(int w, int h);
+    void show_info();
+
+    void set_rotation(uint8_t rotation)
+    {}
+    void set_invert(bool invert)
+    {}
+    static void flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p);
+    void flush_poll()
+    {}
+    void flush_sync()
+    {}
+    bool is_driver_pin(uint8_t pin)
+    {
+        return false;
+    }
+
+    /* ===== Render Metrics ===== */
+    void task_handler();
+    void frame_begin();
+    void frame_end();
+    const headless_frame_t* get_frame(uint16_t age = 0);
+    const headless_stats_t& get_stats();
+    void reset_stats();
+    void log_stats();
+
+    /* ===== Framebuffer ===== */
+    const uint16_t* get_framebuffer()
+    {
+        return framebuffer;
+    }
+    lv_coord_t get_width()
+    {
+        return fb_width;
+    }
+    lv_coord_t get_height()
+    {
+        return fb_height;
+    }
+    bool dump(const char* filename);
+
+  private:
+    static uint16_t* framebuffer;
+    static lv_coord_t fb_width;
+    static lv_coord_t fb_height;
+
+    static headless_frame_t frame;
+    static headless_stats_t stats;
+    static headless_frame_t history[HEADLESS_FRAME_HISTORY];
+    static uint32_t history_count;
+    static uint32_t frame_start;
+};
+
+} // namespace dev
+
+using dev::TftHeadless;
+extern dev::TftHeadless haspTft;
+
+#endif
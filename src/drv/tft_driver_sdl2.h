@@ -83,6 +83,10 @@ class TftSdl2 : BaseTft {
     {
         monitor_flush(disp, area, color_p);
     }
+    void flush_poll()
+    {}
+    void flush_sync()
+    {}
     bool is_driver_pin(uint8_t pin)
     {
         return false;
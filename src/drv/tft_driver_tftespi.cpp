@@ -10,6 +10,11 @@ void TftEspi::init(int w, int h)
 {
     tft.begin();
     tft.setSwapBytes(true); /* set endianess */
+
+#ifdef USE_DMA_TO_TFT
+    // NOTE: >>>>>> DMA IS FOR SPI DISPLAYS ONLY <<<<<<
+    tft.initDMA(); // Initialise the DMA engine
+#endif
 }
 
 void TftEspi::show_info()
@@ -115,22 +120,59 @@ void TftEspi::set_invert(bool invert)
     tft.invertDisplay(invert);
 }
 
+/**
+ * Push the pixels of an area to the display
+ * @note with DMA the transfer continues in the background and lvgl is told the flush is done by flush_poll(),
+ *       lvgl renders into its other buffer in the meantime when double buffering is enabled
+ */
 void TftEspi::flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
 {
     size_t len = lv_area_get_size(area);
 
+#ifdef USE_DMA_TO_TFT
+    flush_sync(); /* Only one transfer at a time */
+
     /* Update TFT */
     tft.startWrite();                                      /* Start new TFT transaction */
     tft.setWindow(area->x1, area->y1, area->x2, area->y2); /* set the working window */
-#ifdef USE_DMA_TO_TFT
-    tft.pushPixelsDMA((uint16_t*)color_p, len); /* Write words at once */
+    tft.pushPixelsDMA((uint16_t*)color_p, len);            /* Write words at once */
+    flush_disp = disp; /* The transaction is terminated when the transfer completes */
 #else
-    tft.pushPixels((uint16_t*)color_p, len); /* Write words at once */
-#endif
-    tft.endWrite(); /* terminate TFT transaction */
+    /* Update TFT */
+    tft.startWrite();                                      /* Start new TFT transaction */
+    tft.setWindow(area->x1, area->y1, area->x2, area->y2); /* set the working window */
+    tft.pushPixels((uint16_t*)color_p, len);               /* Write words at once */
+    tft.endWrite();                                        /* terminate TFT transaction */
 
     /* Tell lvgl that flushing is done */
     lv_disp_flush_ready(disp);
+#endif
+}
+
+/* Signal lvgl when the pending DMA transfer has completed, does not block */
+void TftEspi::flush_poll()
+{
+#ifdef USE_DMA_TO_TFT
+    if(flush_disp && !tft.dmaBusy()) {
+        tft.endWrite(); /* terminate TFT transaction */
+
+        /* Tell lvgl that flushing is done */
+        lv_disp_drv_t* disp = flush_disp;
+        flush_disp          = NULL;
+        lv_disp_flush_ready(disp);
+    }
+#endif
+}
+
+/* Wait for the pending DMA transfer to complete, needed before something else uses the SPI bus */
+void TftEspi::flush_sync()
+{
+#ifdef USE_DMA_TO_TFT
+    if(flush_disp) {
+        tft.dmaWait();
+        flush_poll();
+    }
+#endif
 }
 
 bool TftEspi::is_driver_pin(uint8_t pin)
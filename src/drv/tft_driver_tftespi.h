@@ -31,10 +31,13 @@ class TftEspi : BaseTft {
     void set_invert(bool invert);
 
     void flush_pixels(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p);
+    void flush_poll();
+    void flush_sync();
     bool is_driver_pin(uint8_t pin);
 
   private:
     TFT_eSPI tft;
+    lv_disp_drv_t* flush_disp; // display waiting for a DMA transfer to complete
 
     void tftOffsetInfo(uint8_t pin, uint8_t x_offset, uint8_t y_offset)
     {
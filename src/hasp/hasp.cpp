@@ -48,7 +48,6 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-// void hasp_background(uint16_t pageid, uint16_t imageid);
 
 /**********************
  *  STATIC VARIABLES
@@ -245,7 +244,7 @@ void haspReconnect()
 void haspProgressVal(uint8_t val)
 {
     lv_obj_t* layer = lv_disp_get_layer_sys(NULL);
-    lv_obj_t* bar   = hasp_find_obj_from_parent_id(get_page_obj(255), (uint8_t)10);
+    lv_obj_t* bar   = hasp_find_obj_from_page_id(255, (uint8_t)10);
     if(layer && bar) {
         if(val == 255) {
             if(!lv_obj_get_hidden(bar)) {
@@ -274,7 +273,7 @@ void haspProgressVal(uint8_t val)
 // Sets the value string of the global progress bar
 void haspProgressMsg(const char* msg)
 {
-    lv_obj_t* bar = hasp_find_obj_from_parent_id(get_page_obj(255), (uint8_t)10);
+    lv_obj_t* bar = hasp_find_obj_from_page_id(255, (uint8_t)10);
 
     if(bar) {
         char value_str[10];
@@ -465,6 +464,7 @@ void haspSetup(void)
 #endif
 
     haspLoadPage(haspPagesPath);
+    hasp_rules_load_file(HASP_RULES_FILE);
     haspSetPage(haspStartPage);
 }
 
@@ -472,60 +472,12 @@ void haspSetup(void)
  *   STATIC FUNCTIONS
  **********************/
 
-void haspLoop(void)
+// Returns the time in ms until the gui needs to run again
+uint32_t haspLoop(void)
 {
-    dispatchLoop();
+    return dispatchLoop();
 }
 
-/*
-void hasp_background(uint16_t pageid, uint16_t imageid)
-{
-    lv_obj_t * page = get_page_obj(pageid);
-    if(!page) return;
-
-    return;
-
-    page               = lv_scr_act();
-    lv_obj_t * thisobj = lv_obj_get_child_back(page, NULL);
-
-    if(!thisobj) return;
-
-    switch (imageid)
-    {
-    case 0:
-        lv_img_set_src(thisobj, &frame00);
-        break;
-    case 1:
-        lv_img_set_src(thisobj, &frame02);
-        break;
-    case 2:
-        lv_img_set_src(thisobj, &frame04);
-        break;
-    case 3:
-        lv_img_set_src(thisobj, &frame06);
-        break;
-    case 4:
-        lv_img_set_src(thisobj, &frame08);
-        break;
-    case 5:
-        lv_img_set_src(thisobj, &frame10);
-        break;
-    case 6:
-        lv_img_set_src(thisobj, &frame12);
-        break;
-    case 7:
-        lv_img_set_src(thisobj, &frame14);
-        break;
-    }
-    //printf("Image set to %u\n", imageid);
-
-    lv_img_set_auto_size(thisobj, false);
-    lv_obj_set_width(thisobj, lv_disp_get_hor_res(NULL));
-    lv_obj_set_height(thisobj, lv_disp_get_ver_res(NULL));
-    // lv_obj_set_protect(wp, LV_PROTECT_POS);
-    // lv_obj_invalidate(thisobj);
-}*/
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void haspGetVersion(char* version, size_t len)
@@ -543,6 +495,7 @@ void haspClearPage(uint16_t pageid)
     } else {
         LOG_TRACE(TAG_HASP, F(D_HASP_CLEAR_PAGE), pageid);
         lv_obj_clean(page);
+        hasp_object_registry_clear(pageid);
     }
 }
 
@@ -574,18 +527,58 @@ void haspLoadPage(const char* pagesfile)
         return;
     }
 
-    if(!HASP_FS.exists(pagesfile)) {
+    /* Prefer the compiled pages file unless the jsonl source is known to be newer */
+    char binfile[sizeof(haspPagesPath)];
+    strncpy(binfile, pagesfile, sizeof(binfile) - 5);
+    binfile[sizeof(binfile) - 5] = '\0';
+    char* ext                    = strrchr(binfile, '.');
+    if(ext) *ext = '\0';
+    strcat(binfile, ".bin");
+
+    bool has_jsonl = HASP_FS.exists(pagesfile);
+    bool has_bin   = strcmp(binfile, pagesfile) && HASP_FS.exists(binfile);
+
+    if(!has_jsonl && !has_bin) {
         LOG_ERROR(TAG_HASP, F("Non existing file %s"), pagesfile);
         return;
     }
 
-    LOG_TRACE(TAG_HASP, F("Loading file %s"), pagesfile);
+    uint32_t start = millis();
+    size_t heap    = haspDevice.get_free_heap();
+    bool loaded    = false;
+
+    if(has_bin) {
+        File bin = HASP_FS.open(binfile, "r");
+        if(has_jsonl) {
+            File jsonl        = HASP_FS.open(pagesfile, "r");
+            time_t bin_time   = bin.getLastWrite();
+            time_t jsonl_time = jsonl.getLastWrite();
+            jsonl.close();
+
+            /* SPIFFS has no timestamps, an unknown time keeps the compiled file */
+            has_bin = bin_time == 0 || jsonl_time == 0 || bin_time >= jsonl_time;
+            if(!has_bin) LOG_TRACE(TAG_HASP, F("Skipping %s, %s is newer"), binfile, pagesfile);
+        }
+        if(has_bin) {
+            LOG_TRACE(TAG_HASP, F("Loading file %s"), binfile);
+            loaded = hasp_pagebin_load(bin);
+            if(loaded) pagesfile = binfile;
+        }
+        bin.close();
+    }
 
-    File file = HASP_FS.open(pagesfile, "r");
-    dispatch_parse_jsonl(file);
-    file.close();
+    if(!loaded && has_jsonl) {
+        LOG_TRACE(TAG_HASP, F("Loading file %s"), pagesfile);
+        File file = HASP_FS.open(pagesfile, "r");
+        dispatch_parse_jsonl(file);
+        file.close();
+        loaded = true;
+    }
 
-    LOG_INFO(TAG_HASP, F("File %s loaded"), pagesfile);
+    if(loaded) {
+        LOG_INFO(TAG_HASP, F("File %s loaded in %u ms, %d bytes of heap used"), pagesfile, millis() - start,
+                 (int)(heap - haspDevice.get_free_heap()));
+    }
 #else
 
 #if HASP_USE_EEPROM > 0
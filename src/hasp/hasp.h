@@ -50,7 +50,7 @@ extern "C" {
  * Create a hasp application
  */
 void haspSetup(void);
-void haspLoop(void);
+uint32_t haspLoop(void);
 void haspEverySecond(void);
 
 void haspReconnect(void);
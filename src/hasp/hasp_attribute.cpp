@@ -16,6 +16,181 @@ LV_FONT_DECLARE(unscii_8_icon);
 extern lv_font_t* haspFonts[8];
 extern const char** btnmatrix_default_map; // memory pointer to lvgl default btnmatrix map
 
+// ##################### Attribute Lookup ########################################################
+
+/* sdbm hashes of all attribute names, indexed by ATTR_ id */
+static constexpr uint16_t attr_hashes[] = {
+#define HASP_ATTRIBUTE_HASH(name) Utilities::get_sdbm_const(#name),
+    HASP_ATTRIBUTE_LIST(HASP_ATTRIBUTE_HASH)
+#undef HASP_ATTRIBUTE_HASH
+};
+
+static constexpr bool attr_hash_is_unique(uint8_t id, uint8_t other)
+{
+    return other >= ATTR_UNKNOWN || (attr_hashes[id] != attr_hashes[other] && attr_hash_is_unique(id, other + 1));
+}
+
+static constexpr bool attr_hashes_are_unique(uint8_t id = 0)
+{
+    return id >= ATTR_UNKNOWN || (attr_hash_is_unique(id, id + 1) && attr_hashes_are_unique(id + 1));
+}
+
+/* Open addressing table from hash to ATTR_ id + 1, 0 means empty */
+#define HASP_ATTR_SLOTS 256u
+static uint8_t attr_slots[HASP_ATTR_SLOTS];
+static bool attr_slots_ready = false;
+
+static_assert(sizeof(attr_hashes) / sizeof(attr_hashes[0]) == ATTR_UNKNOWN, "Attribute hash table size mismatch");
+static_assert(ATTR_UNKNOWN <= HASP_ATTR_SLOTS * 3 / 4, "Too many attributes for the lookup table, increase HASP_ATTR_SLOTS");
+static_assert(attr_hashes_are_unique(), "Two attribute names have the same hash, rename one of them");
+
+static void hasp_attribute_build_lookup()
+{
+    for(uint8_t id = 0; id < ATTR_UNKNOWN; id++) {
+        uint8_t slot = attr_hashes[id] % HASP_ATTR_SLOTS;
+        while(attr_slots[slot]) slot = (slot + 1) % HASP_ATTR_SLOTS;
+        attr_slots[slot] = id + 1;
+    }
+    attr_slots_ready = true;
+}
+
+/**
+ * Find the ATTR_ id of an attribute hash
+ * @param hash uint16_t: the sdbm hash of the attribute name
+ * @return the ATTR_ id or ATTR_UNKNOWN
+ */
+static uint8_t hasp_attribute_id(uint16_t hash)
+{
+    if(!attr_slots_ready) hasp_attribute_build_lookup();
+
+    uint8_t slot = hash % HASP_ATTR_SLOTS;
+    while(uint8_t id = attr_slots[slot]) {
+        if(attr_hashes[id - 1] == hash) return id - 1;
+        slot = (slot + 1) % HASP_ATTR_SLOTS;
+    }
+    return ATTR_UNKNOWN;
+}
+
+/**
+ * Hash an attribute name once, also returning the hash without the trailing part index digit
+ * @param attr char*: the attribute name without leading "."
+ * @param hash_noindex uint16_t&: the hash of the attribute name without the index number
+ * @return the sdbm hash of the full attribute name
+ */
+static uint16_t hasp_attribute_hash(const char* attr, uint16_t& hash_noindex)
+{
+    uint16_t hash = 0;
+    char last     = 0;
+    char c;
+
+    hash_noindex = 0;
+    while((c = *attr++)) {
+        hash_noindex = hash;
+        hash         = tolower(c) + (hash << 6) - hash;
+        last         = c;
+    }
+    if(!isdigit(last)) hash_noindex = hash; // no trailing index
+    return hash;
+}
+
+// ##################### Redundant Update Suppression ########################################################
+
+/* Updates per ATTR_ id that were skipped because the attribute already had the new value
+ * Skipping the setter also skips the invalidation and redraw of the object */
+static uint32_t attr_suppressed[ATTR_UNKNOWN];
+
+static const char* const attr_names[] = {
+#define HASP_ATTRIBUTE_NAME(name) #name,
+    HASP_ATTRIBUTE_LIST(HASP_ATTRIBUTE_NAME)
+#undef HASP_ATTRIBUTE_NAME
+};
+
+/**
+ * Count a redundant update of an attribute
+ * @param attr_id uint8_t: the ATTR_ id of the attribute
+ * @param unchanged bool: the new value equals the current value
+ * @return unchanged, the caller skips the setter when true
+ */
+bool hasp_attribute_unchanged(uint8_t attr_id, bool unchanged)
+{
+    if(unchanged && attr_id < ATTR_UNKNOWN) attr_suppressed[attr_id]++;
+    return unchanged;
+}
+
+/* The local style of a part holds prop with value for exactly this state, inherited or more general states
+ * don't count. The style getters return the state of the best matching property, which equals state on an
+ * exact match. */
+bool hasp_local_style_has_value(lv_obj_t* obj, uint8_t part, lv_state_t state, lv_style_property_t prop,
+                                int32_t value)
+{
+    lv_style_t* style = lv_obj_get_local_style(obj, part);
+    prop |= state << LV_STYLE_STATE_POS;
+
+    if((prop & 0xF) < LV_STYLE_ID_COLOR) {
+        lv_style_int_t current;
+        return _lv_style_get_int(style, prop, &current) == state && current == value;
+    } else if((prop & 0xF) >= LV_STYLE_ID_OPA && (prop & 0xF) < LV_STYLE_ID_PTR) {
+        lv_opa_t current;
+        return _lv_style_get_opa(style, prop, &current) == state && current == value;
+    }
+    return false;
+}
+
+static bool hasp_local_style_has_color(lv_obj_t* obj, uint8_t part, lv_state_t state, lv_style_property_t prop,
+                                       lv_color_t value)
+{
+    lv_color_t current;
+    prop |= state << LV_STYLE_STATE_POS;
+    return _lv_style_get_color(lv_obj_get_local_style(obj, part), prop, &current) == state &&
+           current.full == value.full;
+}
+
+static bool hasp_local_style_has_ptr(lv_obj_t* obj, uint8_t part, lv_state_t state, lv_style_property_t prop,
+                                     const void* value)
+{
+    const void* current;
+    prop |= state << LV_STYLE_STATE_POS;
+    return _lv_style_get_ptr(lv_obj_get_local_style(obj, part), prop, &current) == state && current == value;
+}
+
+static bool hasp_local_style_has_str(lv_obj_t* obj, uint8_t part, lv_state_t state, lv_style_property_t prop,
+                                     const char* value)
+{
+    const void* current;
+    prop |= state << LV_STYLE_STATE_POS;
+    if(_lv_style_get_ptr(lv_obj_get_local_style(obj, part), prop, &current) != state) return false;
+    return current ? !strcmp((const char*)current, value) : !*value;
+}
+
+// JSON object with the number of suppressed updates of each attribute that had any
+size_t hasp_attribute_get_suppressed(char* buffer, size_t size)
+{
+    size_t len    = 0;
+    buffer[len++] = '{';
+
+    for(uint8_t id = 0; id < ATTR_UNKNOWN && len < size; id++) {
+        if(!attr_suppressed[id]) continue;
+
+        char name[24];
+        uint8_t i = 0;
+        for(const char* c = attr_names[id]; *c && i < sizeof(name) - 1; c++) name[i++] = tolower(*c);
+        name[i] = 0;
+
+        len += snprintf_P(buffer + len, size - len, PSTR("%s\"%s\":%u"), len > 1 ? "," : "", name,
+                          attr_suppressed[id]);
+    }
+
+    if(len + 1 >= size) len = size - 2; // truncated
+    buffer[len++] = '}';
+    buffer[len]   = 0;
+    return len;
+}
+
+void hasp_attribute_reset_suppressed()
+{
+    memset(attr_suppressed, 0, sizeof(attr_suppressed));
+}
+
 #if 0
 static bool attribute_lookup_lv_property(uint16_t hash, uint8_t * prop)
 {
@@ -449,10 +624,8 @@ static inline lv_color_t haspLogColor(lv_color_t color)
     return color;
 }
 
-static lv_font_t* haspPayloadToFont(const char* payload)
+static lv_font_t* haspIdToFont(uint8_t var)
 {
-    uint8_t var = atoi(payload);
-
     switch(var) {
         case 0:
         case 1:
@@ -492,6 +665,11 @@ static lv_font_t* haspPayloadToFont(const char* payload)
     }
 }
 
+static inline lv_font_t* haspPayloadToFont(const char* payload)
+{
+    return haspIdToFont(atoi(payload));
+}
+
 static void gauge_format_10(lv_obj_t* gauge, char* buf, int bufsize, int32_t value)
 {
     snprintf(buf, bufsize, PSTR("%d"), value / 10);
@@ -569,12 +747,20 @@ lv_obj_t* FindButtonLabel(lv_obj_t* btn)
     return NULL;
 }
 
+// Only set the text when it changed, lv_label_set_text always reallocates and redraws
+static inline void my_label_set_text(lv_obj_t* label, const char* text)
+{
+    const char* current = lv_label_get_text(label);
+    if(hasp_attribute_unchanged(ATTR_TEXT, current && !strcmp(current, text))) return;
+    lv_label_set_text(label, text);
+}
+
 // OK
 static inline void haspSetLabelText(lv_obj_t* obj, const char* value)
 {
     lv_obj_t* label = FindButtonLabel(obj);
     if(label) {
-        lv_label_set_text(label, value);
+        my_label_set_text(label, value);
     }
 }
 
@@ -705,306 +891,386 @@ static void hasp_attribute_get_part_state(lv_obj_t* obj, const char* attr_in, ch
     // }
 }
 
+// The style property of a color attribute, false if attr_id is not a color attribute
+static bool hasp_local_style_color_prop(uint8_t attr_id, lv_style_property_t& prop)
+{
+    switch(attr_id) {
+        case ATTR_BG_COLOR:
+            prop = LV_STYLE_BG_COLOR;
+            break;
+        case ATTR_BG_GRAD_COLOR:
+            prop = LV_STYLE_BG_GRAD_COLOR;
+            break;
+        case ATTR_SCALE_GRAD_COLOR:
+            prop = LV_STYLE_SCALE_GRAD_COLOR;
+            break;
+        case ATTR_SCALE_END_COLOR:
+            prop = LV_STYLE_SCALE_END_COLOR;
+            break;
+        case ATTR_TEXT_COLOR:
+            prop = LV_STYLE_TEXT_COLOR;
+            break;
+        case ATTR_TEXT_SEL_COLOR:
+            prop = LV_STYLE_TEXT_SEL_COLOR;
+            break;
+        case ATTR_BORDER_COLOR:
+            prop = LV_STYLE_BORDER_COLOR;
+            break;
+        case ATTR_OUTLINE_COLOR:
+            prop = LV_STYLE_OUTLINE_COLOR;
+            break;
+#if LV_USE_SHADOW
+        case ATTR_SHADOW_COLOR:
+            prop = LV_STYLE_SHADOW_COLOR;
+            break;
+#endif
+        case ATTR_LINE_COLOR:
+            prop = LV_STYLE_LINE_COLOR;
+            break;
+        case ATTR_VALUE_COLOR:
+            prop = LV_STYLE_VALUE_COLOR;
+            break;
+        case ATTR_PATTERN_RECOLOR:
+            prop = LV_STYLE_PATTERN_RECOLOR;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+// Set a color property of the local style
+static void hasp_local_style_set_color(lv_obj_t* obj, uint8_t part, lv_state_t state, uint8_t attr_id,
+                                       lv_style_property_t prop, lv_color_t color)
+{
+    if(part == 64 && (attr_id == ATTR_BG_COLOR || attr_id == ATTR_SCALE_GRAD_COLOR)) return;
+    if(hasp_attribute_unchanged(attr_id, hasp_local_style_has_color(obj, part, state, prop, color))) return;
+    _lv_obj_set_style_local_color(obj, part, prop | (state << LV_STYLE_STATE_POS), color);
+}
+
+// Set or get a color property of the local style
+static void hasp_local_style_color(lv_obj_t* obj, uint8_t part, lv_state_t state, bool update, const char* attr,
+                                   uint8_t attr_id, lv_style_property_t prop, const char* payload)
+{
+    if(update) {
+        lv_color32_t c;
+        if(!Parser::haspPayloadToColor(payload, c)) return;
+        hasp_local_style_set_color(obj, part, state, attr_id, prop, lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
+    } else {
+        hasp_out_color(obj, attr, _lv_obj_get_style_color(obj, part, prop));
+    }
+}
+
+// Set the font of the local style
+static void hasp_local_style_text_font(lv_obj_t* obj, uint8_t part, lv_state_t state, uint8_t attr_id, lv_font_t* font)
+{
+    if(hasp_attribute_unchanged(attr_id, hasp_local_style_has_ptr(obj, part, state, LV_STYLE_TEXT_FONT, font))) return;
+
+    uint8_t count = 3;
+    if(check_obj_type(obj, LV_HASP_ROLLER)) count = my_roller_get_visible_row_count(obj);
+    lv_obj_set_style_local_text_font(obj, part, state, font);
+    if(check_obj_type(obj, LV_HASP_ROLLER)) lv_roller_set_visible_row_count(obj, count);
+    lv_obj_set_style_local_text_font(obj, part, state, font); // again, for roller
+
+    if(check_obj_type(obj, LV_HASP_DROPDOWN)) { // issue #43
+        lv_obj_set_style_local_text_font(obj, LV_DROPDOWN_PART_MAIN, state, font);
+        lv_obj_set_style_local_text_font(obj, LV_DROPDOWN_PART_LIST, state, font);
+        lv_obj_set_style_local_text_font(obj, LV_DROPDOWN_PART_SELECTED, state, font);
+    };
+}
+
 /**
- * Change or Retrieve the value of a local attribute of an object PART
+ * Change or Retrieve an integer property of the local style of an object PART
  * @param obj lv_obj_t*: the object to get/set the attribute
  * @param attr_p char*: the attribute name (with or without leading ".")
- * @param attr_hash uint16_t: the sbdm hash of the attribute name without leading "."
- * @param payload char*: the new value of the attribute
+ * @param attr_id uint8_t: the ATTR_ id of the attribute name without leading "." and index number
+ * @param part uint8_t: the part of the object
+ * @param state uint8_t: the state of the part
  * @param update  bool: change/set the value if true, dispatch/get value if false
- * @note setting a value won't return anything, getting will dispatch the value
+ * @param var int16_t: the new value of the attribute
+ * @return false if attr_id is not an integer property
  */
-static void hasp_local_style_attr(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash, const char* payload,
-                                  bool update)
+static bool hasp_local_style_int(lv_obj_t* obj, const char* attr_p, uint8_t attr_id, uint8_t part, uint8_t state,
+                                 bool update, int16_t var)
 {
-    char attr[32];
-    uint8_t part  = LV_OBJ_PART_MAIN;
-    uint8_t state = LV_STATE_DEFAULT;
-    int16_t var   = atoi(payload);
-
-    // test_prop(attr_hash);
-
-    hasp_attribute_get_part_state(obj, attr_p, attr, part, state);
-    attr_hash = Utilities::get_sdbm(attr); // attribute name without the index number
-
-    /* ***** WARNING ****************************************************
-     * when using hasp_out use attr_p for the original attribute name
-     * *************************************************************** */
-
-    switch(attr_hash) {
+    switch(attr_id) {
 
 /* 1: Use other blend modes than normal (`LV_BLEND_MODE_...`)*/
 #if LV_USE_BLEND_MODES
         case ATTR_BG_BLEND_MODE:
-            return attribute_bg_blend_mode(obj, part, state, update, attr_p, (lv_blend_mode_t)var);
+            attribute_bg_blend_mode(obj, part, state, update, attr_p, (lv_blend_mode_t)var);
+            break;
         case ATTR_TEXT_BLEND_MODE:
-            return lv_obj_set_style_local_text_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            lv_obj_set_style_local_text_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            break;
         case ATTR_BORDER_BLEND_MODE:
-            return lv_obj_set_style_local_border_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            lv_obj_set_style_local_border_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            break;
         case ATTR_OUTLINE_BLEND_MODE:
-            return lv_obj_set_style_local_outline_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            lv_obj_set_style_local_outline_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            break;
         case ATTR_SHADOW_BLEND_MODE:
-            return lv_obj_set_style_local_shadow_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            lv_obj_set_style_local_shadow_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            break;
         case ATTR_LINE_BLEND_MODE:
-            return lv_obj_set_style_local_line_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            lv_obj_set_style_local_line_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            break;
         case ATTR_VALUE_BLEND_MODE:
-            return lv_obj_set_style_local_value_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            lv_obj_set_style_local_value_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            break;
         case ATTR_PATTERN_BLEND_MODE:
-            return lv_obj_set_style_local_pattern_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            lv_obj_set_style_local_pattern_blend_mode(obj, part, state, (lv_blend_mode_t)var);
+            break;
 #endif
 
         case ATTR_SIZE:
-            return attribute_size(obj, part, state, update, attr_p, var);
+            attribute_size(obj, part, state, update, attr_p, var);
+            break;
         case ATTR_RADIUS:
-            return attribute_radius(obj, part, state, update, attr_p, var);
+            attribute_radius(obj, part, state, update, attr_p, var);
+            break;
         case ATTR_CLIP_CORNER:
-            return attribute_clip_corner(obj, part, state, update, attr_p, var);
+            attribute_clip_corner(obj, part, state, update, attr_p, var);
+            break;
         case ATTR_OPA_SCALE:
-            return attribute_opa_scale(obj, part, state, update, attr_p, (lv_opa_t)var);
+            attribute_opa_scale(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
         case ATTR_TRANSFORM_WIDTH:
-            return attribute_transform_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_transform_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_TRANSFORM_HEIGHT:
-            return attribute_transform_height(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_transform_height(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
 
             /* Background attributes */
         case ATTR_BG_MAIN_STOP:
-            return attribute_bg_main_stop(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_bg_main_stop(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_BG_GRAD_STOP:
-            return attribute_bg_grad_stop(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_bg_grad_stop(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_BG_GRAD_DIR:
-            return attribute_bg_grad_dir(obj, part, state, update, attr_p, (lv_grad_dir_t)var);
-        case ATTR_BG_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c) && part != 64)
-                    lv_obj_set_style_local_bg_color(obj, part, state, lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_bg_color(obj, part));
-            }
-            return;
-        }
-        case ATTR_BG_GRAD_COLOR:
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_bg_grad_color(obj, part, state,
-                                                         lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_bg_grad_color(obj, part));
-            }
-            return;
+            attribute_bg_grad_dir(obj, part, state, update, attr_p, (lv_grad_dir_t)var);
+            break;
 
         case ATTR_BG_OPA:
-            return attribute_bg_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            attribute_bg_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
 
         /* Margin attributes */
         case ATTR_MARGIN_TOP:
-            return attribute_margin_top(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_margin_top(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_MARGIN_BOTTOM:
-            return attribute_margin_bottom(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_margin_bottom(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_MARGIN_LEFT:
-            return attribute_margin_left(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_margin_left(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_MARGIN_RIGHT:
-            return attribute_margin_right(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_margin_right(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
 
         /* Padding attributes */
         case ATTR_PAD_TOP:
-            return attribute_pad_top(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_pad_top(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_PAD_BOTTOM:
-            return attribute_pad_bottom(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_pad_bottom(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_PAD_LEFT:
-            return attribute_pad_left(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_pad_left(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_PAD_RIGHT:
-            return attribute_pad_right(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_pad_right(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
 #if LVGL_VERSION_MAJOR == 7
         case ATTR_PAD_INNER:
-            return attribute_pad_inner(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_pad_inner(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
 #endif
 
         /* Scale attributes */
-        case ATTR_SCALE_GRAD_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c) && part != 64)
-                    lv_obj_set_style_local_scale_grad_color(obj, part, state,
-                                                            lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_scale_grad_color(obj, part));
-            }
-            return;
-        }
-        case ATTR_SCALE_END_COLOR:
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_scale_end_color(obj, part, state,
-                                                           lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_scale_end_color(obj, part));
-            }
-            return;
         case ATTR_SCALE_END_LINE_WIDTH:
-            return attribute_scale_end_line_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_scale_end_line_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_SCALE_END_BORDER_WIDTH:
-            return attribute_scale_end_border_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_scale_end_border_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_SCALE_BORDER_WIDTH:
-            return attribute_scale_border_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_scale_border_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_SCALE_WIDTH:
-            return attribute_scale_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_scale_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
 
         /* Text attributes */
         case ATTR_TEXT_LETTER_SPACE:
-            return attribute_text_letter_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_text_letter_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_TEXT_LINE_SPACE:
-            return attribute_text_line_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_text_line_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_TEXT_DECOR:
-            return attribute_text_decor(obj, part, state, update, attr_p, (lv_text_decor_t)var);
+            attribute_text_decor(obj, part, state, update, attr_p, (lv_text_decor_t)var);
+            break;
         case ATTR_TEXT_OPA:
-            return attribute_text_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
-        case ATTR_TEXT_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_text_color(obj, part, state, lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_text_color(obj, part));
-            }
-            return;
-        }
-        case ATTR_TEXT_SEL_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_text_sel_color(obj, part, state,
-                                                          lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_text_sel_color(obj, part));
-            }
-            return;
-        }
+            attribute_text_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
+
         case ATTR_TEXT_FONT: {
-            lv_font_t* font = haspPayloadToFont(payload);
+            lv_font_t* font = haspIdToFont(var);
             if(font) {
-                uint8_t count = 3;
-                if(check_obj_type(obj, LV_HASP_ROLLER)) count = my_roller_get_visible_row_count(obj);
-                lv_obj_set_style_local_text_font(obj, part, state, font);
-                if(check_obj_type(obj, LV_HASP_ROLLER)) lv_roller_set_visible_row_count(obj, count);
-                lv_obj_set_style_local_text_font(obj, part, state, font); // again, for roller
-
-                if(check_obj_type(obj, LV_HASP_DROPDOWN)) { // issue #43
-                    lv_obj_set_style_local_text_font(obj, LV_DROPDOWN_PART_MAIN, state, font);
-                    lv_obj_set_style_local_text_font(obj, LV_DROPDOWN_PART_LIST, state, font);
-                    lv_obj_set_style_local_text_font(obj, LV_DROPDOWN_PART_SELECTED, state, font);
-                };
-
+                hasp_local_style_text_font(obj, part, state, attr_id, font);
             } else {
-                LOG_WARNING(TAG_ATTR, F("Unknown Font ID %s"), payload);
+                LOG_WARNING(TAG_ATTR, F("Unknown Font ID %d"), var);
             }
-            return;
+            break;
         }
 
         /* Border attributes */
         case ATTR_BORDER_WIDTH:
-            return attribute_border_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_border_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_BORDER_SIDE:
-            return attribute_border_side(obj, part, state, update, attr_p, (lv_border_side_t)var);
-        case ATTR_BORDER_POST:
-            return attribute_border_post(obj, part, state, update, attr_p, Utilities::is_true(payload));
+            attribute_border_side(obj, part, state, update, attr_p, (lv_border_side_t)var);
+            break;
         case ATTR_BORDER_OPA:
-            return attribute_border_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
-        case ATTR_BORDER_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_border_color(obj, part, state,
-                                                        lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_border_color(obj, part));
-            }
-            return;
-        }
+            attribute_border_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
 
         /* Outline attributes */
         case ATTR_OUTLINE_WIDTH:
-            return attribute_outline_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_outline_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_OUTLINE_PAD:
-            return attribute_outline_pad(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_outline_pad(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_OUTLINE_OPA:
-            return attribute_outline_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
-        case ATTR_OUTLINE_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_outline_color(obj, part, state,
-                                                         lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_outline_color(obj, part));
-            }
-            return;
-        }
+            attribute_outline_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
 
         /* Shadow attributes */
 #if LV_USE_SHADOW
         case ATTR_SHADOW_WIDTH:
-            return attribute_shadow_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_shadow_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_SHADOW_OFS_X:
-            return attribute_shadow_ofs_x(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_shadow_ofs_x(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_SHADOW_OFS_Y:
-            return attribute_shadow_ofs_y(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_shadow_ofs_y(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_SHADOW_SPREAD:
-            return attribute_shadow_spread(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_shadow_spread(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_SHADOW_OPA:
-            return attribute_shadow_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
-        case ATTR_SHADOW_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_shadow_color(obj, part, state,
-                                                        lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_shadow_color(obj, part));
-            }
-            return;
-        }
+            attribute_shadow_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
 #endif
 
         /* Line attributes */
         case ATTR_LINE_WIDTH:
-            return attribute_line_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_line_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_LINE_DASH_WIDTH:
-            return attribute_line_dash_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_line_dash_width(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_LINE_DASH_GAP:
-            return attribute_line_dash_gap(obj, part, state, update, attr_p, (lv_style_int_t)var);
-        case ATTR_LINE_ROUNDED:
-            return attribute_line_rounded(obj, part, state, update, attr_p, Utilities::is_true(payload));
+            attribute_line_dash_gap(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_LINE_OPA:
-            return attribute_line_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
-        case ATTR_LINE_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_line_color(obj, part, state, lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_line_color(obj, part));
-            }
-            return;
-        }
+            attribute_line_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
 
         /* Value attributes */
         case ATTR_VALUE_LETTER_SPACE:
-            return attribute_value_letter_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_value_letter_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_VALUE_LINE_SPACE:
-            return attribute_value_line_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_value_line_space(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_VALUE_OFS_X:
-            return attribute_value_ofs_x(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_value_ofs_x(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_VALUE_OFS_Y:
-            return attribute_value_ofs_y(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            attribute_value_ofs_y(obj, part, state, update, attr_p, (lv_style_int_t)var);
+            break;
         case ATTR_VALUE_ALIGN:
-            return attribute_value_align(obj, part, state, update, attr_p, (lv_align_t)var);
+            attribute_value_align(obj, part, state, update, attr_p, (lv_align_t)var);
+            break;
         case ATTR_VALUE_OPA:
-            return attribute_value_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            attribute_value_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
+
+        /* Pattern attributes */
+        case ATTR_PATTERN_OPA:
+            attribute_pattern_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
+        case ATTR_PATTERN_RECOLOR_OPA:
+            attribute_pattern_recolor_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
+            break;
+
+            /* Image attributes */
+            // Todo
+
+            /* Scale attributes */
+            // Todo
+
+            /* Transition attributes */
+            // Todo
+
+        default:
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Change or Retrieve the value of a local attribute of an object PART
+ * @param obj lv_obj_t*: the object to get/set the attribute
+ * @param attr_p char*: the attribute name (with or without leading ".")
+ * @param attr_id uint8_t: the ATTR_ id of the attribute name without leading "." and index number
+ * @param payload char*: the new value of the attribute
+ * @param update  bool: change/set the value if true, dispatch/get value if false
+ * @note setting a value won't return anything, getting will dispatch the value
+ */
+static void hasp_local_style_attr(lv_obj_t* obj, const char* attr_p, uint8_t attr_id, const char* payload,
+                                  bool update)
+{
+    char attr[32];
+    uint8_t part  = LV_OBJ_PART_MAIN;
+    uint8_t state = LV_STATE_DEFAULT;
+    int16_t var   = atoi(payload);
+
+    hasp_attribute_get_part_state(obj, attr_p, attr, part, state);
+
+    /* ***** WARNING ****************************************************
+     * when using hasp_out use attr_p for the original attribute name
+     * *************************************************************** */
+
+    if(hasp_local_style_int(obj, attr_p, attr_id, part, state, update, var)) return;
+
+    lv_style_property_t prop;
+    if(hasp_local_style_color_prop(attr_id, prop))
+        return hasp_local_style_color(obj, part, state, update, attr, attr_id, prop, payload);
+
+    switch(attr_id) {
+        case ATTR_BORDER_POST:
+            return attribute_border_post(obj, part, state, update, attr_p, Utilities::is_true(payload));
+        case ATTR_LINE_ROUNDED:
+            return attribute_line_rounded(obj, part, state, update, attr_p, Utilities::is_true(payload));
+        case ATTR_PATTERN_REPEAT:
+            return attribute_pattern_repeat(obj, part, state, update, attr_p, Utilities::is_true(payload));
+        case ATTR_PATTERN_IMAGE:
+            //   return lv_obj_set_style_local_pattern_image(obj, part, state, (constvoid *)var);
+            break;
+
         case ATTR_VALUE_STR: {
             if(update) {
+                if(hasp_attribute_unchanged(attr_id,
+                                            hasp_local_style_has_str(obj, part, state, LV_STYLE_VALUE_STR, payload)))
+                    return;
 
                 my_obj_set_value_str_txt(obj, part, state, payload);
 
@@ -1029,62 +1295,23 @@ static void hasp_local_style_attr(lv_obj_t* obj, const char* attr_p, uint16_t at
             }
             return;
         }
-        case ATTR_VALUE_COLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_value_color(obj, part, state,
-                                                       lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_value_color(obj, part));
-            }
-            return;
-        }
         case ATTR_VALUE_FONT: {
             lv_font_t* font = haspPayloadToFont(payload);
             if(font) {
+                if(hasp_attribute_unchanged(attr_id,
+                                            hasp_local_style_has_ptr(obj, part, state, LV_STYLE_VALUE_FONT, font)))
+                    return;
                 return lv_obj_set_style_local_value_font(obj, part, state, font);
             } else {
                 LOG_WARNING(TAG_ATTR, F("Unknown Font ID %s"), attr_p);
                 return;
             }
         }
-
-        /* Pattern attributes */
-        case ATTR_PATTERN_REPEAT:
-            return attribute_pattern_repeat(obj, part, state, update, attr_p, Utilities::is_true(payload));
-        case ATTR_PATTERN_OPA:
-            return attribute_pattern_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
-        case ATTR_PATTERN_RECOLOR_OPA:
-            return attribute_pattern_recolor_opa(obj, part, state, update, attr_p, (lv_opa_t)var);
-        case ATTR_PATTERN_IMAGE:
-            //   return lv_obj_set_style_local_pattern_image(obj, part, state, (constvoid *)var);
-            break;
-        case ATTR_PATTERN_RECOLOR: {
-            if(update) {
-                lv_color32_t c;
-                if(Parser::haspPayloadToColor(payload, c))
-                    lv_obj_set_style_local_pattern_recolor(obj, part, state,
-                                                           lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
-            } else {
-                hasp_out_color(obj, attr, lv_obj_get_style_pattern_recolor(obj, part));
-            }
-            return;
-        }
-
-            /* Image attributes */
-            // Todo
-
-            /* Scale attributes */
-            // Todo
-
-            /* Transition attributes */
-            // Todo
     }
-    LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN " (%d)"), attr_p, attr_hash);
+    LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN), attr_p);
 }
 
-static void hasp_process_arc_attribute(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash, const char* payload,
+static void hasp_process_arc_attribute(lv_obj_t* obj, const char* attr_p, uint8_t attr_id, const char* payload,
                                        bool update)
 {
     // We already know it's a arc object
@@ -1094,7 +1321,7 @@ static void hasp_process_arc_attribute(lv_obj_t* obj, const char* attr_p, uint16
     char* attr = (char*)attr_p;
     if(*attr == '.') attr++; // strip leading '.'
 
-    switch(attr_hash) {
+    switch(attr_id) {
         case ATTR_TYPE:
             return (update) ? lv_arc_set_type(obj, val % 3) : hasp_out_int(obj, attr, lv_arc_get_type(obj));
 
@@ -1128,7 +1355,7 @@ static void hasp_process_arc_attribute(lv_obj_t* obj, const char* attr_p, uint16
     LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN), attr_p);
 }
 
-static void hasp_process_lmeter_attribute(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash, const char* payload,
+static void hasp_process_lmeter_attribute(lv_obj_t* obj, const char* attr_p, uint8_t attr_id, const char* payload,
                                           bool update)
 {
     // We already know it's a linemeter object
@@ -1141,7 +1368,7 @@ static void hasp_process_lmeter_attribute(lv_obj_t* obj, const char* attr_p, uin
     char* attr = (char*)attr_p;
     if(*attr == '.') attr++; // strip leading '.'
 
-    switch(attr_hash) {
+    switch(attr_id) {
         case ATTR_TYPE:
             return (update) ? lv_linemeter_set_mirror(obj, val != 0)
                             : hasp_out_int(obj, attr, lv_linemeter_get_mirror(obj));
@@ -1160,7 +1387,7 @@ static void hasp_process_lmeter_attribute(lv_obj_t* obj, const char* attr_p, uin
     LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN), attr_p);
 }
 
-static void hasp_process_gauge_attribute(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash, const char* payload,
+static void hasp_process_gauge_attribute(lv_obj_t* obj, const char* attr_p, uint8_t attr_id, const char* payload,
                                          bool update)
 {
     // We already know it's a gauge object
@@ -1174,7 +1401,7 @@ static void hasp_process_gauge_attribute(lv_obj_t* obj, const char* attr_p, uint
     char* attr = (char*)attr_p;
     if(*attr == '.') attr++; // strip leading '.'
 
-    switch(attr_hash) {
+    switch(attr_id) {
         case ATTR_CRITICAL_VALUE:
             return (update) ? lv_gauge_set_critical_value(obj, intval)
                             : hasp_out_int(obj, attr, lv_gauge_get_critical_value(obj));
@@ -1236,9 +1463,10 @@ static void hasp_process_obj_attribute_txt(lv_obj_t* obj, const char* attr, cons
         return;
     }
     if(check_obj_type(obj, LV_HASP_LABEL)) {
-        return update ? lv_label_set_text(obj, payload) : hasp_out_str(obj, attr, lv_label_get_text(obj));
+        return update ? my_label_set_text(obj, payload) : hasp_out_str(obj, attr, lv_label_get_text(obj));
     }
     if(check_obj_type(obj, LV_HASP_CHECKBOX)) {
+        if(update && hasp_attribute_unchanged(ATTR_TEXT, !strcmp(lv_checkbox_get_text(obj), payload))) return;
         return update ? lv_checkbox_set_text(obj, payload) : hasp_out_str(obj, attr, lv_checkbox_get_text(obj));
     }
     if(check_obj_type(obj, LV_HASP_DROPDOWN)) {
@@ -1261,9 +1489,30 @@ static void hasp_process_obj_attribute_txt(lv_obj_t* obj, const char* attr, cons
     LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN), attr);
 }
 
-bool hasp_process_obj_attribute_val(lv_obj_t* obj, const char* attr, const char* payload, bool update)
+// The object already has the new val, objects without a val never do
+static bool hasp_obj_val_unchanged(lv_obj_t* obj, int16_t intval, bool on)
 {
-    int16_t intval = atoi(payload);
+    if(check_obj_type(obj, LV_HASP_BUTTON)) {
+        bool checked = lv_obj_get_state(obj, LV_BTN_PART_MAIN) & LV_STATE_CHECKED;
+        return lv_btn_get_checkable(obj) && checked == (intval != 0);
+    }
+    if(check_obj_type(obj, LV_HASP_CHECKBOX)) return lv_checkbox_is_checked(obj) == on;
+    if(check_obj_type(obj, LV_HASP_SWITCH)) return lv_switch_get_state(obj) == on;
+    if(check_obj_type(obj, LV_HASP_DROPDOWN)) return lv_dropdown_get_selected(obj) == (uint16_t)intval;
+    if(check_obj_type(obj, LV_HASP_LMETER)) return lv_linemeter_get_value(obj) == intval;
+    if(check_obj_type(obj, LV_HASP_SLIDER)) return lv_slider_get_value(obj) == intval;
+    if(check_obj_type(obj, LV_HASP_LED)) return lv_led_get_bright(obj) == (uint8_t)intval;
+    if(check_obj_type(obj, LV_HASP_ARC)) return lv_arc_get_value(obj) == intval;
+    if(check_obj_type(obj, LV_HASP_GAUGE)) return lv_gauge_get_value(obj, 0) == intval;
+    if(check_obj_type(obj, LV_HASP_ROLLER)) return lv_roller_get_selected(obj) == (uint16_t)intval;
+    if(check_obj_type(obj, LV_HASP_BAR)) return lv_bar_get_value(obj) == intval;
+    return false;
+}
+
+// Set or get the val of an object, on is the value of checkboxes and switches
+static bool hasp_obj_attribute_val(lv_obj_t* obj, const char* attr, int16_t intval, bool on, bool update)
+{
+    if(update && hasp_attribute_unchanged(ATTR_VAL, hasp_obj_val_unchanged(obj, intval, on))) return true;
 
     if(check_obj_type(obj, LV_HASP_BUTTON)) {
         if(lv_btn_get_checkable(obj)) {
@@ -1279,11 +1528,10 @@ bool hasp_process_obj_attribute_val(lv_obj_t* obj, const char* attr, const char*
             return false; // not checkable
         }
     } else if(check_obj_type(obj, LV_HASP_CHECKBOX)) {
-        update ? lv_checkbox_set_checked(obj, Utilities::is_true(payload))
-               : hasp_out_int(obj, attr, lv_checkbox_is_checked(obj));
+        update ? lv_checkbox_set_checked(obj, on) : hasp_out_int(obj, attr, lv_checkbox_is_checked(obj));
     } else if(check_obj_type(obj, LV_HASP_SWITCH)) {
         if(update)
-            Utilities::is_true(payload) ? lv_switch_on(obj, LV_ANIM_ON) : lv_switch_off(obj, LV_ANIM_ON);
+            on ? lv_switch_on(obj, LV_ANIM_ON) : lv_switch_off(obj, LV_ANIM_ON);
         else
             hasp_out_int(obj, attr, lv_switch_get_state(obj));
     } else if(check_obj_type(obj, LV_HASP_DROPDOWN)) {
@@ -1309,11 +1557,15 @@ bool hasp_process_obj_attribute_val(lv_obj_t* obj, const char* attr, const char*
     return true;
 }
 
-static void hasp_process_obj_attribute_range(lv_obj_t* obj, const char* attr, const char* payload, bool update,
+bool hasp_process_obj_attribute_val(lv_obj_t* obj, const char* attr, const char* payload, bool update)
+{
+    return hasp_obj_attribute_val(obj, attr, atoi(payload), Utilities::is_true(payload), update);
+}
+
+static void hasp_process_obj_attribute_range(lv_obj_t* obj, const char* attr, int32_t val32, bool update,
                                              bool set_min, bool set_max)
 {
-    int16_t val   = atoi(payload);
-    int32_t val32 = strtol(payload, nullptr, DEC);
+    int16_t val = val32;
 
     /* Attributes depending on objecttype */
     // lv_obj_type_t list;
@@ -1371,6 +1623,60 @@ static void hasp_process_obj_attribute_range(lv_obj_t* obj, const char* attr, co
     LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN), attr);
 }
 
+static void hasp_obj_set_id(lv_obj_t* obj, uint8_t id)
+{
+    hasp_object_registry_remove(obj);
+    obj->user_data.id = id;
+    hasp_object_registry_add(obj);
+}
+
+static void hasp_obj_set_groupid(lv_obj_t* obj, uint8_t groupid)
+{
+    hasp_object_group_remove(obj);
+    obj->user_data.groupid = groupid;
+    hasp_object_group_add(obj);
+}
+
+// Set the x, y, w or h of an object
+static void hasp_obj_set_geometry(lv_obj_t* obj, uint8_t attr_id, lv_coord_t val)
+{
+    switch(attr_id) {
+        case ATTR_X:
+            if(!hasp_attribute_unchanged(attr_id, lv_obj_get_x(obj) == val)) lv_obj_set_x(obj, val);
+            return;
+
+        case ATTR_Y:
+            if(!hasp_attribute_unchanged(attr_id, lv_obj_get_y(obj) == val)) lv_obj_set_y(obj, val);
+            return;
+
+        case ATTR_W:
+            if(hasp_attribute_unchanged(attr_id, lv_obj_get_width(obj) == val)) return;
+            lv_obj_set_width(obj, val);
+            break;
+
+        case ATTR_H:
+            if(hasp_attribute_unchanged(attr_id, lv_obj_get_height(obj) == val)) return;
+            lv_obj_set_height(obj, val);
+            break;
+
+        default:
+            return;
+    }
+
+    if(check_obj_type(obj, LV_HASP_CPICKER)) {
+#if LVGL_VERSION_MAJOR == 7
+        lv_cpicker_set_type(obj, lv_obj_get_width(obj) == lv_obj_get_height(obj) ? LV_CPICKER_TYPE_DISC
+                                                                                 : LV_CPICKER_TYPE_RECT);
+#endif
+    }
+}
+
+static void hasp_cpicker_set_color(lv_obj_t* obj, lv_color_t color)
+{
+    if(!hasp_attribute_unchanged(ATTR_COLOR, lv_cpicker_get_color(obj).full == color.full))
+        lv_cpicker_set_color(obj, color);
+}
+
 // ##################### Default Attributes ########################################################
 
 /**
@@ -1382,6 +1688,26 @@ static void hasp_process_obj_attribute_range(lv_obj_t* obj, const char* attr, co
  * @note setting a value won't return anything, getting will dispatch the value
  */
 void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* payload, bool update)
+{
+    const char* attr = attr_p;
+    if(*attr == '.') attr++; // strip leading '.'
+
+    uint16_t attr_hash_noindex;
+    uint16_t attr_hash = hasp_attribute_hash(attr, attr_hash_noindex);
+    hasp_process_obj_attribute_hash(obj, attr, attr_hash, attr_hash_noindex, payload, update);
+}
+
+/**
+ * Change or Retrieve the value of the attribute of an object, using precalculated hashes
+ * @param obj lv_obj_t*: the object to get/set the attribute
+ * @param attr_p char*: the attribute name (with or without leading ".")
+ * @param attr_hash uint16_t: the sdbm hash of the attribute name without leading "."
+ * @param attr_hash_noindex uint16_t: the sdbm hash of the attribute name without the trailing index number
+ * @param payload char*: the new value of the attribute
+ * @param update  bool: change/set the value if true, dispatch/get value if false
+ */
+void hasp_process_obj_attribute_hash(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash,
+                                     uint16_t attr_hash_noindex, const char* payload, bool update)
 {
     // unsigned long start = millis();
     if(!obj) {
@@ -1393,17 +1719,17 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* p
     char* attr = (char*)attr_p;
     if(*attr == '.') attr++; // strip leading '.'
 
-    uint16_t attr_hash = Utilities::get_sdbm(attr);
+    uint8_t attr_id = hasp_attribute_id(attr_hash);
     //    LOG_VERBOSE(TAG_ATTR,"%s => %d", attr, attr_hash);
 
-    /* 16-bit Hash Lookup Table */
-    switch(attr_hash) {
+    /* Dense ATTR_ id Jump Table */
+    switch(attr_id) {
         case ATTR_ID:
-            update ? (void)(obj->user_data.id = (uint8_t)val) : hasp_out_int(obj, attr, obj->user_data.id);
+            update ? hasp_obj_set_id(obj, (uint8_t)val) : hasp_out_int(obj, attr, obj->user_data.id);
             break; // attribute_found
 
         case ATTR_GROUPID:
-            update ? (void)(obj->user_data.groupid = (uint8_t)val) : hasp_out_int(obj, attr, obj->user_data.groupid);
+            update ? hasp_obj_set_groupid(obj, (uint8_t)val) : hasp_out_int(obj, attr, obj->user_data.groupid);
             break; // attribute_found
 
         case ATTR_OBJID:
@@ -1414,40 +1740,35 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* p
             }
             break; // attribute_found
 
+        case ATTR_BIND:
+#if HASP_USE_MQTT > 0
+            if(update) {
+                uint8_t pageid, objid;
+                if(hasp_find_id_from_obj(obj, &pageid, &objid)) mqtt_bind_add(pageid, objid, payload);
+            } else {
+                uint8_t pageid, objid;
+                if(hasp_find_id_from_obj(obj, &pageid, &objid))
+                    hasp_out_int(obj, attr, mqtt_bind_count(pageid, objid));
+            }
+#else
+            LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN), attr_p);
+#endif
+            break; // attribute_found
+
         case ATTR_X:
-            update ? lv_obj_set_x(obj, val) : hasp_out_int(obj, attr, lv_obj_get_x(obj));
+            update ? hasp_obj_set_geometry(obj, attr_id, val) : hasp_out_int(obj, attr, lv_obj_get_x(obj));
             break; // attribute_found
 
         case ATTR_Y:
-            update ? lv_obj_set_y(obj, val) : hasp_out_int(obj, attr, lv_obj_get_y(obj));
+            update ? hasp_obj_set_geometry(obj, attr_id, val) : hasp_out_int(obj, attr, lv_obj_get_y(obj));
             break; // attribute_found
 
         case ATTR_W:
-            if(update) {
-                lv_obj_set_width(obj, val);
-                if(check_obj_type(obj, LV_HASP_CPICKER)) {
-#if LVGL_VERSION_MAJOR == 7
-                    lv_cpicker_set_type(obj, lv_obj_get_width(obj) == lv_obj_get_height(obj) ? LV_CPICKER_TYPE_DISC
-                                                                                             : LV_CPICKER_TYPE_RECT);
-#endif
-                }
-            } else {
-                hasp_out_int(obj, attr, lv_obj_get_width(obj));
-            }
+            update ? hasp_obj_set_geometry(obj, attr_id, val) : hasp_out_int(obj, attr, lv_obj_get_width(obj));
             break; // attribute_found
 
         case ATTR_H:
-            if(update) {
-                lv_obj_set_height(obj, val);
-                if(check_obj_type(obj, LV_HASP_CPICKER)) {
-#if LVGL_VERSION_MAJOR == 7
-                    lv_cpicker_set_type(obj, lv_obj_get_width(obj) == lv_obj_get_height(obj) ? LV_CPICKER_TYPE_DISC
-                                                                                             : LV_CPICKER_TYPE_RECT);
-#endif
-                }
-            } else {
-                hasp_out_int(obj, attr, lv_obj_get_height(obj));
-            }
+            update ? hasp_obj_set_geometry(obj, attr_id, val) : hasp_out_int(obj, attr, lv_obj_get_height(obj));
             break; // attribute_found
 
         case ATTR_VIS:
@@ -1470,7 +1791,7 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* p
                 if(update) {
                     lv_color32_t c;
                     if(Parser::haspPayloadToColor(payload, c))
-                        lv_cpicker_set_color(obj, lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
+                        hasp_cpicker_set_color(obj, lv_color_make(c.ch.red, c.ch.green, c.ch.blue));
                 } else {
                     hasp_out_color(obj, attr, lv_cpicker_get_color(obj));
                 }
@@ -1484,11 +1805,11 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* p
             break; // attribute_found
 
         case ATTR_MIN:
-            hasp_process_obj_attribute_range(obj, attr, payload, update, true, false);
+            hasp_process_obj_attribute_range(obj, attr, strtol(payload, nullptr, DEC), update, true, false);
             break; // attribute_found
 
         case ATTR_MAX:
-            hasp_process_obj_attribute_range(obj, attr, payload, update, false, true);
+            hasp_process_obj_attribute_range(obj, attr, strtol(payload, nullptr, DEC), update, false, true);
             break; // attribute_found
 
         case ATTR_OPACITY:
@@ -1631,24 +1952,16 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* p
         case ATTR_START_ANGLE1:
         case ATTR_END_ANGLE1:
             if(check_obj_type(obj, LV_HASP_ARC)) {
-                hasp_process_arc_attribute(obj, attr_p, attr_hash, payload, update);
+                hasp_process_arc_attribute(obj, attr_p, attr_id, payload, update);
             } else if(check_obj_type(obj, LV_HASP_GAUGE)) {
-                hasp_process_gauge_attribute(obj, attr_p, attr_hash, payload, update);
+                hasp_process_gauge_attribute(obj, attr_p, attr_id, payload, update);
             } else if(check_obj_type(obj, LV_HASP_LMETER)) {
-                hasp_process_lmeter_attribute(obj, attr_p, attr_hash, payload, update);
+                hasp_process_lmeter_attribute(obj, attr_p, attr_id, payload, update);
             } else {
                 goto attribute_not_found;
             }
             break; // attribute_found
 
-        case ATTR_RED: // TODO: remove temp RED
-            if(check_obj_type(obj, LV_HASP_BTNMATRIX)) {
-                my_btnmatrix_map_clear(obj); // TODO : remove this test property
-            } else {
-                goto attribute_not_found;
-            }
-            break;
-
         case ATTR_MAP: // TODO: remove temp MAP, use options instead
             if(check_obj_type(obj, LV_HASP_BTNMATRIX)) {
                 my_btnmatrix_map_create(obj, payload);
@@ -1682,7 +1995,12 @@ void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* p
             break; // attribute_found
 
         default:
-            hasp_local_style_attr(obj, attr, attr_hash, payload, update);
+            if(attr_hash == ATTR_RED && check_obj_type(obj, LV_HASP_BTNMATRIX)) {
+                my_btnmatrix_map_clear(obj); // TODO: remove temp RED test property
+                break;
+            }
+            if(attr_hash_noindex != attr_hash) attr_id = hasp_attribute_id(attr_hash_noindex);
+            hasp_local_style_attr(obj, attr, attr_id, payload, update);
     }
 
 attribute_found:
@@ -1692,4 +2010,98 @@ attribute_found:
 
 attribute_not_found:
     LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN " (%d)"), attr_p, attr_hash);
-}
\ No newline at end of file
+}
+
+/**
+ * Change the attribute of an object to an integer value, using precalculated hashes
+ * @param obj lv_obj_t*: the object to set the attribute
+ * @param attr_p char*: the attribute name without leading "."
+ * @param attr_hash uint16_t: the sdbm hash of the attribute name
+ * @param attr_hash_noindex uint16_t: the sdbm hash of the attribute name without the trailing index number
+ * @param val int32_t: the new value of the attribute
+ * @note attributes that only take text get the value formatted as text
+ */
+void hasp_process_obj_attribute_int(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash,
+                                    uint16_t attr_hash_noindex, int32_t val)
+{
+    if(!obj) {
+        LOG_WARNING(TAG_ATTR, F(D_OBJECT_UNKNOWN));
+        return;
+    }
+
+    uint8_t attr_id = hasp_attribute_id(attr_hash);
+    switch(attr_id) {
+        case ATTR_ID:
+            return hasp_obj_set_id(obj, (uint8_t)val);
+
+        case ATTR_GROUPID:
+            return hasp_obj_set_groupid(obj, (uint8_t)val);
+
+        case ATTR_X:
+        case ATTR_Y:
+        case ATTR_W:
+        case ATTR_H:
+            return hasp_obj_set_geometry(obj, attr_id, val);
+
+        case ATTR_VAL:
+            if(hasp_obj_attribute_val(obj, attr_p, val, val == 1, true)) return;
+            break;
+
+        case ATTR_MIN:
+            return hasp_process_obj_attribute_range(obj, attr_p, val, true, true, false);
+
+        case ATTR_MAX:
+            return hasp_process_obj_attribute_range(obj, attr_p, val, true, false, true);
+
+        case ATTR_OPACITY:
+            return lv_obj_set_style_local_opa_scale(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, val);
+
+        default: {
+            char attr[32];
+            uint8_t part  = LV_OBJ_PART_MAIN;
+            uint8_t state = LV_STATE_DEFAULT;
+            uint8_t id    = attr_hash_noindex != attr_hash ? hasp_attribute_id(attr_hash_noindex) : attr_id;
+
+            hasp_attribute_get_part_state(obj, attr_p, attr, part, state);
+            if(hasp_local_style_int(obj, attr_p, id, part, state, true, val)) return;
+            break;
+        }
+    }
+
+    char payload[12]; // fits "-2147483648"
+    itoa(val, payload, DEC);
+    hasp_process_obj_attribute_hash(obj, attr_p, attr_hash, attr_hash_noindex, payload, true);
+}
+
+/**
+ * Change a color property of the local style of an object, using precalculated hashes
+ * @param obj lv_obj_t*: the object to set the attribute
+ * @param attr_p char*: the attribute name without leading "."
+ * @param attr_hash uint16_t: the sdbm hash of the attribute name
+ * @param attr_hash_noindex uint16_t: the sdbm hash of the attribute name without the trailing index number
+ * @param color lv_color_t: the new color
+ */
+void hasp_process_obj_attribute_color(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash,
+                                      uint16_t attr_hash_noindex, lv_color_t color)
+{
+    if(!obj) {
+        LOG_WARNING(TAG_ATTR, F(D_OBJECT_UNKNOWN));
+        return;
+    }
+
+    uint8_t attr_id = hasp_attribute_id(attr_hash);
+    if(attr_id == ATTR_COLOR && check_obj_type(obj, LV_HASP_CPICKER)) return hasp_cpicker_set_color(obj, color);
+    if(attr_hash_noindex != attr_hash) attr_id = hasp_attribute_id(attr_hash_noindex);
+
+    lv_style_property_t prop;
+    if(hasp_local_style_color_prop(attr_id, prop)) {
+        char attr[32];
+        uint8_t part  = LV_OBJ_PART_MAIN;
+        uint8_t state = LV_STATE_DEFAULT;
+
+        hasp_attribute_get_part_state(obj, attr_p, attr, part, state);
+        return hasp_local_style_set_color(obj, part, state, attr_id, prop, color);
+    }
+
+    LOG_WARNING(TAG_ATTR, F(D_ATTRIBUTE_UNKNOWN), attr_p);
+}
@@ -25,7 +25,13 @@ void my_btnmatrix_map_clear(lv_obj_t* obj);
 void line_clear_points(lv_obj_t* obj);
 
 void hasp_process_obj_attribute(lv_obj_t* obj, const char* attr_p, const char* payload, bool update);
+void hasp_process_obj_attribute_hash(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash,
+                                     uint16_t attr_hash_noindex, const char* payload, bool update);
 bool hasp_process_obj_attribute_val(lv_obj_t* obj, const char* attr, const char* payload, bool update);
+void hasp_process_obj_attribute_int(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash,
+                                    uint16_t attr_hash_noindex, int32_t val);
+void hasp_process_obj_attribute_color(lv_obj_t* obj, const char* attr_p, uint16_t attr_hash,
+                                      uint16_t attr_hash_noindex, lv_color_t color);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -36,11 +42,76 @@ bool hasp_process_obj_attribute_val(lv_obj_t* obj, const char* attr, const char*
 #define hasp_out_str hasp_send_obj_attribute_str
 #define hasp_out_color hasp_send_obj_attribute_color
 
+/* Attribute names, hashed at compile time into a lookup table in hasp_attribute.cpp
+ * The ATTR_ ids are consecutive so the attribute switches can compile into jump tables */
+#define HASP_ATTRIBUTE_LIST(_)                                                                                         \
+    /* Object Part Attributes */                                                                                       \
+    _(SIZE) _(RADIUS) _(CLIP_CORNER) _(OPA_SCALE) _(TRANSFORM_HEIGHT) _(TRANSFORM_WIDTH)                               \
+    /* Background Attributes */                                                                                        \
+    _(BG_OPA) _(BG_COLOR) _(BG_GRAD_DIR) _(BG_GRAD_STOP) _(BG_MAIN_STOP) _(BG_BLEND_MODE) _(BG_GRAD_COLOR)             \
+    /* Margin Attributes */                                                                                            \
+    _(MARGIN_TOP) _(MARGIN_LEFT) _(MARGIN_BOTTOM) _(MARGIN_RIGHT)                                                      \
+    /* Padding Attributes */                                                                                           \
+    _(PAD_TOP) _(PAD_LEFT) _(PAD_INNER) _(PAD_RIGHT) _(PAD_BOTTOM)                                                     \
+    /* Text Attributes */                                                                                              \
+    _(TEXT_OPA) _(TEXT_FONT) _(TEXT_COLOR) _(TEXT_DECOR) _(TEXT_LETTER_SPACE) _(TEXT_SEL_COLOR) _(TEXT_LINE_SPACE)     \
+    _(TEXT_BLEND_MODE)                                                                                                 \
+    /* Border Attributes */                                                                                            \
+    _(BORDER_OPA) _(BORDER_SIDE) _(BORDER_POST) _(BORDER_BLEND_MODE) _(BORDER_WIDTH) _(BORDER_COLOR)                   \
+    /* Outline Attributes */                                                                                           \
+    _(OUTLINE_OPA) _(OUTLINE_PAD) _(OUTLINE_COLOR) _(OUTLINE_BLEND_MODE) _(OUTLINE_WIDTH)                              \
+    /* Shadow Attributes */                                                                                            \
+    _(SHADOW_OPA) _(SHADOW_WIDTH) _(SHADOW_OFS_X) _(SHADOW_OFS_Y) _(SHADOW_SPREAD) _(SHADOW_BLEND_MODE)                \
+    _(SHADOW_COLOR)                                                                                                    \
+    /* Line Attributes */                                                                                              \
+    _(LINE_OPA) _(LINE_WIDTH) _(LINE_COLOR) _(LINE_DASH_WIDTH) _(LINE_ROUNDED) _(LINE_DASH_GAP) _(LINE_BLEND_MODE)     \
+    /* Value Attributes */                                                                                             \
+    _(VALUE_OPA) _(VALUE_STR) _(VALUE_FONT) _(VALUE_ALIGN) _(VALUE_COLOR) _(VALUE_OFS_X) _(VALUE_OFS_Y)                \
+    _(VALUE_LINE_SPACE) _(VALUE_BLEND_MODE) _(VALUE_LETTER_SPACE)                                                      \
+    /* Pattern attributes */                                                                                           \
+    _(PATTERN_BLEND_MODE) _(PATTERN_RECOLOR_OPA) _(PATTERN_RECOLOR) _(PATTERN_REPEAT) _(PATTERN_OPA)                   \
+    _(PATTERN_IMAGE)                                                                                                   \
+    _(TRANSITION_PROP_1) _(TRANSITION_PROP_2) _(TRANSITION_PROP_3) _(TRANSITION_PROP_4) _(TRANSITION_PROP_5)           \
+    _(TRANSITION_PROP_6) _(TRANSITION_TIME) _(TRANSITION_PATH) _(TRANSITION_DELAY)                                     \
+    _(IMAGE_OPA) _(IMAGE_RECOLOR) _(IMAGE_BLEND_MODE) _(IMAGE_RECOLOR_OPA)                                             \
+    _(SCALE_END_LINE_WIDTH) _(SCALE_END_BORDER_WIDTH) _(SCALE_BORDER_WIDTH) _(SCALE_GRAD_COLOR) _(SCALE_WIDTH)         \
+    _(SCALE_END_COLOR)                                                                                                 \
+    /* Object Attributes */                                                                                            \
+    _(X) _(Y) _(W) _(H) _(OPTIONS) _(ENABLED) _(OPACITY) _(TOGGLE) _(HIDDEN) _(VIS) _(MODE) _(ALIGN) _(ROWS) _(COLS)   \
+    _(MIN) _(MAX) _(VAL) _(COLOR) _(TXT) _(TEXT) _(SRC) _(ID)                                                          \
+    /* Methods */                                                                                                      \
+    _(DELETE) _(TO_FRONT) _(TO_BACK)                                                                                   \
+    /* Gauge */                                                                                                        \
+    _(CRITICAL_VALUE) _(ANGLE) _(LABEL_COUNT) _(LINE_COUNT) _(FORMAT)                                                  \
+    /* Arc */                                                                                                          \
+    _(TYPE) _(ROTATION) _(ADJUSTABLE) _(START_ANGLE) _(END_ANGLE) _(START_ANGLE1) _(END_ANGLE1)                        \
+    /* Buttonmatrix */                                                                                                 \
+    _(MAP)                                                                                                             \
+    /* hasp user data */                                                                                               \
+    _(GROUPID) _(OBJID) _(BIND)
+
+enum hasp_attribute_t : uint8_t {
+#define HASP_ATTRIBUTE_ID(name) ATTR_##name,
+    HASP_ATTRIBUTE_LIST(HASP_ATTRIBUTE_ID)
+#undef HASP_ATTRIBUTE_ID
+    ATTR_UNKNOWN // number of attributes, not a valid attribute
+};
+
+/* ===== Redundant Update Suppression ===== */
+bool hasp_attribute_unchanged(uint8_t attr_id, bool unchanged);
+bool hasp_local_style_has_value(lv_obj_t* obj, uint8_t part, lv_state_t state, lv_style_property_t prop,
+                                int32_t value);
+size_t hasp_attribute_get_suppressed(char* buffer, size_t size);
+void hasp_attribute_reset_suppressed();
+
 #define _HASP_ATTRIBUTE(prop_name, func_name, value_type)                                                              \
     static inline void attribute_##func_name(lv_obj_t* obj, uint8_t part, lv_state_t state, bool update,               \
                                              const char* attr, value_type val)                                         \
     {                                                                                                                  \
         if(update) {                                                                                                   \
+            if(hasp_attribute_unchanged(ATTR_##prop_name,                                                              \
+                                        hasp_local_style_has_value(obj, part, state, LV_STYLE_##prop_name, val)))      \
+                return;                                                                                                \
             return lv_obj_set_style_local_##func_name(obj, part, state, (value_type)val);                              \
         } else {                                                                                                       \
             value_type temp = lv_obj_get_style_##func_name(obj, part);                                                 \
@@ -146,173 +217,4 @@ _HASP_ATTRIBUTE(SCALE_END_LINE_WIDTH, scale_end_line_width, lv_style_int_t)
 //_HASP_ATTRIBUTE(SCALE_GRAD_COLOR, scale_grad_color, lv_color_t, _color, nonscalar)
 //_HASP_ATTRIBUTE(SCALE_END_COLOR, scale_end_color, lv_color_t, _color, nonscalar)
 
-/* attribute hashes */
-/* Object Part Attributes */
-#define ATTR_SIZE 16417
-#define ATTR_RADIUS 20786
-#define ATTR_CLIP_CORNER 9188
-#define ATTR_OPA_SCALE 64875
-#define ATTR_TRANSFORM_HEIGHT 55994
-#define ATTR_TRANSFORM_WIDTH 48627
-
-/* Background Attributes */
-#define ATTR_BG_OPA 48966
-#define ATTR_BG_COLOR 64969
-#define ATTR_BG_GRAD_DIR 41782
-#define ATTR_BG_GRAD_STOP 4025
-#define ATTR_BG_MAIN_STOP 63118
-#define ATTR_BG_BLEND_MODE 31147
-#define ATTR_BG_GRAD_COLOR 44140
-
-/* Margin Attributes */
-#define ATTR_MARGIN_TOP 7812
-#define ATTR_MARGIN_LEFT 24440
-#define ATTR_MARGIN_BOTTOM 37692
-#define ATTR_MARGIN_RIGHT 2187
-
-/* Padding Attributes */
-#define ATTR_PAD_TOP 59081
-#define ATTR_PAD_LEFT 43123
-#define ATTR_PAD_INNER 9930
-#define ATTR_PAD_RIGHT 65104
-#define ATTR_PAD_BOTTOM 3767
-
-/* Text Attributes */
-#define ATTR_TEXT_OPA 37166
-#define ATTR_TEXT_FONT 22465
-#define ATTR_TEXT_COLOR 23473
-#define ATTR_TEXT_DECOR 1971
-#define ATTR_TEXT_LETTER_SPACE 62079
-#define ATTR_TEXT_SEL_COLOR 32076
-#define ATTR_TEXT_LINE_SPACE 54829
-#define ATTR_TEXT_BLEND_MODE 32195
-
-/* Border Attributes */
-#define ATTR_BORDER_OPA 2061
-#define ATTR_BORDER_SIDE 53962
-#define ATTR_BORDER_POST 49491
-#define ATTR_BORDER_BLEND_MODE 23844
-#define ATTR_BORDER_WIDTH 24531
-#define ATTR_BORDER_COLOR 21264
-
-/* Outline Attributes */
-#define ATTR_OUTLINE_OPA 23011
-#define ATTR_OUTLINE_PAD 26038
-#define ATTR_OUTLINE_COLOR 6630
-#define ATTR_OUTLINE_BLEND_MODE 25038
-#define ATTR_OUTLINE_WIDTH 9897
-
-/* Shadow Attributes */
-#define ATTR_SHADOW_OPA 38401
-#define ATTR_SHADOW_WIDTH 13255
-#define ATTR_SHADOW_OFS_X 44278
-#define ATTR_SHADOW_OFS_Y 44279
-#define ATTR_SHADOW_SPREAD 21138
-#define ATTR_SHADOW_BLEND_MODE 64048
-#define ATTR_SHADOW_COLOR 9988
-
-/* Line Attributes */
-#define ATTR_LINE_OPA 24501
-#define ATTR_LINE_WIDTH 25467
-#define ATTR_LINE_COLOR 22200
-#define ATTR_LINE_DASH_WIDTH 32676
-#define ATTR_LINE_ROUNDED 15042
-#define ATTR_LINE_DASH_GAP 49332
-#define ATTR_LINE_BLEND_MODE 60284
-
-/* Value Attributes */
-#define ATTR_VALUE_OPA 50482
-#define ATTR_VALUE_STR 1091
-#define ATTR_VALUE_FONT 9405
-#define ATTR_VALUE_ALIGN 27895
-#define ATTR_VALUE_COLOR 52661
-#define ATTR_VALUE_OFS_X 21415
-#define ATTR_VALUE_OFS_Y 21416
-#define ATTR_VALUE_LINE_SPACE 26921
-#define ATTR_VALUE_BLEND_MODE 4287
-#define ATTR_VALUE_LETTER_SPACE 51067
-
-/* Pattern attributes */
-#define ATTR_PATTERN_BLEND_MODE 43456
-#define ATTR_PATTERN_RECOLOR_OPA 35074
-#define ATTR_PATTERN_RECOLOR 7745
-#define ATTR_PATTERN_REPEAT 31338
-#define ATTR_PATTERN_OPA 43633
-#define ATTR_PATTERN_IMAGE 61292
-
-#define ATTR_TRANSITION_PROP_1 49343
-#define ATTR_TRANSITION_PROP_2 49344
-#define ATTR_TRANSITION_PROP_3 49345
-#define ATTR_TRANSITION_PROP_4 49346
-#define ATTR_TRANSITION_PROP_5 49347
-#define ATTR_TRANSITION_PROP_6 49348
-#define ATTR_TRANSITION_TIME 26263
-#define ATTR_TRANSITION_PATH 43343
-#define ATTR_TRANSITION_DELAY 64537
-
-#define ATTR_IMAGE_OPA 58140
-#define ATTR_IMAGE_RECOLOR 52204
-#define ATTR_IMAGE_BLEND_MODE 11349
-#define ATTR_IMAGE_RECOLOR_OPA 43949
-
-#define ATTR_SCALE_END_LINE_WIDTH 30324
-#define ATTR_SCALE_END_BORDER_WIDTH 34380
-#define ATTR_SCALE_BORDER_WIDTH 2440
-#define ATTR_SCALE_GRAD_COLOR 47239
-#define ATTR_SCALE_WIDTH 36017
-#define ATTR_SCALE_END_COLOR 44074
-
-/* Object Attributes */
-#define ATTR_X 120
-#define ATTR_Y 121
-#define ATTR_W 119
-#define ATTR_H 104
-#define ATTR_OPTIONS 29886
-#define ATTR_ENABLED 28193
-#define ATTR_OPACITY 10155
-#define ATTR_TOGGLE 38580
-#define ATTR_HIDDEN 11082
-#define ATTR_VIS 16320
-#define ATTR_MODE 45891
-// #define ATTR_RECT 11204
-#define ATTR_ALIGN 34213
-#define ATTR_ROWS 52153
-#define ATTR_COLS 36307
-#define ATTR_MIN 46130
-#define ATTR_MAX 45636
-#define ATTR_VAL 15809
-#define ATTR_COLOR 58979
-#define ATTR_TXT 9328
-#define ATTR_TEXT 53869
-#define ATTR_SRC 4964
-#define ATTR_ID 6715
-
-// methods
-#define ATTR_DELETE 50027
-#define ATTR_TO_FRONT 44741
-#define ATTR_TO_BACK 24555
-
-// Gauge
-#define ATTR_CRITICAL_VALUE 39281
-#define ATTR_ANGLE 2387
-#define ATTR_LABEL_COUNT 20356
-#define ATTR_LINE_COUNT 57860
-#define ATTR_FORMAT 38871
-
-// Arc
-#define ATTR_TYPE 1658
-#define ATTR_ROTATION 44830
-#define ATTR_ADJUSTABLE 19145
-#define ATTR_START_ANGLE 44310
-#define ATTR_END_ANGLE 41103
-#define ATTR_START_ANGLE1 39067
-#define ATTR_END_ANGLE1 33634
-
-// Buttonmatrix
-#define ATTR_MAP 45628
-
-/* hasp user data */
-#define ATTR_GROUPID 48986
-#define ATTR_OBJID 41010
-
 #endif
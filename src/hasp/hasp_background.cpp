@@ -0,0 +1,300 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Strip-streamed background images
+ * File layout, all values little endian:
+ *   0  char[4]  magic "HSPS"
+ *   4  uint8    version
+ *   5  uint8    flags, HASP_BG_FLAG_RLE
+ *   6  uint16   lines per strip
+ *   8  uint16   width
+ *   10 uint16   height
+ *   12 uint32   reserved
+ *   16 uint32[] RLE only: file offset of each strip, followed by the end offset of the last strip
+ * followed by the RGB565 pixels. In RLE strips a count byte of 0x80 | (n - 1) repeats the next pixel n times and
+ * a count byte of n - 1 is followed by n literal pixels. Packets do not cross strips, each strip decodes alone.
+ */
+
+#include "hasplib.h"
+
+#if HASP_USE_DEBUG > 0
+#include "../hasp_debug.h"
+#endif
+
+#if LV_USE_FILESYSTEM > 0
+
+struct hasp_bg_t
+{
+    lv_fs_file_t file;
+    uint16_t width;
+    uint16_t height;
+    uint16_t strip_lines;
+    uint8_t flags;
+    int32_t strip;   // index of the decoded strip, -1 if none
+    uint8_t* pixels; // RLE only: the decoded strip
+};
+
+struct hasp_bg_reader_t
+{
+    lv_fs_file_t* file;
+    uint32_t remaining; // compressed bytes of the strip not read yet
+    uint8_t pos;
+    uint8_t len;
+    uint8_t buffer[64];
+};
+
+static lv_img_decoder_t* bg_decoder;
+
+static inline uint16_t bg_u16(const uint8_t* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+static inline uint32_t bg_u32(const uint8_t* data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static bool bg_read(lv_fs_file_t* file, void* buffer, uint32_t len)
+{
+    uint32_t read = 0;
+    return lv_fs_read(file, buffer, len, &read) == LV_FS_RES_OK && read == len;
+}
+
+static bool bg_read_header(lv_fs_file_t* file, hasp_bg_t* bg)
+{
+    uint8_t header[HASP_BG_HEADER_SIZE];
+    if(!bg_read(file, header, sizeof(header)) || memcmp(header, HASP_BG_MAGIC, 4) || header[4] != HASP_BG_VERSION)
+        return false;
+
+    bg->flags       = header[5];
+    bg->strip_lines = bg_u16(header + 6);
+    bg->width       = bg_u16(header + 8);
+    bg->height      = bg_u16(header + 10);
+    return bg->strip_lines > 0 && bg->width > 0 && bg->height > 0;
+}
+
+/* Convert RGB565 little endian pixels in place to lv_color_t */
+static void bg_convert(uint8_t* buf, lv_coord_t len)
+{
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0
+    (void)buf;
+    (void)len;
+#elif LV_COLOR_DEPTH == 16
+    for(lv_coord_t i = 0; i < len; i++) {
+        uint8_t low    = buf[i * 2];
+        buf[i * 2]     = buf[i * 2 + 1];
+        buf[i * 2 + 1] = low;
+    }
+#else
+    lv_color_t* color = (lv_color_t*)buf;
+#if LV_COLOR_DEPTH > 16
+    for(lv_coord_t i = len - 1; i >= 0; i--) { // the colors are larger than the pixels, convert from the end
+#else
+    for(lv_coord_t i = 0; i < len; i++) {
+#endif
+        uint16_t px = bg_u16(buf + i * 2);
+        color[i]    = lv_color_make((px >> 8) & 0xF8, (px >> 3) & 0xFC, (px << 3) & 0xF8);
+    }
+#endif
+}
+
+static bool bg_read_byte(hasp_bg_reader_t* reader, uint8_t* byte)
+{
+    if(reader->pos >= reader->len) {
+        uint32_t len = reader->remaining < sizeof(reader->buffer) ? reader->remaining : sizeof(reader->buffer);
+        if(len == 0 || !bg_read(reader->file, reader->buffer, len)) return false;
+        reader->remaining -= len;
+        reader->pos = 0;
+        reader->len = len;
+    }
+    *byte = reader->buffer[reader->pos++];
+    return true;
+}
+
+static bool bg_decode_strip(hasp_bg_t* bg, int32_t strip)
+{
+    uint8_t offsets[8];
+    if(lv_fs_seek(&bg->file, HASP_BG_HEADER_SIZE + strip * 4) != LV_FS_RES_OK || !bg_read(&bg->file, offsets, 8))
+        return false;
+
+    hasp_bg_reader_t reader;
+    reader.file      = &bg->file;
+    reader.remaining = bg_u32(offsets + 4) - bg_u32(offsets);
+    reader.pos       = 0;
+    reader.len       = 0;
+    if(lv_fs_seek(&bg->file, bg_u32(offsets)) != LV_FS_RES_OK) return false;
+
+    uint32_t lines = bg->height - strip * bg->strip_lines;
+    if(lines > bg->strip_lines) lines = bg->strip_lines;
+
+    uint8_t* out = bg->pixels;
+    uint8_t* end = bg->pixels + lines * bg->width * 2;
+    uint8_t count;
+    while(out < end && bg_read_byte(&reader, &count)) {
+        uint8_t* stop = out + ((count & 0x7F) + 1) * 2;
+        if(stop > end) return false;
+
+        if(count & 0x80) {
+            if(!bg_read_byte(&reader, out) || !bg_read_byte(&reader, out + 1)) return false;
+            for(out += 2; out < stop; out += 2) memcpy(out, out - 2, 2);
+        } else {
+            for(; out < stop; out++)
+                if(!bg_read_byte(&reader, out)) return false;
+        }
+    }
+
+    bg->strip = out == end ? strip : -1;
+    return out == end;
+}
+
+/* ===== Decoder Callbacks ===== */
+
+static lv_res_t bg_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+    if(!hasp_background_is_file(src)) return LV_RES_INV;
+
+    lv_fs_file_t file;
+    if(lv_fs_open(&file, (const char*)src, LV_FS_MODE_RD) != LV_FS_RES_OK) return LV_RES_INV;
+
+    hasp_bg_t bg;
+    bool valid = bg_read_header(&file, &bg);
+    lv_fs_close(&file);
+    if(!valid) return LV_RES_INV;
+
+    header->always_zero = 0;
+    header->cf          = LV_IMG_CF_TRUE_COLOR;
+    header->w           = bg.width;
+    header->h           = bg.height;
+    return LV_RES_OK;
+}
+
+static lv_res_t bg_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    if(!hasp_background_is_file(dsc->src)) return LV_RES_INV;
+
+    hasp_bg_t* bg = (hasp_bg_t*)calloc(1, sizeof(hasp_bg_t));
+    if(!bg) return LV_RES_INV;
+
+    if(lv_fs_open(&bg->file, (const char*)dsc->src, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        free(bg);
+        return LV_RES_INV;
+    }
+
+    if(bg_read_header(&bg->file, bg)) {
+        bg->strip = -1;
+        if(!(bg->flags & HASP_BG_FLAG_RLE)) {
+            dsc->user_data = bg;
+            return LV_RES_OK;
+        }
+
+        bg->pixels = (uint8_t*)malloc(bg->strip_lines * bg->width * 2);
+        if(bg->pixels) {
+            dsc->user_data = bg;
+            return LV_RES_OK;
+        }
+        LOG_ERROR(TAG_LVGL, F("%s: no memory for a strip of %u lines"), (const char*)dsc->src, bg->strip_lines);
+    }
+
+    lv_fs_close(&bg->file);
+    free(bg);
+    return LV_RES_INV;
+}
+
+static lv_res_t bg_read_line(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc, lv_coord_t x, lv_coord_t y,
+                             lv_coord_t len, uint8_t* buf)
+{
+    hasp_bg_t* bg = (hasp_bg_t*)dsc->user_data;
+    if(!bg || y >= bg->height || x + len > bg->width) return LV_RES_INV;
+
+    if(bg->flags & HASP_BG_FLAG_RLE) {
+        int32_t strip = y / bg->strip_lines;
+        if(strip != bg->strip && !bg_decode_strip(bg, strip)) return LV_RES_INV;
+        memcpy(buf, bg->pixels + ((y - strip * bg->strip_lines) * bg->width + x) * 2, len * 2);
+    } else {
+        uint32_t pos = HASP_BG_HEADER_SIZE + ((uint32_t)y * bg->width + x) * 2;
+        if(lv_fs_seek(&bg->file, pos) != LV_FS_RES_OK || !bg_read(&bg->file, buf, len * 2)) return LV_RES_INV;
+    }
+
+    bg_convert(buf, len);
+    return LV_RES_OK;
+}
+
+static void bg_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    hasp_bg_t* bg = (hasp_bg_t*)dsc->user_data;
+    if(!bg) return;
+
+    lv_fs_close(&bg->file);
+    free(bg->pixels);
+    free(bg);
+    dsc->user_data = NULL;
+}
+
+/* ===== Default Event Processors ===== */
+
+void hasp_background_setup()
+{
+    if(bg_decoder) return;
+
+    bg_decoder = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(bg_decoder, bg_info);
+    lv_img_decoder_set_open_cb(bg_decoder, bg_open);
+    lv_img_decoder_set_read_line_cb(bg_decoder, bg_read_line);
+    lv_img_decoder_set_close_cb(bg_decoder, bg_close);
+}
+
+/* ===== Getter and Setter Functions ===== */
+
+// A .bg file image, drawn from the file by the background decoder
+bool hasp_background_is_file(const void* src)
+{
+    if(lv_img_src_get_type(src) != LV_IMG_SRC_FILE) return false;
+    const char* ext = lv_fs_get_ext((const char*)src);
+    return !strcasecmp_P(ext, PSTR("bg"));
+}
+
+#else
+
+void hasp_background_setup()
+{}
+
+bool hasp_background_is_file(const void*)
+{
+    return false;
+}
+
+#endif // LV_USE_FILESYSTEM
+
+/* ===== Special Event Processors ===== */
+
+// Show an image behind all objects of a page, an empty src removes the background
+void hasp_background(uint8_t pageid, const char* src)
+{
+    lv_obj_t* page = get_page_obj(pageid);
+    if(!page || pageid == 0 || pageid > HASP_NUM_PAGES) {
+        LOG_WARNING(TAG_HASP, F(D_HASP_INVALID_PAGE), pageid);
+        return;
+    }
+
+    /* The background is the bottom image without an id */
+    lv_obj_t* obj = lv_obj_get_child_back(page, NULL);
+    if(obj && (!check_obj_type(obj, LV_HASP_IMAGE) || obj->user_data.id != 0)) obj = NULL;
+
+    if(!src || !*src) {
+        if(obj) lv_obj_del(obj);
+        return;
+    }
+
+    if(!obj) {
+        obj = lv_img_create(page, NULL);
+        if(!obj) return;
+        obj->user_data.objid = LV_HASP_IMAGE;
+        obj->user_data.id    = 0;
+        lv_obj_set_click(obj, false);
+        lv_obj_move_background(obj);
+    }
+
+    lv_img_set_src(obj, src);
+    lv_obj_set_pos(obj, 0, 0);
+}
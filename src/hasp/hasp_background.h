@@ -0,0 +1,28 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_BACKGROUND_H
+#define HASP_BACKGROUND_H
+
+#include "lvgl.h"
+
+/* Strip-streamed background images
+ * Files with the .bg extension hold RGB565 pixels, raw or RLE compressed in strips of lines, as written by
+ * tools/img2bg.py. They are drawn line by line straight from the filesystem while lvgl renders each band of
+ * the draw buffer, so a full-screen image never needs more RAM than one decoded strip.
+ */
+#define HASP_BG_MAGIC "HSPS"
+#define HASP_BG_VERSION 1
+#define HASP_BG_HEADER_SIZE 16
+#define HASP_BG_FLAG_RLE 0x01
+
+/* ===== Default Event Processors ===== */
+void hasp_background_setup(void);
+
+/* ===== Special Event Processors ===== */
+void hasp_background(uint8_t pageid, const char* src);
+
+/* ===== Getter and Setter Functions ===== */
+bool hasp_background_is_file(const void* src);
+
+#endif
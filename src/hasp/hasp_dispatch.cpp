@@ -8,13 +8,14 @@
 
 #include "dev/device.h"
 
-//#include "hasp_gui.h"
+#include "hasp_gui.h"
+#include "sys/hasp_profiler.h"
 
 #if HASP_USE_DEBUG > 0
 #include "../hasp_debug.h"
 #include "hasp_gui.h" // for screenshot
 
-#if WINDOWS
+#if defined(WINDOWS) || defined(POSIX)
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -39,11 +40,10 @@
 
 extern uint8_t hasp_sleep_state;
 
-dispatch_conf_t dispatch_setings = {.teleperiod = 10};
+dispatch_conf_t dispatch_setings = {.teleperiod = 10, .coalesce = DISPATCH_COALESCE_MS};
 
-uint32_t dispatchLastMillis;
 uint8_t nCommands = 0;
-haspCommand_t commands[17];
+haspCommand_t commands[23];
 
 struct moodlight_t
 {
@@ -62,7 +62,7 @@ void dispatch_screenshot(const char*, const char* filename)
 
     if(strlen(filename) == 0) { // no filename given
         char tempfile[32];
-        memcpy_P(tempfile, PSTR("/screenshot.bmp"), sizeof(tempfile));
+        memcpy_P(tempfile, PSTR("/screenshot.png"), sizeof(tempfile));
         guiTakeScreenshot(tempfile);
     } else if(strlen(filename) > 31 || filename[0] != '/') { // Invalid filename
         LOG_WARNING(TAG_MSGR, "Invalid filename %s", filename);
@@ -97,54 +97,52 @@ void dispatch_json_error(uint8_t tag, DeserializationError& jsonError)
     LOG_ERROR(tag, F(D_JSON_FAILED " %s"), jsonError.c_str());
 }
 
-// p[x].b[y].attr=value
-static inline bool dispatch_parse_button_attribute(const char* topic_p, const char* payload)
+// p[x].b[y].attr, returns a pointer to attr or NULL when the topic is not a button attribute
+static const char* dispatch_find_button_attribute(const char* topic_p, uint8_t& pageid, uint8_t& objid)
 {
     long num;
     char* pEnd;
-    uint8_t pageid, objid;
 
-    if(*topic_p != 'p' && *topic_p != 'P') return false; // obligated p
+    if(*topic_p != 'p' && *topic_p != 'P') return NULL; // obligated p
     topic_p++;
 
     if(*topic_p == '[') { // optional brackets, TODO: remove
         topic_p++;
         num = strtol(topic_p, &pEnd, DEC);
-        if(*pEnd != ']') return false; // obligated closing bracket
+        if(*pEnd != ']') return NULL; // obligated closing bracket
         pEnd++;
 
     } else {
         num = strtol(topic_p, &pEnd, DEC);
     }
 
-    if(num < 0 || num > HASP_NUM_PAGES) return false; // page number must be valid
+    if(num < 0 || num > HASP_NUM_PAGES) return NULL; // page number must be valid
 
     pageid  = (uint8_t)num;
     topic_p = pEnd;
 
     if(*topic_p == '.') topic_p++; // optional separator
 
-    if(*topic_p != 'b' && *topic_p != 'B') return false; // obligated b
+    if(*topic_p != 'b' && *topic_p != 'B') return NULL; // obligated b
     topic_p++;
 
     if(*topic_p == '[') { // optional brackets, TODO: remove
         topic_p++;
         num = strtol(topic_p, &pEnd, DEC);
-        if(*pEnd != ']') return false; // obligated closing bracket
+        if(*pEnd != ']') return NULL; // obligated closing bracket
         pEnd++;
     } else {
         num = strtol(topic_p, &pEnd, DEC);
     }
 
-    if(num < 0 || num > 255) return false; // id must be valid
+    if(num < 0 || num > 255) return NULL; // id must be valid
     objid   = (uint8_t)num;
     topic_p = pEnd;
 
-    if(*topic_p != '.') return false; // obligated seperator
+    if(*topic_p != '.') return NULL; // obligated seperator
     topic_p++;
 
-    hasp_process_attribute(pageid, objid, topic_p, payload);
-    return true;
+    return topic_p;
 
     /*
         if(sscanf(topic_p, HASP_OBJECT_NOTATION ".", &pageid, &objid) == 2) { // Literal String
@@ -194,6 +192,27 @@ static inline bool dispatch_parse_button_attribute(const char* topic_p, const ch
     // }
 }
 
+// Object updates that follow each other closely are a burst, hold the refresh until it is over
+static void dispatch_hold_burst()
+{
+    static uint32_t last_update;
+    uint32_t now = millis();
+    if(now - last_update < GUI_REFRESH_HOLD) guiHoldRefresh();
+    last_update = now;
+}
+
+// p[x].b[y].attr=value
+static inline bool dispatch_parse_button_attribute(const char* topic_p, const char* payload)
+{
+    uint8_t pageid, objid;
+    const char* attr = dispatch_find_button_attribute(topic_p, pageid, objid);
+    if(!attr) return false;
+
+    dispatch_hold_burst();
+    hasp_process_attribute(pageid, objid, attr, payload);
+    return true;
+}
+
 // objectattribute=value
 void dispatch_command(const char* topic, const char* payload)
 {
@@ -279,24 +298,17 @@ void dispatch_topic_payload(const char* topic, const char* payload)
     dispatch_command(topic, (char*)payload); // dispatch as is
 }
 
+// Find what comes first, ' ' or '=', returns 0 if not found
+static inline size_t dispatch_find_separator(const char* cmnd)
+{
+    const char* sep = strpbrk(cmnd, "= ");
+    return sep ? sep - cmnd : 0;
+}
+
 // Parse one line of text and execute the command
 void dispatch_text_line(const char* cmnd)
 {
-    size_t pos1 = std::string(cmnd).find("=");
-    size_t pos2 = std::string(cmnd).find(" ");
-    size_t pos  = 0;
-
-    // Find what comes first, ' ' or '='
-    if(pos1 != std::string::npos) {
-        if(pos2 != std::string::npos) {
-            pos = (pos1 < pos2 ? pos1 : pos2);
-        } else {
-            pos = pos1;
-        }
-
-    } else {
-        pos = (pos2 != std::string::npos) ? pos2 : 0;
-    }
+    size_t pos = dispatch_find_separator(cmnd);
 
     if(pos > 0) { // ' ' or '=' found
         char topic[64];
@@ -375,6 +387,118 @@ void dispatch_send_obj_attribute_color(uint8_t pageid, uint8_t btnid, const char
     mqtt_send_object_state(pageid, btnid, payload);
 }
 
+/******************************************* Coalesced Output ******************************************/
+// Sliders, arcs and color pickers fire a value change on every touch sample while dragged.
+// Those updates are staged per object attribute: the latest payload replaces any pending one and
+// each slot publishes at most once per dispatch_setings.coalesce milliseconds.
+
+struct dispatch_pending_t
+{
+    uint8_t pageid;
+    uint8_t objid;
+    bool pending;
+    uint32_t last_sent;
+    char attribute[8];
+    char payload[64];
+};
+
+static dispatch_pending_t dispatch_pending[DISPATCH_COALESCE_SLOTS];
+static dispatch_coalesce_stats_t dispatch_coalesce_stats;
+
+static void dispatch_pending_send(dispatch_pending_t* slot)
+{
+    slot->pending   = false;
+    slot->last_sent = millis();
+    dispatch_coalesce_stats.sent++;
+    mqtt_send_object_state(slot->pageid, slot->objid, slot->payload);
+}
+
+// Find the slot of this object attribute, or claim an idle one
+static dispatch_pending_t* dispatch_pending_find(uint8_t pageid, uint8_t objid, const char* attribute)
+{
+    dispatch_pending_t* idle   = NULL;
+    dispatch_pending_t* oldest = dispatch_pending;
+
+    for(dispatch_pending_t* slot = dispatch_pending; slot < dispatch_pending + DISPATCH_COALESCE_SLOTS; slot++) {
+        if(slot->attribute[0] != 0 && slot->pageid == pageid && slot->objid == objid &&
+           !strcmp(slot->attribute, attribute))
+            return slot;
+
+        if(!slot->pending) {
+            if(!idle || slot->last_sent < idle->last_sent) idle = slot;
+        } else if(slot->last_sent < oldest->last_sent) {
+            oldest = slot;
+        }
+    }
+
+    if(!idle) {
+        // All slots are waiting, push out the one that has waited the longest
+        dispatch_pending_send(oldest);
+        idle = oldest;
+    }
+
+    idle->pageid    = pageid;
+    idle->objid     = objid;
+    idle->last_sent = millis() - dispatch_setings.coalesce; // the first update is sent right away
+    strncpy(idle->attribute, attribute, sizeof(idle->attribute));
+    return idle;
+}
+
+static void dispatch_coalesce_obj_attribute(uint8_t pageid, uint8_t objid, const char* attribute, char* payload)
+{
+    dispatch_coalesce_stats.staged++;
+
+    if(dispatch_setings.coalesce == 0 || strlen(attribute) >= sizeof(dispatch_pending_t::attribute) ||
+       strlen(payload) >= sizeof(dispatch_pending_t::payload)) {
+        dispatch_coalesce_stats.sent++;
+        mqtt_send_object_state(pageid, objid, payload);
+        return;
+    }
+
+    dispatch_pending_t* slot = dispatch_pending_find(pageid, objid, attribute);
+    if(slot->pending) dispatch_coalesce_stats.coalesced++;
+
+    strcpy(slot->payload, payload);
+    slot->pending = true;
+
+    if(millis() - slot->last_sent >= dispatch_setings.coalesce) dispatch_pending_send(slot);
+}
+
+// Publish the pending updates of an object immediately, e.g. when it is released
+static void dispatch_flush_obj_attributes(uint8_t pageid, uint8_t objid)
+{
+    for(dispatch_pending_t* slot = dispatch_pending; slot < dispatch_pending + DISPATCH_COALESCE_SLOTS; slot++) {
+        if(slot->pending && slot->pageid == pageid && slot->objid == objid) dispatch_pending_send(slot);
+    }
+}
+
+// Publish the pending updates whose interval has elapsed
+static void dispatch_coalesce_loop()
+{
+    // Every staged update is either coalesced, sent or still pending
+    if(dispatch_coalesce_stats.sent == dispatch_coalesce_stats.staged - dispatch_coalesce_stats.coalesced) return;
+
+    uint32_t now = millis();
+    for(dispatch_pending_t* slot = dispatch_pending; slot < dispatch_pending + DISPATCH_COALESCE_SLOTS; slot++) {
+        if(slot->pending && now - slot->last_sent >= dispatch_setings.coalesce) dispatch_pending_send(slot);
+    }
+}
+
+// Interval of the statusupdate in seconds, the main loop schedules it
+uint16_t dispatch_get_teleperiod()
+{
+    return dispatch_setings.teleperiod;
+}
+
+void dispatch_get_coalesce_stats(dispatch_coalesce_stats_t* stats)
+{
+    *stats         = dispatch_coalesce_stats;
+    stats->pending = 0;
+    for(dispatch_pending_t* slot = dispatch_pending; slot < dispatch_pending + DISPATCH_COALESCE_SLOTS; slot++) {
+        if(slot->pending) stats->pending++;
+    }
+}
+
 #if HASP_USE_CONFIG > 0
 // Get or Set a part of the config.json file
 static void dispatch_config(const char* topic, const char* payload)
@@ -540,6 +664,8 @@ void dispatch_gpio_input_event(uint8_t pin, uint8_t group, uint8_t eventid)
     mqtt_send_state(F("input"), payload);
 #endif
 
+    hasp_rules_gpio_event(pin, eventid);
+
     // update outputstates
     // dispatch_group_onoff(group, dispatch_get_event_state(eventid), NULL);
 }
@@ -555,7 +681,9 @@ void dispatch_object_event(lv_obj_t* obj, uint8_t eventid)
     dispatch_get_event_name(eventid, payload, sizeof(payload));
 
     if(hasp_find_id_from_obj(obj, &pageid, &objid)) {
+        dispatch_flush_obj_attributes(pageid, objid); // the final value goes out before the event
         dispatch_send_obj_attribute_str(pageid, objid, topic, payload);
+        hasp_rules_object_event(pageid, objid, eventid, dispatch_get_event_state(eventid));
     }
 
     //  dispatch_group_onoff(obj->user_data.groupid, dispatch_get_event_state(eventid), obj);
@@ -564,10 +692,44 @@ void dispatch_object_event(lv_obj_t* obj, uint8_t eventid)
 void dispatch_object_value_changed(lv_obj_t* obj, int16_t state)
 {
     char topic[4];
+    char payload[32];
+    uint8_t pageid, objid;
 
     hasp_update_sleep_state(); // wakeup?
-    snprintf_P(topic, sizeof(topic), PSTR("val"));
-    hasp_send_obj_attribute_int(obj, topic, state);
+
+    if(hasp_find_id_from_obj(obj, &pageid, &objid)) {
+        snprintf_P(topic, sizeof(topic), PSTR("val"));
+        snprintf_P(payload, sizeof(payload), PSTR("{\"%s\":%d}"), topic, state);
+        dispatch_coalesce_obj_attribute(pageid, objid, topic, payload);
+        hasp_rules_object_event(pageid, objid, HASP_RULES_EVENT_CHANGED, state);
+    }
+}
+
+void dispatch_object_color_changed(lv_obj_t* obj, lv_color_t color)
+{
+    char topic[6];
+    char payload[64];
+    uint8_t pageid, objid;
+
+    hasp_update_sleep_state(); // wakeup?
+
+    if(hasp_find_id_from_obj(obj, &pageid, &objid)) {
+        lv_color32_t c32;
+        c32.full = lv_color_to32(color);
+
+        snprintf_P(topic, sizeof(topic), PSTR("color"));
+        snprintf_P(payload, sizeof(payload), PSTR("{\"%s\":\"#%02x%02x%02x\",\"r\":%d,\"g\":%d,\"b\":%d}"), topic,
+                   c32.ch.red, c32.ch.green, c32.ch.blue, c32.ch.red, c32.ch.green, c32.ch.blue);
+        dispatch_coalesce_obj_attribute(pageid, objid, topic, payload);
+    }
+}
+
+// Send the last value of a slider, arc or color picker when it is released
+void dispatch_object_value_flush(lv_obj_t* obj)
+{
+    uint8_t pageid, objid;
+
+    if(hasp_find_id_from_obj(obj, &pageid, &objid)) dispatch_flush_obj_attributes(pageid, objid);
 }
 
 /********************************************** Output States ******************************************/
@@ -618,12 +780,34 @@ void dispatch_normalized_group_value(uint8_t groupid, uint16_t value, lv_obj_t*
 #if HASP_USE_GPIO > 0
         gpio_set_normalized_group_value(groupid, value);
 #endif
-        //  object_set_group_state(groupid, value, obj);
+        object_set_normalized_group_value(groupid, value, obj);
     }
 }
 
 /********************************************** Native Commands ****************************************/
 
+// Execute an array of commands in order, object attribute updates skip the topic parsing of dispatch_text_line
+// The refresh is held until the batch and any updates that closely follow it are applied
+static void dispatch_parse_json_batch(JsonArray& arr)
+{
+    guiHoldRefresh();
+    for(JsonVariant command : arr) {
+        char* cmnd = (char*)command.as<const char*>(); // the json document holds a copy of the string
+        if(!cmnd) continue;
+
+        size_t pos = dispatch_find_separator(cmnd);
+        uint8_t pageid, objid;
+        const char* attr = pos > 0 ? dispatch_find_button_attribute(cmnd, pageid, objid) : NULL;
+
+        if(attr && attr < cmnd + pos) {
+            cmnd[pos] = 0; // terminate the attribute name
+            hasp_process_attribute(pageid, objid, attr, cmnd + pos + 1);
+        } else {
+            dispatch_text_line(cmnd);
+        }
+    }
+}
+
 void dispatch_parse_json(const char*, const char* payload)
 { // Parse an incoming JSON array into individual commands
     /*  if(strPayload.endsWith(",]")) {
@@ -645,11 +829,7 @@ void dispatch_parse_json(const char*, const char* payload)
 
     } else if(json.is<JsonArray>()) { // handle json as an array of commands
         JsonArray arr = json.as<JsonArray>();
-        // guiStop();
-        for(JsonVariant command : arr) {
-            dispatch_text_line(command.as<const char*>());
-        }
-        // guiStart();
+        dispatch_parse_json_batch(arr);
     } else if(json.is<JsonObject>()) { // handle json as a jsonl
         uint8_t savedPage = haspGetPage();
         hasp_new_object(json.as<JsonObject>(), savedPage);
@@ -673,6 +853,61 @@ void dispatch_parse_json(const char*, const char* payload)
     }
 }
 
+#ifdef ARDUINO
+static inline size_t dispatch_jsonl_read(Stream& stream, char* buffer, size_t len)
+{
+    return stream.readBytes(buffer, len); // File streams override this with a bulk read
+}
+#else
+static inline size_t dispatch_jsonl_read(std::istringstream& stream, char* buffer, size_t len)
+{
+    stream.read(buffer, len);
+    return stream.gcount();
+}
+#endif
+
+static inline bool dispatch_jsonl_is_blank(const char* text, size_t len)
+{
+    while(len--)
+        if(!isspace(*text++)) return false;
+    return true;
+}
+
+struct dispatch_jsonl_scan_t
+{
+    int16_t depth;  // open braces and brackets
+    bool in_string; // inside a quoted string
+    bool escape;    // the previous character was a backslash inside a string
+};
+
+// Find the newline that ends a record, skipping newlines inside an open object
+// The state is kept between calls, so every byte of a record is scanned only once
+static char* dispatch_jsonl_find_end(char* pos, const char* end, dispatch_jsonl_scan_t& state)
+{
+    for(; pos < end; pos++) {
+        if(*pos == '\n') {
+            state.in_string = state.escape = false; // strings do not span lines
+            if(state.depth <= 0) return pos;
+        } else if(state.in_string) {
+            if(state.escape)
+                state.escape = false;
+            else if(*pos == '\\')
+                state.escape = true;
+            else if(*pos == '"')
+                state.in_string = false;
+        } else if(*pos == '"') {
+            state.in_string = true;
+        } else if(*pos == '{' || *pos == '[') {
+            state.depth++;
+        } else if(*pos == '}' || *pos == ']') {
+            state.depth--;
+        }
+    }
+    return NULL;
+}
+
+// Read the stream in chunks and parse each json line straight from the read buffer
+// The line buffer and parse arena grow on demand, up to HASP_JSONL_MAX_LINE and HASP_JSONL_MAX_ARENA
 #ifdef ARDUINO
 void dispatch_parse_jsonl(Stream& stream)
 #else
@@ -680,33 +915,123 @@ void dispatch_parse_jsonl(std::istringstream& stream)
 #endif
 {
     uint8_t savedPage = haspGetPage();
-    size_t line       = 1;
-    DynamicJsonDocument jsonl(MQTT_MAX_PACKET_SIZE / 2 + 128); // max ~256 characters per line
-    DeserializationError jsonError = deserializeJson(jsonl, stream);
+    size_t line       = 1;     // line number at the start of the current record
+    size_t offset     = 0;     // stream offset of the buffer start
+    size_t len        = 0;     // number of bytes in the buffer
+    size_t start      = 0;     // start of the current record in the buffer
+    size_t scan       = 0;     // where to continue looking for the end of the current record
+    size_t errors     = 0;     // number of records that failed to parse
+    bool eof          = false; // the stream has no more data
+    bool skipping     = false; // dropping the remainder of a line that was too long
+    dispatch_jsonl_scan_t nesting = {0, false, false}; // scanner state of the current record
+
+    size_t bufsize = HASP_JSONL_CHUNK_SIZE;
+    char* buffer   = (char*)malloc(bufsize);
+    auto* jsonl    = new DynamicJsonDocument(HASP_JSONL_CHUNK_SIZE);
+    if(!buffer || !jsonl || jsonl->capacity() == 0) {
+        LOG_ERROR(TAG_MSGR, F(D_ERROR_OUT_OF_MEMORY));
+        free(buffer);
+        delete jsonl;
+        return;
+    }
 
 #ifdef ARDUINO
     stream.setTimeout(25);
 #endif
 
-    // guiStop();
-    while(jsonError == DeserializationError::Ok) {
-        hasp_new_object(jsonl.as<JsonObject>(), savedPage);
-        jsonError = deserializeJson(jsonl, stream);
-        line++;
+    while(true) {
+        char* nl = skipping ? (char*)memchr(buffer + scan, '\n', len - scan)
+                            : dispatch_jsonl_find_end(buffer + scan, buffer + len, nesting);
+        scan     = nl ? nl - buffer : len;
+
+        /* Need more data */
+        if(!nl && !eof) {
+            if(start > 0) { // discard processed records
+                len -= start;
+                memmove(buffer, buffer + start, len);
+                offset += start;
+                scan -= start;
+                start = 0;
+            }
+
+            if(len == bufsize) {
+                char* newbuf = bufsize < HASP_JSONL_MAX_LINE ? (char*)realloc(buffer, bufsize * 2) : NULL;
+                if(newbuf) {
+                    buffer = newbuf;
+                    bufsize *= 2;
+                } else {
+                    if(!skipping) {
+                        LOG_ERROR(TAG_MSGR, F(D_JSONL_FAILED " (offset %u): line too long"), (uint32_t)line,
+                                  (uint32_t)offset);
+                        errors++;
+                    }
+                    skipping = true;
+                    offset += len;
+                    len = scan = 0;
+                    nesting    = {0, false, false};
+                }
+            }
+
+            size_t count = dispatch_jsonl_read(stream, buffer + len, bufsize - len);
+            if(count == 0) eof = true;
+            len += count;
+            continue;
+        }
+
+        size_t end = nl ? nl - buffer : len; // the record is buffer[start..end)
+
+        if(skipping) {
+            skipping = false;
+
+        } else if(!dispatch_jsonl_is_blank(buffer + start, end - start)) {
+            DeserializationError jsonError = deserializeJson(*jsonl, (const char*)buffer + start, end - start);
+
+            /* Grow the arena and try again, the input is left untouched by the parser */
+            while(jsonError == DeserializationError::NoMemory && jsonl->capacity() < HASP_JSONL_MAX_ARENA) {
+                size_t arenasize = jsonl->capacity() * 2;
+                delete jsonl;
+                jsonl = new DynamicJsonDocument(arenasize);
+                if(!jsonl || jsonl->capacity() == 0) {
+                    LOG_ERROR(TAG_MSGR, F(D_ERROR_OUT_OF_MEMORY));
+                    free(buffer);
+                    delete jsonl;
+                    return;
+                }
+                jsonError = deserializeJson(*jsonl, (const char*)buffer + start, end - start);
+            }
+
+            if(jsonError) {
+                LOG_ERROR(TAG_MSGR, F(D_JSONL_FAILED " (offset %u): %s"), (uint32_t)line, (uint32_t)(offset + start),
+                          jsonError.c_str());
+                errors++;
+            } else {
+                hasp_new_object(jsonl->as<JsonObject>(), savedPage);
+            }
+        }
+
+        if(!nl) break; // last record
+
+        /* Advance to the next record */
+        for(size_t i = start; i <= end; i++)
+            if(buffer[i] == '\n') line++;
+        start = scan = end + 1;
+        nesting      = {0, false, false};
     }
-    // guiStart();
+
+    free(buffer);
+    delete jsonl;
 
     /* For debugging pourposes */
-    if(jsonError == DeserializationError::EmptyInput) {
+    if(errors == 0) {
         LOG_INFO(TAG_MSGR, F(D_JSONL_SUCCEEDED));
-
     } else {
-        LOG_ERROR(TAG_MSGR, F(D_JSONL_FAILED ": %s"), line, jsonError.c_str());
+        LOG_WARNING(TAG_MSGR, F("%u jsonl lines failed"), (uint32_t)errors);
     }
 }
 
 void dispatch_parse_jsonl(const char*, const char* payload)
 {
+    guiHoldRefresh();
 #if HASP_USE_CONFIG > 0
     CharStream stream((char*)payload);
     // stream.setTimeout(10);
@@ -790,6 +1115,91 @@ void dispatch_dim(const char*, const char* level)
     dispatch_state_msg(F("dim"), payload);
 }
 
+// Minimum interval in ms between value updates of a dragged slider, arc or color picker
+void dispatch_coalesce(const char*, const char* interval)
+{
+    // Set the current state
+    if(strlen(interval) != 0) dispatch_setings.coalesce = atoi(interval);
+
+    char payload[6];
+    itoa(dispatch_setings.coalesce, payload, DEC);
+    dispatch_state_msg(F("coalesce"), payload);
+}
+
+// Reload the rules file, or replace the rules with the jsonl payload
+void dispatch_rules(const char*, const char* payload)
+{
+    if(strlen(payload) == 0) {
+        hasp_rules_load_file(HASP_RULES_FILE);
+    } else {
+#if HASP_USE_CONFIG > 0
+        CharStream stream((char*)payload);
+        hasp_rules_load(stream);
+#else
+        std::istringstream stream((char*)payload);
+        hasp_rules_load(stream);
+#endif
+    }
+
+    char count[6];
+    itoa(hasp_rules_count(), count, DEC);
+    dispatch_state_msg(F("rules"), count);
+}
+
+// Report the attribute updates that were skipped because nothing changed, "reset" clears the counters
+void dispatch_suppressed(const char*, const char* payload)
+{
+    char data[512];
+
+    hasp_attribute_get_suppressed(data, sizeof(data));
+    dispatch_state_msg(F("suppressed"), data);
+
+    if(!strcasecmp_P(payload, PSTR("reset"))) hasp_attribute_reset_suppressed();
+}
+
+// Report the decoded image cache and log its images, "clear" drops the images that are not in use
+void dispatch_imgcache(const char*, const char* payload)
+{
+    char data[512];
+
+    if(!strcasecmp_P(payload, PSTR("clear"))) hasp_img_cache_invalidate(NULL);
+
+    hasp_img_cache_get_status(data, sizeof(data));
+    dispatch_state_msg(F("imgcache"), data);
+    hasp_img_cache_dump();
+}
+
+// Set the background image of a page, the payload is "[pageid] src" and defaults to the current page
+void dispatch_background(const char*, const char* payload)
+{
+    uint8_t pageid = haspGetPage();
+
+    if(*payload && Utilities::is_only_digits(payload)) {
+        hasp_background(atoi(payload), ""); // page without src
+        return;
+    }
+
+    const char* src = strchr(payload, ' ');
+    if(src && payload[0] >= '0' && payload[0] <= '9') {
+        pageid  = atoi(payload);
+        payload = src + 1;
+    }
+    hasp_background(pageid, payload);
+}
+
+#if HASP_USE_PROFILER > 0
+// Report the main loop timings, "reset" starts a new measurement window
+void dispatch_profiler(const char*, const char* payload)
+{
+    char data[512];
+
+    profilerGetStatus(data, sizeof(data));
+    dispatch_state_msg(F("profiler"), data);
+
+    if(!strcasecmp_P(payload, PSTR("reset"))) profilerReset();
+}
+#endif
+
 void dispatch_moodlight(const char* topic, const char* payload)
 {
     // Set the current state
@@ -887,7 +1297,7 @@ void dispatch_reboot(bool saveConfig)
     LOG_VERBOSE(TAG_MSGR, F("-------------------------------------"));
     LOG_TRACE(TAG_MSGR, F(D_DISPATCH_REBOOT));
 
-#if WINDOWS
+#if defined(WINDOWS) || defined(POSIX)
     fflush(stdout);
 #else
     Serial.flush();
@@ -911,7 +1321,7 @@ void dispatch_output_statusupdate(const char*, const char*)
 {
 #if HASP_USE_MQTT > 0
 
-    char data[3 * 128];
+    char data[4 * 128];
     {
         char buffer[128];
 
@@ -938,12 +1348,19 @@ void dispatch_output_statusupdate(const char*, const char*)
         strcat(data, buffer);
 #endif
 
+#if HASP_USE_PROFILER > 0
+        profiler_stats_t loop;
+        profilerGetStats(PROFILER_LOOP, &loop);
+        snprintf_P(buffer, sizeof(buffer), PSTR("\"loopHz\":%u,\"loopAvg\":%u,\"loopMax\":%u,"),
+                   profilerGetFrequency(), loop.avg, loop.max);
+        strcat(data, buffer);
+#endif
+
         snprintf_P(buffer, sizeof(buffer), PSTR("\"tftDriver\":\"%s\",\"tftWidth\":%u,\"tftHeight\":%u}"),
                    Utilities::tft_driver_name().c_str(), (TFT_WIDTH), (TFT_HEIGHT));
         strcat(data, buffer);
     }
     mqtt_send_state(F("statusupdate"), data);
-    dispatchLastMillis = millis();
 
     /* if(updateEspAvailable) {
             mqttStatusPayload += F("\"updateEspAvailable\":true,");
@@ -1008,6 +1425,14 @@ void dispatchSetup()
     dispatch_add_command(PSTR("brightness"), dispatch_dim);
     dispatch_add_command(PSTR("light"), dispatch_backlight);
     dispatch_add_command(PSTR("moodlight"), dispatch_moodlight);
+    dispatch_add_command(PSTR("coalesce"), dispatch_coalesce);
+    dispatch_add_command(PSTR("rules"), dispatch_rules);
+    dispatch_add_command(PSTR("suppressed"), dispatch_suppressed);
+    dispatch_add_command(PSTR("imgcache"), dispatch_imgcache);
+    dispatch_add_command(PSTR("background"), dispatch_background);
+#if HASP_USE_PROFILER > 0
+    dispatch_add_command(PSTR("profiler"), dispatch_profiler);
+#endif
     dispatch_add_command(PSTR("calibrate"), dispatch_calibrate);
     dispatch_add_command(PSTR("update"), dispatch_web_update);
     dispatch_add_command(PSTR("reboot"), dispatch_reboot);
@@ -1020,17 +1445,25 @@ void dispatchSetup()
     /* WARNING: remember to expand the commands array when adding new commands */
 }
 
-void dispatchLoop()
+// Returns the time in ms until the gui needs to run again
+uint32_t dispatchLoop()
 {
-    lv_task_handler(); // process animations
+    uint32_t next = lv_task_handler(); // process animations
+    uint32_t hold = guiGetRefreshHold();
+    if(hold > 0 && hold < next) next = hold; // wake up to resume the refresh
+    dispatch_coalesce_loop();
+    hasp_rules_loop();
+    return next;
 }
 
 #if 1 || ARDUINO
 void dispatchEverySecond()
 {
-    if(dispatch_setings.teleperiod > 0 && (millis() - dispatchLastMillis) >= dispatch_setings.teleperiod * 1000) {
-        dispatchLastMillis += dispatch_setings.teleperiod * 1000;
-        dispatch_output_statusupdate(NULL, NULL);
+    static uint32_t coalesce_last_staged = 0;
+    if(dispatch_coalesce_stats.staged != coalesce_last_staged) {
+        coalesce_last_staged = dispatch_coalesce_stats.staged;
+        LOG_VERBOSE(TAG_MSGR, F("Coalesce: %u staged, %u coalesced, %u sent"), dispatch_coalesce_stats.staged,
+                    dispatch_coalesce_stats.coalesced, dispatch_coalesce_stats.sent);
     }
 }
 #else
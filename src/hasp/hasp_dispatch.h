@@ -7,9 +7,26 @@
 #include "ArduinoJson.h"
 #include "lvgl.h"
 
+#ifndef DISPATCH_COALESCE_MS
+#define DISPATCH_COALESCE_MS 250 // minimum interval between value updates of the same object, 0 = disabled
+#endif
+
+#ifndef DISPATCH_COALESCE_SLOTS
+#define DISPATCH_COALESCE_SLOTS 8 // number of object attributes that can have a pending update
+#endif
+
 struct dispatch_conf_t
 {
     uint16_t teleperiod;
+    uint16_t coalesce; // ms
+};
+
+struct dispatch_coalesce_stats_t
+{
+    uint32_t staged;    // value changes handed to the queue
+    uint32_t coalesced; // value changes replaced by a newer value before being sent
+    uint32_t sent;      // state messages actually published
+    uint8_t pending;    // slots currently waiting to be sent
 };
 
 enum hasp_event_t { // even = released, odd = pressed
@@ -27,7 +44,7 @@ enum hasp_event_t { // even = released, odd = pressed
 
 /* ===== Default Event Processors ===== */
 void dispatchSetup(void);
-void dispatchLoop(void);
+uint32_t dispatchLoop(void);
 void dispatchEverySecond(void);
 void dispatchStart(void);
 void dispatchStop(void);
@@ -41,6 +58,8 @@ void dispatch_parse_jsonl(Stream& stream);
 #else
 void dispatch_parse_jsonl(std::istringstream& stream);
 #endif
+void dispatch_parse_json(const char*, const char* payload);
+void dispatch_parse_jsonl(const char*, const char* payload);
 
 void dispatch_clear_page(const char* page);
 void dispatch_json_error(uint8_t tag, DeserializationError& jsonError);
@@ -64,6 +83,8 @@ void dispatch_object_event(lv_obj_t* obj, uint8_t eventid);
 bool dispatch_get_event_state(uint8_t eventid);
 void dispatch_get_event_name(uint8_t eventid, char* buffer, size_t size);
 void dispatch_object_value_changed(lv_obj_t* obj, int16_t state);
+void dispatch_object_color_changed(lv_obj_t* obj, lv_color_t color);
+void dispatch_object_value_flush(lv_obj_t* obj);
 
 void dispatch_normalized_group_value(uint8_t groupid, uint16_t value, lv_obj_t* obj);
 
@@ -73,6 +94,8 @@ void dispatch_send_obj_attribute_color(uint8_t pageid, uint8_t btnid, const char
                                        uint8_t b);
 
 /* ===== Getter and Setter Functions ===== */
+uint16_t dispatch_get_teleperiod(void);
+void dispatch_get_coalesce_stats(dispatch_coalesce_stats_t* stats);
 
 /* ===== Read/Write Configuration ===== */
 
@@ -0,0 +1,372 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Decoded image cache
+ * The cache decoder answers for file images only. On a miss it hands the image to the next decoder that
+ * accepts it and copies the result: the full image of a decoder that decodes at once, like the PNG decoder,
+ * or the lines of a true color image read from the file. Later opens point lvgl at the cached pixels.
+ * Images in other formats, or larger than the budget, are left to their own decoder. Strip-streamed .bg
+ * backgrounds are passed over without being opened, they are drawn from the file by design. */
+
+#include "hasplib.h"
+
+#include "lv_misc/lv_gc.h"
+
+#if HASP_USE_DEBUG > 0
+#include "../hasp_debug.h"
+#endif
+
+#if !defined(ARDUINO_ARCH_ESP32) && !defined(ARDUINO_ARCH_ESP8266)
+#include <sys/stat.h>
+
+#ifndef LV_FS_PC_PATH
+#define LV_FS_PC_PATH "/fs"
+#endif
+#endif
+
+#if HASP_IMG_CACHE_SIZE > 0
+
+struct hasp_img_entry_t
+{
+    hasp_img_entry_t* next; // less recently used
+    uint8_t* data;
+    uint32_t size;    // bytes of pixel data
+    uint32_t mtime;   // modification time of the file when decoded
+    uint32_t fsize;   // size of the file when decoded, SPIFFS has no modification time
+    uint32_t checked; // millis() of the last check of the modification time
+    uint16_t refs;    // open descriptors, the entry is pinned while in use by lvgl
+    uint16_t hits;
+    bool stale; // the file changed while in use, drop once released
+    lv_img_header_t header;
+    char path[1]; // the path is allocated with the entry
+};
+
+static hasp_img_entry_t* img_cache_head; // most recently used
+static hasp_img_cache_stats_t img_cache_stats;
+static lv_img_decoder_t* img_cache_decoder;
+
+/* Skip the drive letter and the leading slash */
+static const char* img_cache_real_path(const char* path)
+{
+    if(path[0] != '\0' && path[1] == ':') path += 2;
+    while(*path == '/' || *path == '\\') path++;
+    return path;
+}
+
+/* Get the modification time and size of a file, both are 0 if it does not exist */
+static void img_cache_stat(const char* src, uint32_t* mtime, uint32_t* fsize)
+{
+    const char* path = img_cache_real_path(src);
+    *mtime           = 0;
+    *fsize           = 0;
+
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+    char filename[64];
+    snprintf_P(filename, sizeof(filename), PSTR("/%s"), path);
+    File file = HASP_FS.open(filename, "r");
+    if(!file) return;
+    *mtime = file.getLastWrite();
+    *fsize = file.size();
+    file.close();
+#endif
+
+#else
+    char filename[256];
+    snprintf(filename, sizeof(filename), LV_FS_PC_PATH "/%s", path);
+    struct stat info;
+    if(stat(filename, &info) != 0) return;
+    *mtime = (uint32_t)info.st_mtime;
+    *fsize = (uint32_t)info.st_size;
+#endif
+}
+
+static void* img_cache_alloc(size_t size)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    if(psramFound()) return ps_malloc(size);
+#endif
+    return malloc(size);
+}
+
+static void img_cache_remove(hasp_img_entry_t* entry)
+{
+    hasp_img_entry_t** link = &img_cache_head;
+    while(*link != entry) link = &(*link)->next;
+    *link = entry->next;
+
+    img_cache_stats.used -= entry->size;
+    img_cache_stats.count--;
+    free(entry->data);
+    free(entry);
+}
+
+/* Is the image shown by an object on the active page or the top layer */
+static bool img_cache_is_visible(lv_obj_t* parent, const char* path)
+{
+    lv_obj_t* child = lv_obj_get_child(parent, NULL);
+    while(child) {
+        if(check_obj_type(child, LV_HASP_IMAGE) && lv_img_src_get_type(lv_img_get_src(child)) == LV_IMG_SRC_FILE &&
+           !strcmp(lv_img_get_file_name(child), path))
+            return true;
+        if(img_cache_is_visible(child, path)) return true;
+        child = lv_obj_get_child(parent, child);
+    }
+    return false;
+}
+
+static bool img_cache_is_pinned(hasp_img_entry_t* entry)
+{
+    return entry->refs > 0 || img_cache_is_visible(lv_scr_act(), entry->path) ||
+           img_cache_is_visible(lv_layer_top(), entry->path);
+}
+
+/* Evict the least recently used entries that are not pinned until size bytes are free */
+static bool img_cache_make_room(uint32_t size)
+{
+    while(img_cache_stats.used + size > img_cache_stats.size) {
+        hasp_img_entry_t* victim = NULL;
+        for(hasp_img_entry_t* entry = img_cache_head; entry; entry = entry->next) {
+            if(!img_cache_is_pinned(entry)) victim = entry; // the last one is the least recently used
+        }
+        if(!victim) return false;
+
+        img_cache_remove(victim);
+        img_cache_stats.evictions++;
+    }
+    return true;
+}
+
+/* Find a cached image and mark it as most recently used, a changed file drops the entry */
+static hasp_img_entry_t* img_cache_find(const char* path)
+{
+    hasp_img_entry_t** link = &img_cache_head;
+    for(hasp_img_entry_t* entry = img_cache_head; entry; link = &entry->next, entry = entry->next) {
+        if(entry->stale || strcmp(entry->path, path)) continue;
+
+        if(millis() - entry->checked >= HASP_IMG_CACHE_RECHECK) {
+            entry->checked = millis();
+            uint32_t mtime, fsize;
+            img_cache_stat(path, &mtime, &fsize);
+            if(mtime != entry->mtime || fsize != entry->fsize) {
+                if(entry->refs == 0)
+                    img_cache_remove(entry);
+                else
+                    entry->stale = true;
+                return NULL;
+            }
+        }
+
+        *link          = entry->next;
+        entry->next    = img_cache_head;
+        img_cache_head = entry;
+        return entry;
+    }
+    return NULL;
+}
+
+/* Copy the image of an open descriptor into a new entry */
+static hasp_img_entry_t* img_cache_add(const char* path, lv_img_decoder_dsc_t* dsc)
+{
+    lv_img_header_t* header = &dsc->header;
+    bool true_color         = header->cf == LV_IMG_CF_TRUE_COLOR || header->cf == LV_IMG_CF_TRUE_COLOR_ALPHA ||
+                      header->cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED;
+    uint32_t size = lv_img_buf_get_img_size(header->w, header->h, header->cf);
+
+    /* Images over half the budget would flush all other images */
+    if(size == 0 || size > img_cache_stats.size / 2 ||
+       (!dsc->img_data && (!true_color || !dsc->decoder->read_line_cb)) || !img_cache_make_room(size)) {
+        img_cache_stats.skipped++;
+        return NULL;
+    }
+
+    hasp_img_entry_t* entry = (hasp_img_entry_t*)calloc(1, sizeof(hasp_img_entry_t) + strlen(path));
+    if(!entry) return NULL;
+    entry->data = (uint8_t*)img_cache_alloc(size);
+    if(!entry->data) {
+        free(entry);
+        return NULL;
+    }
+
+    if(dsc->img_data) {
+        memcpy(entry->data, dsc->img_data, size);
+    } else {
+        uint32_t stride = size / header->h;
+        for(lv_coord_t y = 0; y < (lv_coord_t)header->h; y++) {
+            if(lv_img_decoder_read_line(dsc, 0, y, header->w, entry->data + y * stride) != LV_RES_OK) {
+                free(entry->data);
+                free(entry);
+                return NULL;
+            }
+        }
+    }
+
+    strcpy(entry->path, path);
+    img_cache_stat(path, &entry->mtime, &entry->fsize);
+    entry->header  = *header;
+    entry->size    = size;
+    entry->checked = millis();
+    entry->next    = img_cache_head;
+    img_cache_head = entry;
+
+    img_cache_stats.used += size;
+    img_cache_stats.count++;
+    return entry;
+}
+
+/* ===== Decoder Callbacks ===== */
+
+static lv_res_t img_cache_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+    if(lv_img_src_get_type(src) != LV_IMG_SRC_FILE || hasp_background_is_file(src)) return LV_RES_INV;
+
+    hasp_img_entry_t* entry = img_cache_find((const char*)src);
+    if(entry) {
+        *header = entry->header;
+        return LV_RES_OK;
+    }
+
+    lv_img_decoder_t* d;
+    _LV_LL_READ(LV_GC_ROOT(_lv_img_defoder_ll), d)
+    {
+        if(d == decoder || !d->info_cb || !d->open_cb) continue;
+        if(d->info_cb(d, src, header) == LV_RES_OK) return LV_RES_OK;
+    }
+    return LV_RES_INV;
+}
+
+static lv_res_t img_cache_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    if(hasp_background_is_file(dsc->src)) return LV_RES_INV;
+
+    const char* path        = (const char*)dsc->src;
+    hasp_img_entry_t* entry = img_cache_find(path);
+
+    if(!entry) {
+        img_cache_stats.misses++;
+
+        /* Open the image with the next decoder that accepts it */
+        lv_img_decoder_t* d;
+        _LV_LL_READ(LV_GC_ROOT(_lv_img_defoder_ll), d)
+        {
+            if(d == decoder || !d->info_cb || !d->open_cb) continue;
+            if(d->info_cb(d, dsc->src, &dsc->header) != LV_RES_OK) continue;
+
+            dsc->decoder   = d;
+            dsc->img_data  = NULL;
+            dsc->user_data = NULL;
+            if(d->open_cb(d, dsc) != LV_RES_OK) continue;
+
+            entry = img_cache_add(path, dsc);
+            if(!entry) return LV_RES_OK; // not cached, lvgl continues with the other decoder
+
+            if(d->close_cb) d->close_cb(d, dsc);
+            dsc->decoder = decoder;
+            break;
+        }
+        if(!entry) return LV_RES_INV;
+
+    } else {
+        img_cache_stats.hits++;
+        entry->hits++;
+    }
+
+    entry->refs++;
+    dsc->header    = entry->header;
+    dsc->img_data  = entry->data;
+    dsc->user_data = entry;
+    return LV_RES_OK;
+}
+
+static void img_cache_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+    hasp_img_entry_t* entry = (hasp_img_entry_t*)dsc->user_data;
+    if(!entry) return;
+
+    if(entry->refs > 0) entry->refs--;
+    if(entry->stale && entry->refs == 0) img_cache_remove(entry);
+
+    dsc->img_data  = NULL;
+    dsc->user_data = NULL;
+}
+
+/* ===== Default Event Processors ===== */
+
+// Register the cache as the first decoder, after the other decoders have been created
+void hasp_img_cache_setup()
+{
+    if(img_cache_decoder) return;
+
+    img_cache_stats.size = HASP_IMG_CACHE_SIZE;
+#if defined(ARDUINO_ARCH_ESP32)
+    if(psramFound()) img_cache_stats.size = HASP_IMG_CACHE_SIZE_PSRAM;
+#endif
+
+    img_cache_decoder = lv_img_decoder_create();
+    lv_img_decoder_set_info_cb(img_cache_decoder, img_cache_info);
+    lv_img_decoder_set_open_cb(img_cache_decoder, img_cache_open);
+    lv_img_decoder_set_close_cb(img_cache_decoder, img_cache_close);
+
+    LOG_VERBOSE(TAG_LVGL, F("Image cache: %u bytes"), img_cache_stats.size);
+}
+
+/* ===== Special Event Processors ===== */
+
+// Drop a cached image after its file changed, or all unpinned images if path is NULL
+void hasp_img_cache_invalidate(const char* path)
+{
+    if(path) path = img_cache_real_path(path);
+
+    hasp_img_entry_t* entry = img_cache_head;
+    while(entry) {
+        hasp_img_entry_t* next = entry->next;
+        if(!path || !strcmp(img_cache_real_path(entry->path), path)) {
+            if(entry->refs == 0)
+                img_cache_remove(entry);
+            else if(path)
+                entry->stale = true;
+        }
+        entry = next;
+    }
+}
+
+// Log the cached images, most recently used first
+void hasp_img_cache_dump()
+{
+    for(hasp_img_entry_t* entry = img_cache_head; entry; entry = entry->next) {
+        LOG_INFO(TAG_LVGL, F("%s %ux%u cf %u, %u bytes, %u hits%s%s"), entry->path, entry->header.w,
+                 entry->header.h, entry->header.cf, entry->size, entry->hits, entry->refs ? ", open" : "",
+                 entry->stale ? ", stale" : "");
+    }
+}
+
+#else
+
+void hasp_img_cache_setup()
+{}
+
+void hasp_img_cache_invalidate(const char*)
+{}
+
+void hasp_img_cache_dump()
+{}
+
+static hasp_img_cache_stats_t img_cache_stats;
+
+#endif // HASP_IMG_CACHE_SIZE
+
+/* ===== Getter and Setter Functions ===== */
+
+void hasp_img_cache_get_stats(hasp_img_cache_stats_t* stats)
+{
+    *stats = img_cache_stats;
+}
+
+size_t hasp_img_cache_get_status(char* buffer, size_t size)
+{
+    return snprintf_P(buffer, size,
+                      PSTR("{\"hits\":%u,\"misses\":%u,\"evictions\":%u,\"skipped\":%u,\"images\":%u,\"used\":%u,"
+                           "\"size\":%u}"),
+                      img_cache_stats.hits, img_cache_stats.misses, img_cache_stats.evictions,
+                      img_cache_stats.skipped, img_cache_stats.count, img_cache_stats.used, img_cache_stats.size);
+}
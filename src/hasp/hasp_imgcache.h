@@ -0,0 +1,57 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_IMGCACHE_H
+#define HASP_IMGCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Decoded image cache
+ * Registered as the first image decoder, it keeps the pixels of decoded file images in RAM so an image used
+ * by several objects or pages is only decoded once. Entries are keyed by path, modification time and size and
+ * evicted least recently used first, images that are open in lvgl or shown on the active page are pinned.
+ * SPIFFS keeps no modification time, a file rewritten there with the same size is only noticed when it is
+ * replaced through the web interface or the cache is cleared.
+ */
+#ifndef HASP_IMG_CACHE_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define HASP_IMG_CACHE_SIZE (48 * 1024) // byte budget of the decoded pixels, 0 disables the cache
+#elif defined(ARDUINO_ARCH_ESP8266)
+#define HASP_IMG_CACHE_SIZE (8 * 1024)
+#else
+#define HASP_IMG_CACHE_SIZE (1024 * 1024)
+#endif
+#endif
+
+#ifndef HASP_IMG_CACHE_SIZE_PSRAM
+#define HASP_IMG_CACHE_SIZE_PSRAM (512 * 1024) // byte budget when the pixels can be stored in PSRAM
+#endif
+
+#ifndef HASP_IMG_CACHE_RECHECK
+#define HASP_IMG_CACHE_RECHECK 5000 // ms between checks of the modification time and size of a cached file
+#endif
+
+struct hasp_img_cache_stats_t
+{
+    uint32_t hits;      // images opened from the cache
+    uint32_t misses;    // images decoded from the file
+    uint32_t evictions; // images dropped to stay within the budget
+    uint32_t skipped;   // images too large or in a format that is not cached
+    uint32_t used;      // bytes of decoded pixels
+    uint32_t size;      // byte budget
+    uint16_t count;     // cached images
+};
+
+/* ===== Default Event Processors ===== */
+void hasp_img_cache_setup(void);
+
+/* ===== Special Event Processors ===== */
+void hasp_img_cache_invalidate(const char* path);
+void hasp_img_cache_dump(void);
+
+/* ===== Getter and Setter Functions ===== */
+void hasp_img_cache_get_stats(hasp_img_cache_stats_t* stats);
+size_t hasp_img_cache_get_status(char* buffer, size_t size);
+
+#endif
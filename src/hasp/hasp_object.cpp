@@ -28,8 +28,158 @@ const char** btnmatrix_default_map; // memory pointer to lvgl default btnmatrix
 // static unsigned long last_change_event = 0;
 static bool last_press_was_short = false; // Avoid SHORT + UP double events
 
+/* Object registry: one lazily allocated table of 256 object pointers per page, indexed by objid
+ * Slot 0 is the top layer (page 0), slot HASP_NUM_PAGES + 1 is the system layer (page 255) */
+#define HASP_REGISTRY_SLOTS (HASP_NUM_PAGES + 2)
+static lv_obj_t** obj_registry[HASP_REGISTRY_SLOTS];
+
+/* Group index: the member objects of each groupid, allocated on first use */
+struct hasp_group_t
+{
+    lv_obj_t** obj;
+    uint16_t count;
+    uint16_t size;
+};
+static hasp_group_t* obj_groups;
+
+// ##################### Object Registry ########################################################
+
+static inline int16_t hasp_registry_slot(uint8_t pageid)
+{
+    if(pageid == 255) return HASP_NUM_PAGES + 1;
+    if(pageid > HASP_NUM_PAGES) return -1;
+    return pageid;
+}
+
+/**
+ * Add an object to the lookup table of the page it lives on, using its current id
+ * @param obj the object to register, objects with id 0 are not registered
+ */
+void hasp_object_registry_add(lv_obj_t* obj)
+{
+    uint8_t pageid;
+    uint8_t objid;
+    if(!obj || !hasp_find_id_from_obj(obj, &pageid, &objid)) return;
+
+    int16_t slot = hasp_registry_slot(pageid);
+    if(slot < 0) return;
+
+    if(!obj_registry[slot]) {
+        obj_registry[slot] = (lv_obj_t**)calloc(256, sizeof(lv_obj_t*));
+        if(!obj_registry[slot]) {
+            LOG_ERROR(TAG_HASP, F(D_ERROR_OUT_OF_MEMORY));
+            return;
+        }
+    }
+
+    if(obj_registry[slot][objid] && obj_registry[slot][objid] != obj) {
+        LOG_WARNING(TAG_HASP, F("Duplicate id " HASP_OBJECT_NOTATION " replaced"), pageid, objid);
+    }
+    obj_registry[slot][objid] = obj;
+}
+
+/**
+ * Remove an object from the lookup table, only if the entry still points to this object
+ * @param obj the object to unregister
+ */
+void hasp_object_registry_remove(lv_obj_t* obj)
+{
+    uint8_t pageid;
+    uint8_t objid;
+    if(!obj || !hasp_find_id_from_obj(obj, &pageid, &objid)) return;
+
+    int16_t slot = hasp_registry_slot(pageid);
+    if(slot < 0 || !obj_registry[slot]) return;
+
+    if(obj_registry[slot][objid] == obj) obj_registry[slot][objid] = NULL;
+}
+
+/**
+ * Forget all registered objects of a page
+ * @param pageid the page to clear
+ */
+void hasp_object_registry_clear(uint8_t pageid)
+{
+    int16_t slot = hasp_registry_slot(pageid);
+    if(slot < 0 || !obj_registry[slot]) return;
+
+    memset(obj_registry[slot], 0, 256 * sizeof(lv_obj_t*));
+}
+
+// ##################### Group Index ########################################################
+
+/**
+ * Add an object to the member list of its current groupid
+ * @param obj the object to add, objects in group 0 are not indexed
+ */
+void hasp_object_group_add(lv_obj_t* obj)
+{
+    uint8_t groupid = obj->user_data.groupid;
+    if(groupid == 0) return;
+
+    if(!obj_groups) {
+        obj_groups = (hasp_group_t*)calloc(256, sizeof(hasp_group_t));
+        if(!obj_groups) {
+            LOG_ERROR(TAG_HASP, F(D_ERROR_OUT_OF_MEMORY));
+            return;
+        }
+    }
+
+    hasp_group_t* group = &obj_groups[groupid];
+    for(uint16_t i = 0; i < group->count; i++)
+        if(group->obj[i] == obj) return; // already a member
+
+    if(group->count >= group->size) {
+        uint16_t size      = group->size + 4;
+        lv_obj_t** members = (lv_obj_t**)realloc(group->obj, size * sizeof(lv_obj_t*));
+        if(!members) {
+            LOG_ERROR(TAG_HASP, F(D_ERROR_OUT_OF_MEMORY));
+            return;
+        }
+        group->obj  = members;
+        group->size = size;
+    }
+    group->obj[group->count++] = obj;
+}
+
+/**
+ * Remove an object from the member list of its current groupid
+ * @param obj the object to remove
+ */
+void hasp_object_group_remove(lv_obj_t* obj)
+{
+    uint8_t groupid = obj->user_data.groupid;
+    if(groupid == 0 || !obj_groups) return;
+
+    hasp_group_t* group = &obj_groups[groupid];
+    for(uint16_t i = 0; i < group->count; i++) {
+        if(group->obj[i] == obj) {
+            group->obj[i] = group->obj[--group->count]; // order is not important
+            return;
+        }
+    }
+}
+
 // ##################### Object Finders ########################################################
 
+/**
+ * Constant-time lookup of an object on a page
+ * @param pageid the page number of the object
+ * @param objid the id of the object, 0 returns the page itself
+ * @return the object or NULL when not found
+ */
+lv_obj_t* hasp_find_obj_from_page_id(uint8_t pageid, uint8_t objid)
+{
+    if(objid == 0) return get_page_obj(pageid);
+
+    int16_t slot = hasp_registry_slot(pageid);
+    if(slot < 0 || !obj_registry[slot]) return NULL;
+
+    return obj_registry[slot][objid];
+}
+
+/* Recursive tree walk, only used for screens that are not hasp pages */
+
 lv_obj_t* hasp_find_obj_from_parent_id(lv_obj_t* parent, uint8_t objid)
 {
     if(objid == 0 || parent == nullptr) return parent;
@@ -64,11 +214,6 @@ lv_obj_t* hasp_find_obj_from_parent_id(lv_obj_t* parent, uint8_t objid)
     return NULL;
 }
 
-// lv_obj_t * hasp_find_obj_from_page_id(uint8_t pageid, uint8_t objid)
-// {
-//     return hasp_find_obj_from_parent_id(get_page_obj(pageid), objid);
-// }
-
 bool hasp_find_id_from_obj(lv_obj_t* obj, uint8_t* pageid, uint8_t* objid)
 {
     if(!get_page_id(obj, pageid)) return false;
@@ -496,6 +641,9 @@ void slider_event_handler(lv_obj_t* obj, lv_event_t event)
         dispatch_object_value_changed(obj, val);
         dispatch_normalized_group_value(obj->user_data.groupid, NORMALIZE(val, min, max), obj);
 
+    } else if(event == LV_EVENT_RELEASED || event == LV_EVENT_PRESS_LOST) {
+        dispatch_object_value_flush(obj); // always deliver the final value
+
     } else if(event == LV_EVENT_DELETE) {
         LOG_VERBOSE(TAG_HASP, F(D_OBJECT_DELETED));
         hasp_object_delete(obj);
@@ -509,75 +657,123 @@ void slider_event_handler(lv_obj_t* obj, lv_event_t event)
  */
 static void cpicker_event_handler(lv_obj_t* obj, lv_event_t event)
 {
-    char color[6];
-    snprintf_P(color, sizeof(color), PSTR("color"));
-
     if(event == LV_EVENT_VALUE_CHANGED) {
-        hasp_update_sleep_state(); // wakeup?
-        hasp_send_obj_attribute_color(obj, color, lv_cpicker_get_color(obj));
+        dispatch_object_color_changed(obj, lv_cpicker_get_color(obj));
+    } else if(event == LV_EVENT_RELEASED || event == LV_EVENT_PRESS_LOST) {
+        dispatch_object_value_flush(obj); // always deliver the final color
     } else if(event == LV_EVENT_DELETE) {
         LOG_VERBOSE(TAG_HASP, F(D_OBJECT_DELETED));
         hasp_object_delete(obj);
     }
 }
 
+/**
+ * Called when an object without other event handling is deleted, e.g. pages, tabviews and spinners
+ * @param obj pointer to the object being deleted
+ * @param event type of event that occured
+ */
+static void deleted_event_handler(lv_obj_t* obj, lv_event_t event)
+{
+    if(event == LV_EVENT_DELETE) {
+        LOG_VERBOSE(TAG_HASP, F(D_OBJECT_DELETED));
+        hasp_object_delete(obj);
+    }
+}
+
 // ##################### State Changers ########################################################
 
-// TODO make this a recursive function that goes over all objects only ONCE
 void object_set_group_state(uint8_t groupid, uint8_t eventid, lv_obj_t* src_obj)
 {
-    if(groupid == 0) return;
+    if(groupid == 0 || !obj_groups) return;
     bool state = dispatch_get_event_state(eventid);
 
-    for(uint8_t page = 0; page < HASP_NUM_PAGES; page++) {
-        uint8_t startid = 1;
-        for(uint8_t objid = startid; objid < 20; objid++) {
-            lv_obj_t* obj = hasp_find_obj_from_parent_id(get_page_obj(page), objid);
-            if(obj && obj != src_obj && obj->user_data.groupid == groupid) { // skip source object, if set
-                lv_obj_set_state(obj, state ? LV_STATE_PRESSED | LV_STATE_CHECKED : LV_STATE_DEFAULT);
-            }
+    hasp_group_t* group = &obj_groups[groupid];
+    for(uint16_t i = 0; i < group->count; i++) {
+        lv_obj_t* obj = group->obj[i];
+        if(obj != src_obj) { // skip source object, if set
+            lv_obj_set_state(obj, state ? LV_STATE_PRESSED | LV_STATE_CHECKED : LV_STATE_DEFAULT);
         }
     }
 }
 
-void object_set_group_value(lv_obj_t* parent, uint8_t groupid, const char* payload)
+void object_set_group_value(uint8_t groupid, const char* payload, lv_obj_t* src_obj)
 {
-    if(groupid == 0 || parent == nullptr) return;
+    if(groupid == 0 || !obj_groups) return;
 
-    lv_obj_t* child;
-    child = lv_obj_get_child(parent, NULL);
-    while(child) {
-        /* child found, update it */
-        if(groupid == child->user_data.groupid) hasp_process_obj_attribute_val(child, NULL, payload, true);
-
-        /* update grandchildren */
-        object_set_group_value(child, groupid, payload);
-
-        /* check tabs */
-        if(check_obj_type(child, LV_HASP_TABVIEW)) {
-            //#if LVGL_VERSION_MAJOR == 7
-            uint16_t tabcount = lv_tabview_get_tab_count(child);
-            for(uint16_t i = 0; i < tabcount; i++) {
-                lv_obj_t* tab = lv_tabview_get_tab(child, i);
-                LOG_VERBOSE(TAG_HASP, F("Found tab %i"), i);
-                if(tab->user_data.groupid && groupid == tab->user_data.groupid)
-                    hasp_process_obj_attribute_val(tab, NULL, payload, true); /* tab found, update it */
-
-                /* check grandchildren */
-                object_set_group_value(tab, groupid, payload);
-            }
-            //#endif
-        }
+    hasp_group_t* group = &obj_groups[groupid];
+    for(uint16_t i = 0; i < group->count; i++) {
+        lv_obj_t* obj = group->obj[i];
+        if(obj != src_obj) hasp_process_obj_attribute_val(obj, NULL, payload, true); // skip source object, if set
+    }
+}
 
-        /* try next sibling */
-        child = lv_obj_get_child(parent, child);
+// Get the value range of an object, returns false for objects without a value
+static bool object_get_value_range(lv_obj_t* obj, int32_t& min, int32_t& max)
+{
+    min = 0;
+    switch(obj->user_data.objid) {
+        case LV_HASP_BUTTON:
+            max = 1;
+            return lv_btn_get_checkable(obj);
+        case LV_HASP_CHECKBOX:
+        case LV_HASP_SWITCH:
+            max = 1;
+            return true;
+        case LV_HASP_LED:
+            max = 255;
+            return true;
+        case LV_HASP_DROPDOWN:
+            max = lv_dropdown_get_option_cnt(obj) - 1;
+            return max > 0;
+        case LV_HASP_ROLLER:
+            max = lv_roller_get_option_cnt(obj) - 1;
+            return max > 0;
+        case LV_HASP_SLIDER:
+            min = lv_slider_get_min_value(obj);
+            max = lv_slider_get_max_value(obj);
+            return true;
+        case LV_HASP_ARC:
+            min = lv_arc_get_min_value(obj);
+            max = lv_arc_get_max_value(obj);
+            return true;
+        case LV_HASP_BAR:
+            min = lv_bar_get_min_value(obj);
+            max = lv_bar_get_max_value(obj);
+            return true;
+        case LV_HASP_GAUGE:
+            min = lv_gauge_get_min_value(obj);
+            max = lv_gauge_get_max_value(obj);
+            return true;
+        case LV_HASP_LMETER:
+            min = lv_linemeter_get_min_value(obj);
+            max = lv_linemeter_get_max_value(obj);
+            return true;
+        default:
+            return false;
     }
 }
 
-void object_set_group_value(uint8_t groupid, int16_t state)
+/**
+ * Set the members of a group to a normalized value, scaled to the range of each member
+ * @param groupid the group to update
+ * @param value 0 to 0xFFFF
+ * @param src_obj the object that changed the group value, it is skipped
+ */
+void object_set_normalized_group_value(uint8_t groupid, uint16_t value, lv_obj_t* src_obj)
 {
-    char payload[16];
-    itoa(state, payload, DEC);
+    if(groupid == 0 || !obj_groups) return;
+
+    hasp_group_t* group = &obj_groups[groupid];
+    for(uint16_t i = 0; i < group->count; i++) {
+        lv_obj_t* obj = group->obj[i];
+        int32_t min, max;
+        if(obj == src_obj || !object_get_value_range(obj, min, max)) continue;
+
+        char payload[12];
+        int32_t val = min + ((int64_t)value * (max - min) + 0x7FFF) / 0xFFFF; // rounded
+        itoa(val, payload, DEC);
+        hasp_process_obj_attribute_val(obj, NULL, payload, true);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -585,7 +781,7 @@ void object_set_group_value(uint8_t groupid, int16_t state)
 // Used in the dispatcher & hasp_new_object
 void hasp_process_attribute(uint8_t pageid, uint8_t objid, const char* attr, const char* payload)
 {
-    if(lv_obj_t* obj = hasp_find_obj_from_parent_id(get_page_obj(pageid), objid)) {
+    if(lv_obj_t* obj = hasp_find_obj_from_page_id(pageid, objid)) {
         hasp_process_obj_attribute(obj, attr, payload, strlen(payload) > 0);
     } else {
         LOG_WARNING(TAG_HASP, F(D_OBJECT_UNKNOWN " " HASP_OBJECT_NOTATION), pageid, objid);
@@ -597,7 +793,7 @@ void hasp_process_attribute(uint8_t pageid, uint8_t objid, const char* attr, con
 int hasp_parse_json_attributes(lv_obj_t* obj, const JsonObject& doc)
 {
     int i = 0;
-#ifdef WINDOWS
+#if defined(WINDOWS) || defined(POSIX)
     // String v((char *)0);
     // v.reserve(64);
     std::string v;
@@ -624,396 +820,421 @@ int hasp_parse_json_attributes(lv_obj_t* obj, const JsonObject& doc)
 }
 
 /**
- * Create a new object according to the json config
- * @param config Json representation for this object
- * @param saved_page_id the pageid to use when no pageid is specified in the Json, updated when it is specified so
- * following objects in the file can share the pageid
+ * Find an object on a page, or create it when it does not exist yet
+ * @param pageid the page of the object
+ * @param parentid the id of the parent object, 0 to place the object directly on the page
+ * @param id the id of the object, 0 refers to the parent object itself
+ * @param create false to only look up an existing object, when no object type is given
+ * @param sdbm the hashed object type
+ * @return the object, or NULL when it was not found and could not be created
  */
-void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
+lv_obj_t* hasp_find_or_create_object(uint8_t pageid, uint8_t parentid, uint8_t id, bool create, uint16_t sdbm)
 {
-    /* Page selection: page is the default parent_obj */
-    uint8_t pageid       = config[FPSTR(FP_PAGE)].isNull() ? saved_page_id : config[FPSTR(FP_PAGE)].as<uint8_t>();
-    lv_obj_t* parent_obj = get_page_obj(pageid);
+    lv_obj_t* parent_obj = hasp_find_obj_from_page_id(pageid, parentid);
     if(!parent_obj) {
-        LOG_WARNING(TAG_HASP, F(D_OBJECT_PAGE_UNKNOWN), pageid);
-        return;
-    } else {
-        saved_page_id = pageid; /* save the current pageid */
-    }
-
-    // lv_obj_t * parent_obj = page;
-    if(!config[FPSTR(FP_PARENTID)].isNull()) {
-        uint8_t parentid = config[FPSTR(FP_PARENTID)].as<uint8_t>();
-        parent_obj       = hasp_find_obj_from_parent_id(parent_obj, parentid);
-        if(!parent_obj) {
+        if(parentid) {
             LOG_WARNING(TAG_HASP, F("Parent ID " HASP_OBJECT_NOTATION " not found, skipping..."), pageid, parentid);
-            return;
         } else {
-            LOG_VERBOSE(TAG_HASP, F("Parent ID " HASP_OBJECT_NOTATION " found"), pageid, parentid);
+            LOG_WARNING(TAG_HASP, F(D_OBJECT_PAGE_UNKNOWN), pageid);
         }
+        return NULL;
+    } else if(parentid) {
+        LOG_VERBOSE(TAG_HASP, F("Parent ID " HASP_OBJECT_NOTATION " found"), pageid, parentid);
     }
 
-    uint16_t sdbm   = 0;
-    uint8_t id      = config[FPSTR(FP_ID)].as<uint8_t>();
-    uint8_t groupid = config[FPSTR(FP_GROUPID)].as<uint8_t>();
-
     /* Define Objects*/
-    lv_obj_t* obj = hasp_find_obj_from_parent_id(parent_obj, id);
-    if(!obj) {
+    lv_obj_t* obj = id ? hasp_find_obj_from_page_id(pageid, id) : parent_obj;
+    if(obj || !create) return obj; // found, or a comment
 
-        /* Create the object first */
-
-        /* Validate type */
-        if(config[FPSTR(FP_OBJID)].isNull()) { // TODO: obsolete objid
-            if(config[FPSTR(FP_OBJ)].isNull()) {
-                return; // comments
-            } else {
-                sdbm = Utilities::get_sdbm(config[FPSTR(FP_OBJ)].as<const char*>());
+    /* Create the object first */
+    switch(sdbm) {
+        /* ----- Basic Objects ------ */
+        case LV_HASP_BTNMATRIX:
+        case HASP_OBJ_BTNMATRIX:
+            obj = lv_btnmatrix_create(parent_obj, NULL);
+            if(obj) {
+                lv_btnmatrix_set_recolor(obj, true);
+                lv_obj_set_event_cb(obj, selector_event_handler);
+
+                lv_btnmatrix_ext_t* ext = (lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(obj);
+                btnmatrix_default_map   = ext->map_p; // store the static pointer to the default lvgl btnmap
+                obj->user_data.objid    = LV_HASP_BTNMATRIX;
             }
-        } else {
-            sdbm = config[FPSTR(FP_OBJID)].as<uint8_t>();
-        }
-
-        switch(sdbm) {
-            /* ----- Basic Objects ------ */
-            case LV_HASP_BTNMATRIX:
-            case HASP_OBJ_BTNMATRIX:
-                obj = lv_btnmatrix_create(parent_obj, NULL);
-                if(obj) {
-                    lv_btnmatrix_set_recolor(obj, true);
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-
-                    lv_btnmatrix_ext_t* ext = (lv_btnmatrix_ext_t*)lv_obj_get_ext_attr(obj);
-                    btnmatrix_default_map   = ext->map_p; // store the static pointer to the default lvgl btnmap
-                    obj->user_data.objid    = LV_HASP_BTNMATRIX;
-                }
-                break;
+            break;
 
-            case LV_HASP_TABLE:
-            case HASP_OBJ_TABLE:
-                obj = lv_table_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_TABLE;
-                }
-                break;
+        case LV_HASP_TABLE:
+        case HASP_OBJ_TABLE:
+            obj = lv_table_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_TABLE;
+            }
+            break;
 
-            case LV_HASP_BUTTON:
-            case HASP_OBJ_BTN:
-                obj = lv_btn_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_t* lbl = lv_label_create(obj, NULL);
-                    if(lbl) {
-                        lv_label_set_text(lbl, "");
-                        lv_label_set_recolor(lbl, true);
-                        lbl->user_data.objid = LV_HASP_LABEL;
-                        lv_obj_align(lbl, NULL, LV_ALIGN_CENTER, 0, 0);
-                    }
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_BUTTON;
+        case LV_HASP_BUTTON:
+        case HASP_OBJ_BTN:
+            obj = lv_btn_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_t* lbl = lv_label_create(obj, NULL);
+                if(lbl) {
+                    lv_label_set_text(lbl, "");
+                    lv_label_set_recolor(lbl, true);
+                    lbl->user_data.objid = LV_HASP_LABEL;
+                    lv_obj_align(lbl, NULL, LV_ALIGN_CENTER, 0, 0);
                 }
-                break;
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_BUTTON;
+            }
+            break;
 
-            case LV_HASP_CHECKBOX:
-            case HASP_OBJ_CHECKBOX:
-                obj = lv_checkbox_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, toggle_event_handler);
-                    obj->user_data.objid = LV_HASP_CHECKBOX;
-                }
-                break;
+        case LV_HASP_CHECKBOX:
+        case HASP_OBJ_CHECKBOX:
+            obj = lv_checkbox_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, toggle_event_handler);
+                obj->user_data.objid = LV_HASP_CHECKBOX;
+            }
+            break;
 
-            case LV_HASP_LABEL:
-            case HASP_OBJ_LABEL:
-                obj = lv_label_create(parent_obj, NULL);
-                if(obj) {
-                    lv_label_set_long_mode(obj, LV_LABEL_LONG_CROP);
-                    lv_label_set_recolor(obj, true);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LABEL;
-                }
-                break;
+        case LV_HASP_LABEL:
+        case HASP_OBJ_LABEL:
+            obj = lv_label_create(parent_obj, NULL);
+            if(obj) {
+                lv_label_set_long_mode(obj, LV_LABEL_LONG_CROP);
+                lv_label_set_recolor(obj, true);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LABEL;
+            }
+            break;
 
-            case LV_HASP_IMAGE:
-            case HASP_OBJ_IMG:
-                obj = lv_img_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_IMAGE;
-                }
-                break;
+        case LV_HASP_IMAGE:
+        case HASP_OBJ_IMG:
+            obj = lv_img_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_IMAGE;
+            }
+            break;
 
-            case LV_HASP_ARC:
-            case HASP_OBJ_ARC:
-                obj = lv_arc_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_ARC;
-                }
-                break;
+        case LV_HASP_ARC:
+        case HASP_OBJ_ARC:
+            obj = lv_arc_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_ARC;
+            }
+            break;
 
-            case LV_HASP_CONTAINER:
-            case HASP_OBJ_CONT:
-                obj = lv_cont_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_CONTAINER;
-                }
-                break;
+        case LV_HASP_CONTAINER:
+        case HASP_OBJ_CONT:
+            obj = lv_cont_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_CONTAINER;
+            }
+            break;
 
-            case LV_HASP_OBJECT:
-            case HASP_OBJ_OBJ:
-                obj = lv_obj_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_OBJECT;
-                }
-                break;
+        case LV_HASP_OBJECT:
+        case HASP_OBJ_OBJ:
+            obj = lv_obj_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_OBJECT;
+            }
+            break;
 
-            case LV_HASP_PAGE:
-            case HASP_OBJ_PAGE:
-                obj = lv_page_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_PAGE;
-                // No event handler for pages
-                break;
+        case LV_HASP_PAGE:
+        case HASP_OBJ_PAGE:
+            obj = lv_page_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, deleted_event_handler);
+                obj->user_data.objid = LV_HASP_PAGE;
+            }
+            break;
 
 #if LV_USE_WIN && LVGL_VERSION_MAJOR == 7
-            case LV_HASP_WINDOW:
-            case HASP_OBJ_WIN:
-                obj = lv_win_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_WINDOW;
-                // No event handler for pages
-                break;
+        case LV_HASP_WINDOW:
+        case HASP_OBJ_WIN:
+            obj = lv_win_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, deleted_event_handler);
+                obj->user_data.objid = LV_HASP_WINDOW;
+            }
+            break;
 
 #endif
 
 #if LVGL_VERSION_MAJOR == 8
-            case LV_HASP_LED:
-            case HASP_OBJ_LED:
-                obj = lv_led_create(parent_obj);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LED;
-                }
-                break;
+        case LV_HASP_LED:
+        case HASP_OBJ_LED:
+            obj = lv_led_create(parent_obj);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LED;
+            }
+            break;
 
-            case LV_HASP_TILEVIEW:
-            case HASP_OBJ_TILEVIEW:
-                obj = lv_tileview_create(parent_obj);
-                if(obj) obj->user_data.objid = LV_HASP_TILEVIEW;
-                // No event handler for tileviews
-                break;
+        case LV_HASP_TILEVIEW:
+        case HASP_OBJ_TILEVIEW:
+            obj = lv_tileview_create(parent_obj);
+            if(obj) {
+                lv_obj_set_event_cb(obj, deleted_event_handler);
+                obj->user_data.objid = LV_HASP_TILEVIEW;
+            }
+            break;
 
-            case LV_HASP_TABVIEW:
-            case HASP_OBJ_TABVIEW:
-                obj = lv_tabview_create(parent_obj, LV_DIR_TOP, 100);
-                // No event handler for tabs
-                if(obj) {
-                    lv_obj_t* tab;
-                    tab = lv_tabview_add_tab(obj, "tab 1");
-                    // lv_obj_set_user_data(tab, id + 1);
-                    tab = lv_tabview_add_tab(obj, "tab 2");
-                    // lv_obj_set_user_data(tab, id + 2);
-                    tab = lv_tabview_add_tab(obj, "tab 3");
-                    // lv_obj_set_user_data(tab, id + 3);
-
-                    obj->user_data.objid = LV_HASP_TABVIEW;
-                }
-                break;
+        case LV_HASP_TABVIEW:
+        case HASP_OBJ_TABVIEW:
+            obj = lv_tabview_create(parent_obj, LV_DIR_TOP, 100);
+            if(obj) {
+                lv_obj_set_event_cb(obj, deleted_event_handler);
+                lv_obj_t* tab;
+                tab = lv_tabview_add_tab(obj, "tab 1");
+                // lv_obj_set_user_data(tab, id + 1);
+                tab = lv_tabview_add_tab(obj, "tab 2");
+                // lv_obj_set_user_data(tab, id + 2);
+                tab = lv_tabview_add_tab(obj, "tab 3");
+                // lv_obj_set_user_data(tab, id + 3);
+
+                obj->user_data.objid = LV_HASP_TABVIEW;
+            }
+            break;
 
 #else
-            case LV_HASP_LED:
-            case HASP_OBJ_LED:
-                obj = lv_led_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LED;
-                }
-                break;
-
-            case LV_HASP_TILEVIEW:
-            case HASP_OBJ_TILEVIEW:
-                obj = lv_tileview_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_TILEVIEW;
+        case LV_HASP_LED:
+        case HASP_OBJ_LED:
+            obj = lv_led_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LED;
+            }
+            break;
 
-                // No event handler for tileviews
-                break;
+        case LV_HASP_TILEVIEW:
+        case HASP_OBJ_TILEVIEW:
+            obj = lv_tileview_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, deleted_event_handler);
+                obj->user_data.objid = LV_HASP_TILEVIEW;
+            }
+            break;
 
-            case LV_HASP_TABVIEW:
-            case HASP_OBJ_TABVIEW:
-                obj = lv_tabview_create(parent_obj, NULL);
-                // No event handler for tabs
-                if(obj) {
-                    lv_obj_t* tab;
-                    tab = lv_tabview_add_tab(obj, "tab 1");
-                    // lv_obj_set_user_data(tab, id + 1);
-                    tab = lv_tabview_add_tab(obj, "tab 2");
-                    // lv_obj_set_user_data(tab, id + 2);
-                    tab = lv_tabview_add_tab(obj, "tab 3");
-                    // lv_obj_set_user_data(tab, id + 3);
-
-                    obj->user_data.objid = LV_HASP_TABVIEW;
-                }
-                break;
+        case LV_HASP_TABVIEW:
+        case HASP_OBJ_TABVIEW:
+            obj = lv_tabview_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, deleted_event_handler);
+                lv_obj_t* tab;
+                tab = lv_tabview_add_tab(obj, "tab 1");
+                // lv_obj_set_user_data(tab, id + 1);
+                tab = lv_tabview_add_tab(obj, "tab 2");
+                // lv_obj_set_user_data(tab, id + 2);
+                tab = lv_tabview_add_tab(obj, "tab 3");
+                // lv_obj_set_user_data(tab, id + 3);
+
+                obj->user_data.objid = LV_HASP_TABVIEW;
+            }
+            break;
 
 #endif
-            /* ----- Color Objects ------ */
-            case LV_HASP_CPICKER:
-            case HASP_OBJ_CPICKER:
-                obj = lv_cpicker_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, cpicker_event_handler);
-                    obj->user_data.objid = LV_HASP_CPICKER;
-                }
-                break;
+        /* ----- Color Objects ------ */
+        case LV_HASP_CPICKER:
+        case HASP_OBJ_CPICKER:
+            obj = lv_cpicker_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, cpicker_event_handler);
+                obj->user_data.objid = LV_HASP_CPICKER;
+            }
+            break;
 
 #if LV_USE_SPINNER != 0
-            case LV_HASP_SPINNER:
-            case HASP_OBJ_SPINNER:
-                obj = lv_spinner_create(parent_obj, NULL);
-                if(obj) obj->user_data.objid = LV_HASP_SPINNER;
-                break;
+        case LV_HASP_SPINNER:
+        case HASP_OBJ_SPINNER:
+            obj = lv_spinner_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, deleted_event_handler);
+                obj->user_data.objid = LV_HASP_SPINNER;
+            }
+            break;
 
 #endif
-            /* ----- Range Objects ------ */
-            case LV_HASP_SLIDER:
-            case HASP_OBJ_SLIDER:
-                obj = lv_slider_create(parent_obj, NULL);
-                if(obj) {
-                    lv_slider_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, slider_event_handler);
-                    obj->user_data.objid = LV_HASP_SLIDER;
-                }
-                // bool knobin = config[F("knobin")].as<bool>() | true;
-                // lv_slider_set_knob_in(obj, knobin);
-                break;
-
-            case LV_HASP_GAUGE:
-            case HASP_OBJ_GAUGE:
-                obj = lv_gauge_create(parent_obj, NULL);
-                if(obj) {
-                    lv_gauge_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_GAUGE;
-                }
-                break;
+        /* ----- Range Objects ------ */
+        case LV_HASP_SLIDER:
+        case HASP_OBJ_SLIDER:
+            obj = lv_slider_create(parent_obj, NULL);
+            if(obj) {
+                lv_slider_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, slider_event_handler);
+                obj->user_data.objid = LV_HASP_SLIDER;
+            }
+            // bool knobin = config[F("knobin")].as<bool>() | true;
+            // lv_slider_set_knob_in(obj, knobin);
+            break;
 
-            case LV_HASP_BAR:
-            case HASP_OBJ_BAR:
-                obj = lv_bar_create(parent_obj, NULL);
-                if(obj) {
-                    lv_bar_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_BAR;
-                }
-                break;
+        case LV_HASP_GAUGE:
+        case HASP_OBJ_GAUGE:
+            obj = lv_gauge_create(parent_obj, NULL);
+            if(obj) {
+                lv_gauge_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_GAUGE;
+            }
+            break;
 
-            case LV_HASP_LMETER:
-            case HASP_OBJ_LMETER:
-                obj = lv_linemeter_create(parent_obj, NULL);
-                if(obj) {
-                    lv_linemeter_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
-                    obj->user_data.objid = LV_HASP_LMETER;
-                }
-                break;
+        case LV_HASP_BAR:
+        case HASP_OBJ_BAR:
+            obj = lv_bar_create(parent_obj, NULL);
+            if(obj) {
+                lv_bar_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_BAR;
+            }
+            break;
 
-            case LV_HASP_CHART:
-            case HASP_OBJ_CHART:
-                obj = lv_chart_create(parent_obj, NULL);
-                if(obj) {
-                    lv_chart_set_range(obj, 0, 100);
-                    lv_obj_set_event_cb(obj, generic_event_handler);
+        case LV_HASP_LMETER:
+        case HASP_OBJ_LMETER:
+            obj = lv_linemeter_create(parent_obj, NULL);
+            if(obj) {
+                lv_linemeter_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
+                obj->user_data.objid = LV_HASP_LMETER;
+            }
+            break;
 
-                    lv_chart_add_series(obj, LV_COLOR_RED);
-                    lv_chart_add_series(obj, LV_COLOR_GREEN);
-                    lv_chart_add_series(obj, LV_COLOR_BLUE);
+        case LV_HASP_CHART:
+        case HASP_OBJ_CHART:
+            obj = lv_chart_create(parent_obj, NULL);
+            if(obj) {
+                lv_chart_set_range(obj, 0, 100);
+                lv_obj_set_event_cb(obj, generic_event_handler);
 
-                    lv_chart_series_t* ser = my_chart_get_series(obj, 2);
-                    lv_chart_set_next(obj, ser, 10);
-                    lv_chart_set_next(obj, ser, 20);
-                    lv_chart_set_next(obj, ser, 30);
-                    lv_chart_set_next(obj, ser, 40);
+                lv_chart_add_series(obj, LV_COLOR_RED);
+                lv_chart_add_series(obj, LV_COLOR_GREEN);
+                lv_chart_add_series(obj, LV_COLOR_BLUE);
 
-                    obj->user_data.objid = LV_HASP_CHART;
-                }
-                break;
+                lv_chart_series_t* ser = my_chart_get_series(obj, 2);
+                lv_chart_set_next(obj, ser, 10);
+                lv_chart_set_next(obj, ser, 20);
+                lv_chart_set_next(obj, ser, 30);
+                lv_chart_set_next(obj, ser, 40);
 
-            /* ----- On/Off Objects ------ */
-            case LV_HASP_SWITCH:
-            case HASP_OBJ_SWITCH:
-                obj = lv_switch_create(parent_obj, NULL);
-                if(obj) {
-                    lv_obj_set_event_cb(obj, toggle_event_handler);
-                    obj->user_data.objid = LV_HASP_SWITCH;
-                }
-                break;
+                obj->user_data.objid = LV_HASP_CHART;
+            }
+            break;
 
-            /* ----- List Object ------- */
-            case LV_HASP_DROPDOWN:
-            case HASP_OBJ_DROPDOWN:
-                obj = lv_dropdown_create(parent_obj, NULL);
-                if(obj) {
-                    lv_dropdown_set_draw_arrow(obj, true);
-                    // lv_dropdown_set_anim_time(obj, 200);
-                    lv_obj_set_top(obj, true);
-                    // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_DROPDOWN;
-                }
-                break;
+        /* ----- On/Off Objects ------ */
+        case LV_HASP_SWITCH:
+        case HASP_OBJ_SWITCH:
+            obj = lv_switch_create(parent_obj, NULL);
+            if(obj) {
+                lv_obj_set_event_cb(obj, toggle_event_handler);
+                obj->user_data.objid = LV_HASP_SWITCH;
+            }
+            break;
 
-            case LV_HASP_ROLLER:
-            case HASP_OBJ_ROLLER:
-                obj = lv_roller_create(parent_obj, NULL);
+        /* ----- List Object ------- */
+        case LV_HASP_DROPDOWN:
+        case HASP_OBJ_DROPDOWN:
+            obj = lv_dropdown_create(parent_obj, NULL);
+            if(obj) {
+                lv_dropdown_set_draw_arrow(obj, true);
+                // lv_dropdown_set_anim_time(obj, 200);
+                lv_obj_set_top(obj, true);
                 // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
-                if(obj) {
-                    lv_roller_set_auto_fit(obj, false);
-                    lv_obj_set_event_cb(obj, selector_event_handler);
-                    obj->user_data.objid = LV_HASP_ROLLER;
-                }
-                break;
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_DROPDOWN;
+            }
+            break;
 
-                /* ----- Other Object ------ */
-                // default:
-                //    return LOG_WARNING(TAG_HASP, F("Unsupported Object ID %u"), objid);
-        }
+        case LV_HASP_ROLLER:
+        case HASP_OBJ_ROLLER:
+            obj = lv_roller_create(parent_obj, NULL);
+            // lv_obj_align(obj, NULL, LV_ALIGN_IN_TOP_MID, 0, 20);
+            if(obj) {
+                lv_roller_set_auto_fit(obj, false);
+                lv_obj_set_event_cb(obj, selector_event_handler);
+                obj->user_data.objid = LV_HASP_ROLLER;
+            }
+            break;
 
-        /* No object was actually created */
-        if(!obj) {
-            LOG_ERROR(TAG_HASP, F(D_OBJECT_CREATE_FAILED), id);
-            return;
-        }
+            /* ----- Other Object ------ */
+            // default:
+            //    return LOG_WARNING(TAG_HASP, F("Unsupported Object ID %u"), objid);
+    }
 
-        // Prevent losing press when the press is slid out of the objects.
-        // (E.g. a Button can be released out of it if it was being pressed)
-        lv_obj_add_protect(obj, LV_PROTECT_PRESS_LOST);
+    /* No object was actually created */
+    if(!obj) {
+        LOG_ERROR(TAG_HASP, F(D_OBJECT_CREATE_FAILED), id);
+        return NULL;
+    }
 
-        /* id tag the object */
-        // lv_obj_set_user_data(obj, id);
-        obj->user_data.id = id;
-        // obj->user_data.groupid = groupid; // get/set in atttr
+    // Prevent losing press when the press is slid out of the objects.
+    // (E.g. a Button can be released out of it if it was being pressed)
+    lv_obj_add_protect(obj, LV_PROTECT_PRESS_LOST);
+
+    /* id tag the object */
+    // lv_obj_set_user_data(obj, id);
+    obj->user_data.id = id;
+    // obj->user_data.groupid = groupid; // get/set in atttr
+    hasp_object_registry_add(obj);
+
+    /** testing start **/
+    uint8_t temp;
+    if(!hasp_find_id_from_obj(obj, &pageid, &temp)) {
+        LOG_ERROR(TAG_HASP, F(D_OBJECT_LOST));
+        return NULL;
+    }
 
-        /** testing start **/
-        uint8_t temp;
-        if(!hasp_find_id_from_obj(obj, &pageid, &temp)) {
-            LOG_ERROR(TAG_HASP, F(D_OBJECT_LOST));
-            return;
-        }
+    /** verbose reporting **/
+    lv_obj_type_t list;
+    lv_obj_get_type(obj, &list);
+    LOG_VERBOSE(TAG_HASP, F(D_BULLET HASP_OBJECT_NOTATION " = %s"), pageid, temp, list.type[0]);
 
-        /** verbose reporting **/
-        lv_obj_type_t list;
-        lv_obj_get_type(obj, &list);
-        LOG_VERBOSE(TAG_HASP, F(D_BULLET HASP_OBJECT_NOTATION " = %s"), pageid, temp, list.type[0]);
+    /* test double-check */
+    lv_obj_t* test = hasp_find_obj_from_page_id(pageid, (uint8_t)temp);
+    if(test != obj) {
+        LOG_ERROR(TAG_HASP, F(D_OBJECT_MISMATCH));
+        return NULL;
+    }
+    return obj;
+}
 
-        /* test double-check */
-        lv_obj_t* test = hasp_find_obj_from_parent_id(get_page_obj(pageid), (uint8_t)temp);
-        if(test != obj) {
-            LOG_ERROR(TAG_HASP, F(D_OBJECT_MISMATCH));
-            return;
+/**
+ * Create a new object according to the json config
+ * @param config Json representation for this object
+ * @param saved_page_id the pageid to use when no pageid is specified in the Json, updated when it is specified so
+ * following objects in the file can share the pageid
+ */
+void hasp_new_object(const JsonObject& config, uint8_t& saved_page_id)
+{
+    /* Page selection: page is the default parent_obj */
+    uint8_t pageid = config[FPSTR(FP_PAGE)].isNull() ? saved_page_id : config[FPSTR(FP_PAGE)].as<uint8_t>();
+    if(!get_page_obj(pageid)) {
+        LOG_WARNING(TAG_HASP, F(D_OBJECT_PAGE_UNKNOWN), pageid);
+        return;
+    } else {
+        saved_page_id = pageid; /* save the current pageid */
+    }
+
+    uint16_t sdbm    = 0;
+    bool create      = true;
+    uint8_t id       = config[FPSTR(FP_ID)].as<uint8_t>();
+    uint8_t parentid = config[FPSTR(FP_PARENTID)].as<uint8_t>();
+
+    /* Validate type */
+    if(config[FPSTR(FP_OBJID)].isNull()) { // TODO: obsolete objid
+        if(config[FPSTR(FP_OBJ)].isNull()) {
+            create = false;
+        } else {
+            sdbm = Utilities::get_sdbm(config[FPSTR(FP_OBJ)].as<const char*>());
         }
+    } else {
+        sdbm = config[FPSTR(FP_OBJID)].as<uint8_t>();
     }
 
+    lv_obj_t* obj = hasp_find_or_create_object(pageid, parentid, id, create, sdbm);
+    if(!obj) return; // comments or errors
+
     /* do not process these attributes */
     config.remove(FPSTR(FP_PAGE));
     config.remove(FPSTR(FP_ID));
@@ -1043,4 +1264,12 @@ void hasp_object_delete(lv_obj_t* obj)
 
     // TODO: delete value_str data for ALL parts
     my_obj_set_value_str_txt(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, NULL);
+
+#if HASP_USE_MQTT > 0
+    uint8_t pageid, objid;
+    if(hasp_find_id_from_obj(obj, &pageid, &objid)) mqtt_bind_remove(pageid, objid);
+#endif
+
+    hasp_object_registry_remove(obj);
+    hasp_object_group_remove(obj);
 }
\ No newline at end of file
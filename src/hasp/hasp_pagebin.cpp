@@ -0,0 +1,179 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include <stdint.h>
+
+#include "hasplib.h"
+
+#if HASP_USE_DEBUG > 0
+#include "../hasp_debug.h"
+#endif
+
+static inline uint16_t pagebin_u16(const uint8_t* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+static inline int32_t pagebin_i32(const uint8_t* data)
+{
+    return (int32_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) |
+                     ((uint32_t)data[3] << 24));
+}
+
+#ifdef ARDUINO
+static inline bool pagebin_read(Stream& stream, uint8_t* buffer, size_t len)
+{
+    return stream.readBytes((char*)buffer, len) == len;
+}
+#else
+static inline bool pagebin_read(std::istream& stream, uint8_t* buffer, size_t len)
+{
+    stream.read((char*)buffer, len);
+    return (size_t)stream.gcount() == len;
+}
+#endif
+
+/**
+ * Create or update one object from a compiled record
+ * @param record the record data following the size field
+ * @param size the number of bytes in the record
+ * @param saved_page_id the page of the previous record, updated when the record selects a page
+ * @return false if the record is malformed
+ */
+static bool pagebin_process_record(const uint8_t* record, size_t size, uint8_t& saved_page_id)
+{
+    if(size < HASP_PAGEBIN_RECORD_SIZE) return false;
+
+    uint8_t pageid = (record[0] & HASP_PAGEBIN_FLAG_PAGE) ? record[1] : saved_page_id;
+    if(!get_page_obj(pageid)) {
+        LOG_WARNING(TAG_HASP, F(D_OBJECT_PAGE_UNKNOWN), pageid);
+        return true;
+    } else {
+        saved_page_id = pageid; /* save the current pageid */
+    }
+
+    bool create   = (record[0] & HASP_PAGEBIN_FLAG_OBJ) || pagebin_u16(record + 4);
+    lv_obj_t* obj = hasp_find_or_create_object(pageid, record[3], record[2], create, pagebin_u16(record + 4));
+    if(!obj) return true; // errors are logged by the object creator
+
+    uint8_t count      = record[6];
+    const uint8_t* pos = record + HASP_PAGEBIN_RECORD_SIZE;
+    const uint8_t* end = record + size;
+
+    while(count--) {
+        if(end - pos < HASP_PAGEBIN_ATTR_SIZE) return false;
+
+        uint16_t hash         = pagebin_u16(pos);
+        uint16_t hash_noindex = pagebin_u16(pos + 2);
+        uint8_t type          = pos[4];
+        uint8_t name_len      = pos[5];
+        uint16_t value_len    = pagebin_u16(pos + 6);
+        pos += HASP_PAGEBIN_ATTR_SIZE;
+
+        if(name_len == 0 || end - pos < name_len + value_len) return false;
+        const char* name = (const char*)pos;
+        if(name[name_len - 1] != '\0') return false;
+        pos += name_len;
+
+        /* Numbers and colors are applied as is, without formatting and parsing them again */
+        switch(type) {
+            case HASP_PAGEBIN_VALUE_STRING:
+                if(value_len == 0 || pos[value_len - 1] != '\0') return false;
+                LOG_VERBOSE(TAG_HASP, F(D_BULLET "%s=%s"), name, (const char*)pos);
+                hasp_process_obj_attribute_hash(obj, name, hash, hash_noindex, (const char*)pos, true);
+                break;
+
+            case HASP_PAGEBIN_VALUE_INT32:
+                if(value_len != 4) return false;
+                LOG_VERBOSE(TAG_HASP, F(D_BULLET "%s=%d"), name, pagebin_i32(pos));
+                hasp_process_obj_attribute_int(obj, name, hash, hash_noindex, pagebin_i32(pos));
+                break;
+
+            case HASP_PAGEBIN_VALUE_COLOR:
+                if(value_len != 3) return false;
+                LOG_VERBOSE(TAG_HASP, F(D_BULLET "%s=#%02x%02x%02x"), name, pos[0], pos[1], pos[2]);
+                hasp_process_obj_attribute_color(obj, name, hash, hash_noindex, lv_color_make(pos[0], pos[1], pos[2]));
+                break;
+
+            default:
+                return false;
+        }
+        pos += value_len;
+    }
+
+    return true;
+}
+
+/**
+ * Load the objects of a compiled pages file
+ * @param stream the compiled pages file
+ * @return false if the stream is not a compiled pages file of a supported version or no memory is available
+ */
+#ifdef ARDUINO
+bool hasp_pagebin_load(Stream& stream)
+#else
+bool hasp_pagebin_load(std::istream& stream)
+#endif
+{
+    uint8_t header[HASP_PAGEBIN_HEADER_SIZE];
+    if(!pagebin_read(stream, header, sizeof(header)) || memcmp(header, HASP_PAGEBIN_MAGIC, 4) ||
+       header[4] != HASP_PAGEBIN_VERSION) {
+        LOG_WARNING(TAG_HASP, F("Invalid compiled pages file"));
+        return false;
+    }
+
+#ifdef ARDUINO
+    stream.setTimeout(25);
+#endif
+
+    uint8_t savedPage = haspGetPage();
+    size_t bufsize    = HASP_JSONL_CHUNK_SIZE;
+    uint8_t* buffer   = (uint8_t*)malloc(bufsize);
+    size_t records    = 0;
+    size_t errors     = 0;
+    uint8_t size[2];
+
+    if(!buffer) {
+        LOG_ERROR(TAG_HASP, F(D_ERROR_OUT_OF_MEMORY));
+        return false; // nothing was created, let the jsonl file load instead
+    }
+
+    while(pagebin_read(stream, size, sizeof(size))) {
+        size_t len = pagebin_u16(size);
+        records++;
+
+        if(len > bufsize) {
+            size_t newsize = bufsize;
+            while(newsize < len) newsize *= 2;
+
+            uint8_t* grown = newsize <= HASP_JSONL_MAX_LINE ? (uint8_t*)realloc(buffer, newsize) : NULL;
+            if(!grown) {
+                LOG_ERROR(TAG_HASP, F("Record %u is too large, %u bytes"), (uint32_t)records, (uint32_t)len);
+                errors++;
+                break; // the record can not be skipped without reading it
+            }
+            buffer  = grown;
+            bufsize = newsize;
+        }
+
+        if(!pagebin_read(stream, buffer, len)) {
+            LOG_ERROR(TAG_HASP, F("Record %u is truncated"), (uint32_t)records);
+            errors++;
+            break;
+        }
+
+        if(!pagebin_process_record(buffer, len, savedPage)) {
+            LOG_ERROR(TAG_HASP, F("Record %u is malformed"), (uint32_t)records);
+            errors++;
+        }
+    }
+
+    free(buffer);
+
+    if(errors) {
+        LOG_ERROR(TAG_HASP, F("Compiled pages loaded with %u invalid records"), (uint32_t)errors);
+    } else {
+        LOG_INFO(TAG_HASP, F("Compiled pages loaded, %u records"), (uint32_t)records);
+    }
+    return true;
+}
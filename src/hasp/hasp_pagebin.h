@@ -0,0 +1,50 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_PAGEBIN_H
+#define HASP_PAGEBIN_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#else
+#include <istream>
+#endif
+
+/* Compiled pages file, generated from a pages.jsonl by tools/jsonl2bin.py
+ * All integers are little-endian
+ *
+ *  header : "HSPB", u8 version, u8 flags, u16 reserved
+ *  record : u16 size, u8 flags, u8 pageid, u8 id, u8 parentid, u16 objtype, u8 attr_count
+ *  attr   : u16 hash, u16 hash_noindex, u8 type, u8 name_len, u16 value_len, char name[name_len], value[value_len]
+ *
+ * The record size counts the bytes following the size field.
+ * The objtype is the sdbm hash of the obj name or the numeric objid. Without HASP_PAGEBIN_FLAG_OBJ an objtype of 0
+ * only updates an existing object.
+ * The attribute name is null terminated and name_len includes the terminator.
+ */
+#define HASP_PAGEBIN_MAGIC "HSPB"
+#define HASP_PAGEBIN_VERSION 1
+#define HASP_PAGEBIN_HEADER_SIZE 8
+#define HASP_PAGEBIN_RECORD_SIZE 7
+#define HASP_PAGEBIN_ATTR_SIZE 8
+
+enum hasp_pagebin_record_flag_t : uint8_t {
+    HASP_PAGEBIN_FLAG_PAGE = 0x01, // the record selects a page, otherwise the page of the previous record is used
+    HASP_PAGEBIN_FLAG_OBJ  = 0x02, // the record has an obj or objid, creating an object of an unknown type fails
+};
+
+enum hasp_pagebin_value_t : uint8_t {
+    HASP_PAGEBIN_VALUE_STRING = 0, // null terminated text
+    HASP_PAGEBIN_VALUE_INT32  = 1, // int32_t
+    HASP_PAGEBIN_VALUE_COLOR  = 2, // decoded color as r, g, b bytes
+};
+
+#ifdef ARDUINO
+bool hasp_pagebin_load(Stream& stream);
+#else
+bool hasp_pagebin_load(std::istream& stream);
+#endif
+
+#endif
@@ -0,0 +1,378 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Local rules engine
+ * The rules file is compiled into a table of triggers and a pool of action strings. Triggers are packed
+ * into a 32-bit key of source, page, object and event and indexed in an open addressing hash table, so an
+ * event handler only pays for one hash lookup. Rules with the same trigger are chained in file order.
+ * Matched rules are queued and their actions run from the main loop, so an action can safely delete or
+ * change the object whose event triggered it. */
+
+#include <stdint.h>
+
+#include "hasplib.h"
+
+#if HASP_USE_DEBUG > 0
+#include "../hasp_debug.h"
+#endif
+
+#ifndef ARDUINO
+#include <string>
+#endif
+
+#define RULES_NONE 0xFFFF
+#define RULES_SOURCE_OBJECT 0
+#define RULES_SOURCE_GPIO 1
+
+struct hasp_rule_t
+{
+    uint32_t key;     // source << 24 | pageid << 16 | objid << 8 | eventid
+    uint16_t actions; // offset in the pool, the actions are null terminated and end with an empty string
+    uint16_t next;    // next rule with the same key
+};
+
+struct hasp_rules_queued_t
+{
+    uint16_t rule;
+    int32_t val;
+};
+
+static hasp_rule_t* rules_table;
+static uint16_t rules_count;
+static char* rules_pool;
+static size_t rules_pool_len;
+static uint16_t* rules_index; // hash table of the first rule for each key
+static uint16_t rules_index_mask;
+
+static hasp_rules_queued_t rules_queue[HASP_RULES_QUEUE];
+static uint8_t rules_queue_head  = 0;
+static uint8_t rules_queue_count = 0;
+static bool rules_running        = false;
+
+static inline uint32_t rules_key(uint8_t source, uint8_t pageid, uint8_t objid, uint8_t eventid)
+{
+    return (uint32_t)source << 24 | (uint32_t)pageid << 16 | (uint32_t)objid << 8 | eventid;
+}
+
+static inline uint16_t rules_hash(uint32_t key)
+{
+    return (key * 2654435761u) >> 16; // Knuth multiplicative hash
+}
+
+static int16_t rules_event_id(const char* name)
+{
+    if(!strcasecmp_P(name, PSTR("up"))) return HASP_EVENT_UP;
+    if(!strcasecmp_P(name, PSTR("down"))) return HASP_EVENT_DOWN;
+    if(!strcasecmp_P(name, PSTR("short"))) return HASP_EVENT_SHORT;
+    if(!strcasecmp_P(name, PSTR("long"))) return HASP_EVENT_LONG;
+    if(!strcasecmp_P(name, PSTR("hold"))) return HASP_EVENT_HOLD;
+    if(!strcasecmp_P(name, PSTR("lost"))) return HASP_EVENT_LOST;
+    if(!strcasecmp_P(name, PSTR("on"))) return HASP_EVENT_ON;
+    if(!strcasecmp_P(name, PSTR("off"))) return HASP_EVENT_OFF;
+    if(!strcasecmp_P(name, PSTR("changed"))) return HASP_RULES_EVENT_CHANGED;
+    return -1;
+}
+
+/**
+ * Parse a trigger like p1b2.up or gpio12.long
+ * @param trigger the trigger text
+ * @param key receives the packed trigger
+ * @return false if the trigger is invalid
+ */
+static bool rules_parse_trigger(const char* trigger, uint32_t* key)
+{
+    char buffer[24];
+    strncpy(buffer, trigger, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    char* event = strchr(buffer, '.');
+    if(!event) return false;
+    *event++ = '\0';
+
+    int16_t eventid = rules_event_id(event);
+    if(eventid < 0) return false;
+
+    char* end;
+    if(!strncasecmp(buffer, "gpio", 4)) {
+        unsigned long pin = strtoul(buffer + 4, &end, 10);
+        if(end == buffer + 4 || *end || pin > 255) return false;
+        *key = rules_key(RULES_SOURCE_GPIO, 0, pin, eventid);
+        return true;
+    }
+
+    if(buffer[0] != 'p' && buffer[0] != 'P') return false;
+    unsigned long pageid = strtoul(buffer + 1, &end, 10);
+    if(end == buffer + 1 || (*end != 'b' && *end != 'B') || pageid > 255) return false;
+
+    const char* id      = end + 1;
+    unsigned long objid = strtoul(id, &end, 10);
+    if(end == id || *end || objid > 255) return false;
+
+    *key = rules_key(RULES_SOURCE_OBJECT, pageid, objid, eventid);
+    return true;
+}
+
+static bool rules_pool_add(const char* text, size_t len)
+{
+    char* pool = (char*)realloc(rules_pool, rules_pool_len + len + 1);
+    if(!pool) return false;
+
+    rules_pool = pool;
+    memcpy(rules_pool + rules_pool_len, text, len);
+    rules_pool[rules_pool_len + len] = '\0';
+    rules_pool_len += len + 1;
+    return true;
+}
+
+// Add the actions of one rule to the pool, returns false if there is nothing to run
+static bool rules_add_actions(JsonVariant actions)
+{
+    size_t start = rules_pool_len;
+
+    if(actions.is<const char*>()) {
+        const char* action = actions.as<const char*>();
+        if(*action && !rules_pool_add(action, strlen(action))) return false;
+    } else if(actions.is<JsonArray>()) {
+        for(JsonVariant item : actions.as<JsonArray>()) {
+            const char* action = item.as<const char*>();
+            if(action && *action && !rules_pool_add(action, strlen(action))) return false;
+        }
+    }
+
+    if(rules_pool_len == start || rules_pool_len > UINT16_MAX) return false;
+    return rules_pool_add("", 0);
+}
+
+// Compile one json line into the rules table, returns false if the line is not a valid rule
+static bool rules_compile_line(DynamicJsonDocument& doc, const char* line, size_t len)
+{
+    DeserializationError jsonError = deserializeJson(doc, line, len);
+    if(jsonError) return false;
+
+    uint32_t key;
+    const char* trigger = doc[F("on")].as<const char*>();
+    if(!trigger || !rules_parse_trigger(trigger, &key)) return false;
+
+    hasp_rule_t* table = (hasp_rule_t*)realloc(rules_table, (rules_count + 1) * sizeof(hasp_rule_t));
+    if(!table) return false;
+    rules_table = table;
+
+    size_t actions = rules_pool_len;
+    if(!rules_add_actions(doc[F("do")])) {
+        rules_pool_len = actions; // drop the partial actions
+        return false;
+    }
+
+    rules_table[rules_count].key     = key;
+    rules_table[rules_count].actions = actions;
+    rules_table[rules_count].next    = RULES_NONE;
+    rules_count++;
+    return true;
+}
+
+static uint16_t rules_find(uint32_t key)
+{
+    if(!rules_index) return RULES_NONE;
+
+    for(uint16_t slot = rules_hash(key) & rules_index_mask;; slot = (slot + 1) & rules_index_mask) {
+        uint16_t rule = rules_index[slot];
+        if(rule == RULES_NONE || rules_table[rule].key == key) return rule;
+    }
+}
+
+// Build the hash table, at most half full so a lookup ends after a few probes
+static bool rules_build_index()
+{
+    uint32_t size = 8;
+    while(size < rules_count * 2u) size <<= 1;
+
+    rules_index = (uint16_t*)malloc(size * sizeof(uint16_t));
+    if(!rules_index) return false;
+    memset(rules_index, 0xFF, size * sizeof(uint16_t));
+    rules_index_mask = size - 1;
+
+    for(uint16_t i = 0; i < rules_count; i++) {
+        uint16_t slot = rules_hash(rules_table[i].key) & rules_index_mask;
+        while(rules_index[slot] != RULES_NONE && rules_table[rules_index[slot]].key != rules_table[i].key) {
+            slot = (slot + 1) & rules_index_mask;
+        }
+
+        if(rules_index[slot] == RULES_NONE) {
+            rules_index[slot] = i;
+        } else { // same trigger, append to the chain to keep the file order
+            uint16_t last = rules_index[slot];
+            while(rules_table[last].next != RULES_NONE) last = rules_table[last].next;
+            rules_table[last].next = i;
+        }
+    }
+    return true;
+}
+
+static void rules_trigger(uint32_t key, int32_t val)
+{
+    if(rules_count == 0 || rules_running) return; // actions do not trigger other rules
+
+    uint16_t rule = rules_find(key);
+    if(rule == RULES_NONE) return;
+
+    // A slider sends many changes per loop, only its latest value matters
+    if(rules_queue_count > 0 && (key & 0xFF) == HASP_RULES_EVENT_CHANGED) {
+        hasp_rules_queued_t* last = &rules_queue[(rules_queue_head + rules_queue_count - 1) % HASP_RULES_QUEUE];
+        if(last->rule == rule) {
+            last->val = val;
+            return;
+        }
+    }
+
+    if(rules_queue_count >= HASP_RULES_QUEUE) {
+        LOG_WARNING(TAG_HASP, F("Rules: queue full, event dropped"));
+        return;
+    }
+
+    hasp_rules_queued_t* queued = &rules_queue[(rules_queue_head + rules_queue_count) % HASP_RULES_QUEUE];
+    queued->rule                = rule;
+    queued->val                 = val;
+    rules_queue_count++;
+}
+
+// Run one action, every %val% is replaced by the value of the event
+static void rules_execute(const char* action, int32_t val)
+{
+    const char* var = strstr_P(action, PSTR("%val%"));
+    if(!var) {
+        dispatch_text_line(action);
+        return;
+    }
+
+    char command[128];
+    size_t len = 0;
+    while(var && len < sizeof(command)) {
+        len += snprintf_P(command + len, sizeof(command) - len, PSTR("%.*s%d"), (int)(var - action), action, val);
+        action = var + 5;
+        var    = strstr_P(action, PSTR("%val%"));
+    }
+    if(len < sizeof(command)) snprintf_P(command + len, sizeof(command) - len, PSTR("%s"), action);
+
+    dispatch_text_line(command);
+}
+
+/* ===== Default Event Processors ===== */
+
+void hasp_rules_loop()
+{
+    while(rules_queue_count > 0) {
+        hasp_rules_queued_t queued = rules_queue[rules_queue_head];
+        rules_queue_head           = (rules_queue_head + 1) % HASP_RULES_QUEUE;
+        rules_queue_count--;
+
+        rules_running = true;
+        for(uint16_t rule = queued.rule; rule != RULES_NONE; rule = rules_table[rule].next) {
+            for(const char* action = rules_pool + rules_table[rule].actions; *action;
+                action += strlen(action) + 1) {
+                LOG_VERBOSE(TAG_HASP, F("Rules: %s"), action);
+                rules_execute(action, queued.val);
+            }
+        }
+        rules_running = false;
+    }
+}
+
+/* ===== Special Event Processors ===== */
+
+void hasp_rules_clear()
+{
+    free(rules_table);
+    free(rules_pool);
+    free(rules_index);
+    rules_table       = NULL;
+    rules_pool        = NULL;
+    rules_index       = NULL;
+    rules_count       = 0;
+    rules_pool_len    = 0;
+    rules_queue_count = 0;
+}
+
+/**
+ * Replace the rules with the ones in a jsonl stream
+ * @param stream one rule per line
+ * @return number of rules loaded
+ */
+#ifdef ARDUINO
+uint16_t hasp_rules_load(Stream& stream)
+#else
+uint16_t hasp_rules_load(std::istream& stream)
+#endif
+{
+    if(rules_running) { // an action cannot replace the rule it belongs to
+        LOG_WARNING(TAG_HASP, F("Rules: cannot reload from a rule"));
+        return rules_count;
+    }
+    hasp_rules_clear();
+
+    DynamicJsonDocument doc(512);
+    uint16_t lineno = 0;
+
+#ifdef ARDUINO
+    while(stream.available()) {
+        String line = stream.readStringUntil('\n');
+        const char* text = line.c_str();
+        size_t len       = line.length();
+#else
+    std::string line;
+    while(std::getline(stream, line)) {
+        const char* text = line.c_str();
+        size_t len       = line.length();
+#endif
+        lineno++;
+
+        while(len > 0 && isspace(text[len - 1])) len--;
+        if(len == 0) continue;
+
+        if(rules_count == RULES_NONE - 1 || !rules_compile_line(doc, text, len)) {
+            LOG_WARNING(TAG_HASP, F("Rules: invalid rule at line %u"), lineno);
+        }
+    }
+
+    if(rules_count > 0 && !rules_build_index()) {
+        LOG_ERROR(TAG_HASP, F(D_ERROR_OUT_OF_MEMORY));
+        hasp_rules_clear();
+    }
+
+    LOG_INFO(TAG_HASP, F("Rules: %u loaded, %u bytes of actions"), rules_count, (uint32_t)rules_pool_len);
+    return rules_count;
+}
+
+// Load the rules file, a missing file clears the rules
+uint16_t hasp_rules_load_file(const char* filename)
+{
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+    if(!filesystemSetup() || !HASP_FS.exists(filename)) {
+        hasp_rules_clear();
+        return 0;
+    }
+
+    File file      = HASP_FS.open(filename, "r");
+    uint16_t count = hasp_rules_load(file);
+    file.close();
+    return count;
+#else
+    return rules_count;
+#endif
+}
+
+void hasp_rules_object_event(uint8_t pageid, uint8_t objid, uint8_t eventid, int32_t val)
+{
+    rules_trigger(rules_key(RULES_SOURCE_OBJECT, pageid, objid, eventid), val);
+}
+
+void hasp_rules_gpio_event(uint8_t pin, uint8_t eventid)
+{
+    rules_trigger(rules_key(RULES_SOURCE_GPIO, 0, pin, eventid), dispatch_get_event_state(eventid));
+}
+
+/* ===== Getter and Setter Functions ===== */
+
+uint16_t hasp_rules_count()
+{
+    return rules_count;
+}
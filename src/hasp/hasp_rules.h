@@ -0,0 +1,52 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_RULES_H
+#define HASP_RULES_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include "Arduino.h"
+#else
+#include <istream>
+#endif
+
+/* Local rules, loaded from a jsonl file with one rule per line
+ *
+ *  {"on":"p1b2.up","do":"page 2"}
+ *  {"on":"p1b3.changed","do":["p2b4.val=%val%","p2b5.text=%val%"]}
+ *  {"on":"gpio12.long","do":"light off"}
+ *
+ * The trigger is an object or gpio input and one of the events up, down, short, long, hold, lost, on, off
+ * or changed. The actions are dispatcher commands, %val% is replaced by the new value of a changed event.
+ * Events are published as usual, the actions run from the main loop right after the event.
+ */
+#ifndef HASP_RULES_FILE
+#define HASP_RULES_FILE "/rules.jsonl"
+#endif
+
+#ifndef HASP_RULES_QUEUE
+#define HASP_RULES_QUEUE 8 // triggered rules waiting for the main loop
+#endif
+
+#define HASP_RULES_EVENT_CHANGED 0x10 // pseudo event for value changes
+
+/* ===== Default Event Processors ===== */
+void hasp_rules_loop(void);
+
+/* ===== Special Event Processors ===== */
+#ifdef ARDUINO
+uint16_t hasp_rules_load(Stream& stream);
+#else
+uint16_t hasp_rules_load(std::istream& stream);
+#endif
+uint16_t hasp_rules_load_file(const char* filename);
+void hasp_rules_clear(void);
+void hasp_rules_object_event(uint8_t pageid, uint8_t objid, uint8_t eventid, int32_t val);
+void hasp_rules_gpio_event(uint8_t pin, uint8_t eventid);
+
+/* ===== Getter and Setter Functions ===== */
+uint16_t hasp_rules_count(void);
+
+#endif
@@ -94,4 +94,33 @@ long map(long x, long in_min, long in_max, long out_min, long out_max)
 {
     return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
+#endif
+
+#if defined(POSIX)
+/* Not part of glibc, mingw and the Arduino cores provide it */
+char* itoa(int value, char* result, int base)
+{
+    if(base < 2 || base > 36) {
+        *result = '\0';
+        return result;
+    }
+
+    char* ptr      = result;
+    unsigned int n = value < 0 && base == 10 ? -(unsigned int)value : (unsigned int)value;
+    do {
+        *ptr++ = "0123456789abcdefghijklmnopqrstuvwxyz"[n % base];
+        n /= base;
+    } while(n);
+    if(value < 0 && base == 10) *ptr++ = '-';
+    *ptr-- = '\0';
+
+    /* Reverse the digits */
+    char* start = result;
+    while(start < ptr) {
+        char tmp = *ptr;
+        *ptr--   = *start;
+        *start++ = tmp;
+    }
+    return result;
+}
 #endif
\ No newline at end of file
@@ -10,6 +10,13 @@ class Utilities {
 
   public:
     static uint16_t get_sdbm(const char* str);
+    static constexpr uint16_t get_sdbm_const(const char* str, uint16_t hash = 0)
+    {
+        /* Compile-time equivalent of get_sdbm, for hashing string literals */
+        return *str ? get_sdbm_const(str + 1, (uint16_t)((*str >= 'A' && *str <= 'Z' ? *str + ('a' - 'A') : *str) +
+                                                         (hash << 6) - hash))
+                    : hash;
+    }
     static bool is_true(const char* s);
     static bool is_only_digits(const char* s);
     static int format_bytes(size_t filesize, char* buf, size_t len);
@@ -20,4 +27,8 @@ class Utilities {
 long map(long x, long in_min, long in_max, long out_min, long out_max);
 #endif
 
+#if defined(POSIX)
+char* itoa(int value, char* result, int base);
+#endif
+
 #endif
\ No newline at end of file
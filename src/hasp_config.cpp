@@ -26,7 +26,6 @@
 #endif
 
 extern uint16_t dispatchTelePeriod;
-extern uint32_t dispatchLastMillis;
 
 extern gui_conf_t gui_settings;
 extern dispatch_conf_t dispatch_settings;
@@ -57,6 +57,8 @@ const char FP_GUI_IDLEPERIOD2[] PROGMEM  = "idle2";
 const char FP_GUI_CALIBRATION[] PROGMEM  = "calibration";
 const char FP_GUI_BACKLIGHTPIN[] PROGMEM = "bckl";
 const char FP_GUI_POINTER[] PROGMEM      = "cursor";
+const char FP_GUI_VDBSIZE[] PROGMEM      = "vdbsize";
+const char FP_GUI_DOUBLEBUF[] PROGMEM    = "dblbuf";
 const char FP_DEBUG_TELEPERIOD[] PROGMEM = "tele";
 const char FP_GPIO_CONFIG[] PROGMEM      = "config";
 
@@ -10,7 +10,7 @@
 
 #include "lang/lang.h"
 
-#ifndef WINDOWS
+#if !defined(WINDOWS) && !defined(POSIX)
 #include "ArduinoLog.h"
 
 /* ===== Default Event Processors ===== */
@@ -30,38 +30,28 @@ void debugStopSyslog(void);
 #else
 #include <iostream>
 
-#define LOG_FATAL(x, ...)                                                                                              \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_ERROR(x, ...)                                                                                              \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_WARNING(x, ...)                                                                                            \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_NOTICE(x, ...)                                                                                             \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_TRACE(x, ...)                                                                                              \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_VERBOSE(x, ...)                                                                                            \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_DEBUG(x, ...)                                                                                              \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
-#define LOG_INFO(x, ...)                                                                                               \
-    printf(__VA_ARGS__);                                                                                               \
-    std::cout << std::endl;                                                                                            \
-    fflush(stdout)
+#ifndef HASP_LOG_LEVEL
+#define HASP_LOG_LEVEL 9
+#endif
+
+/* Host builds log to the console, messages above HASP_LOG_LEVEL are skipped like on the devices */
+#define LOG_HOST(level, ...)                                                                                           \
+    do {                                                                                                               \
+        if(HASP_LOG_LEVEL > level) {                                                                                   \
+            printf(__VA_ARGS__);                                                                                       \
+            std::cout << std::endl;                                                                                    \
+            fflush(stdout);                                                                                            \
+        }                                                                                                              \
+    } while(0)
+
+#define LOG_FATAL(x, ...) LOG_HOST(0, __VA_ARGS__)
+#define LOG_ERROR(x, ...) LOG_HOST(3, __VA_ARGS__)
+#define LOG_WARNING(x, ...) LOG_HOST(4, __VA_ARGS__)
+#define LOG_NOTICE(x, ...) LOG_HOST(5, __VA_ARGS__)
+#define LOG_INFO(x, ...) LOG_HOST(5, __VA_ARGS__)
+#define LOG_TRACE(x, ...) LOG_HOST(6, __VA_ARGS__)
+#define LOG_VERBOSE(x, ...) LOG_HOST(7, __VA_ARGS__)
+#define LOG_DEBUG(x, ...) LOG_HOST(8, __VA_ARGS__)
 
 /* json keys used in the configfile */
 // const char FP_CONFIG_STARTPAGE[] PROGMEM = "startpage";
@@ -22,6 +22,7 @@
 #include "hasp_config.h"
 #include "hasp_gui.h"
 #include "hasp_oobe.h"
+#include "hasp_screenshot.h"
 
 #include "hasplib.h"
 
@@ -55,6 +56,18 @@ File pFileOut;
 #ifndef INVERT_COLORS
 #define INVERT_COLORS 0
 #endif
+#ifndef GUI_VDB_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define GUI_VDB_SIZE 32 // KB per draw buffer
+#elif defined(ARDUINO_ARCH_ESP8266)
+#define GUI_VDB_SIZE 2 // KB per draw buffer
+#else
+#define GUI_VDB_SIZE 16 // KB per draw buffer
+#endif
+#endif
+#ifndef GUI_DOUBLE_BUFFER
+#define GUI_DOUBLE_BUFFER 0
+#endif
 
 // static void IRAM_ATTR lv_tick_handler(void);
 
@@ -62,7 +75,15 @@ gui_conf_t gui_settings = {.show_pointer   = false,
                            .backlight_pin  = TFT_BCKL,
                            .rotation       = TFT_ROTATION,
                            .invert_display = INVERT_COLORS,
-                           .cal_data       = {0, 65535, 0, 65535, 0}};
+                           .cal_data       = {0, 65535, 0, 65535, 0},
+                           .vdb_size       = GUI_VDB_SIZE,
+                           .double_buffer  = GUI_DOUBLE_BUFFER};
+
+static uint8_t gui_refresh_paused = 0;  // nesting level of guiPauseRefresh
+static uint8_t gui_refresh_prio;        // priority of the refresh task before it was paused
+static bool gui_refresh_held;           // guiHoldRefresh paused the refresh
+static uint32_t gui_refresh_hold_start; // millis of the first update of the burst
+static uint32_t gui_refresh_hold_last;  // millis of the latest update of the burst
 
 // static int8_t guiDimLevel = 100;
 // bool guiBacklightIsOn;
@@ -85,6 +106,32 @@ void gui_flush_cb(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_
     haspTft.flush_pixels(disp, area, color_p);
 }
 
+/* Called by lvgl while it waits for a flush to complete */
+static void gui_wait_cb(lv_disp_drv_t* disp)
+{
+    haspTft.flush_poll();
+}
+
+#if TOUCH_DRIVER == 2046
+/* The touch controller shares the SPI bus with the display */
+static bool gui_touch_read(lv_indev_drv_t* indev_driver, lv_indev_data_t* data)
+{
+    haspTft.flush_sync();
+    return drv_touch_read(indev_driver, data);
+}
+#endif
+
+/* Allocate a draw buffer, in DMA capable memory if the display driver pushes the pixels with DMA */
+static lv_color_t* gui_alloc_vdb(size_t size)
+{
+#if defined(ARDUINO_ARCH_ESP32) && defined(USE_DMA_TO_TFT)
+    return (lv_color_t*)heap_caps_calloc(size, sizeof(lv_color_t), MALLOC_CAP_DMA);
+#else
+    // psram is too slow for the VDB
+    return (lv_color_t*)calloc(size, sizeof(lv_color_t));
+#endif
+}
+
 void guiCalibrate(void)
 {
 #if TOUCH_DRIVER == 2046 && USE_TFT_ESPI > 0
@@ -117,56 +164,49 @@ void guiSetup(void)
     haspTft.show_info();
 
     /* Create the Virtual Device Buffers */
-#if defined(ARDUINO_ARCH_ESP32)
-
-#ifdef USE_DMA_TO_TFT
-    static lv_color_t *guiVdbBuffer1, *guiVdbBuffer2 = NULL;
-    // DMA: len must be less than 32767
-    const size_t guiVDBsize = 15 * 1024u; // 30 KBytes
-    guiVdbBuffer1           = (lv_color_t*)heap_caps_calloc(guiVDBsize, sizeof(lv_color_t), MALLOC_CAP_DMA);
-    // guiVdbBuffer2 = (lv_color_t *)heap_caps_malloc(sizeof(lv_color_t) * guiVDBsize,   MALLOC_CAP_DMA);
-    // lv_disp_buf_init(&disp_buf, guiVdbBuffer1, guiVdbBuffer2, guiVDBsize);
-#else
-    static lv_color_t* guiVdbBuffer1;
-    const size_t guiVDBsize = 16 * 1024u; // 32 KBytes
-
-    if(0 && psramFound()) {
-        guiVdbBuffer1 = (lv_color_t*)ps_calloc(guiVDBsize, sizeof(lv_color_t)); // too slow for VDB
-    } else {
-        guiVdbBuffer1 = (lv_color_t*)calloc(guiVDBsize, sizeof(lv_color_t));
+    const size_t screen_size = TFT_WIDTH * TFT_HEIGHT;
+    size_t guiVDBsize        = gui_settings.vdb_size * 1024u / sizeof(lv_color_t);
+
+    if(gui_settings.double_buffer) {
+        // two full screen buffers would switch lvgl to true double buffering, which copies back from the flushed buffer
+        if(guiVDBsize > screen_size / 2) guiVDBsize = screen_size / 2;
+    } else if(guiVDBsize > screen_size) {
+        guiVDBsize = screen_size;
     }
-
+    const size_t line_size = LV_MATH_MAX(TFT_WIDTH, TFT_HEIGHT);
+    if(guiVDBsize < line_size) guiVDBsize = line_size; // one line
+#ifdef USE_DMA_TO_TFT
+    if(guiVDBsize > 32767) guiVDBsize = 32767; // DMA: len must be less than 32767
 #endif
 
-    // static lv_color_t * guiVdbBuffer2 = (lv_color_t *)malloc(sizeof(lv_color_t) * guiVDBsize);
-    // lv_disp_buf_init(&disp_buf, guiVdbBuffer1, guiVdbBuffer2, guiVDBsize);
-
-#elif defined(ARDUINO_ARCH_ESP8266)
-    /* allocate on heap */
-    // static lv_color_t guiVdbBuffer1[2 * 512u]; // 4 KBytes
-    // size_t guiVDBsize = sizeof(guiVdbBuffer1) / sizeof(guiVdbBuffer1[0]);
-    // lv_disp_buf_init(&disp_buf, guiVdbBuffer1, NULL, guiVDBsize);
-
-    static lv_color_t* guiVdbBuffer1;
-    const size_t guiVDBsize = 2 * 512u; // 4 KBytes * 2
-    guiVdbBuffer1           = (lv_color_t*)malloc(sizeof(lv_color_t) * guiVDBsize);
+    lv_color_t* guiVdbBuffer1 = gui_alloc_vdb(guiVDBsize);
+    lv_color_t* guiVdbBuffer2 = NULL;
 
-#elif defined(WINDOWS)
-    const size_t guiVDBsize = LV_HOR_RES_MAX * 10;
-    static lv_color_t guiVdbBuffer1[guiVDBsize]; /*Declare a buffer for 10 lines*/
+    /* The configured size may not fit, fall back to the default size and then to a single line */
+    size_t fallback = GUI_VDB_SIZE * 1024u / sizeof(lv_color_t);
+    if(!guiVdbBuffer1 && fallback < guiVDBsize && fallback > line_size) {
+        LOG_WARNING(TAG_GUI, F("Draw buffer of %u bytes: " D_ERROR_OUT_OF_MEMORY),
+                    (uint32_t)(guiVDBsize * sizeof(lv_color_t)));
+        guiVDBsize    = fallback;
+        guiVdbBuffer1 = gui_alloc_vdb(guiVDBsize);
+    }
+    if(!guiVdbBuffer1 && guiVDBsize > line_size) {
+        LOG_WARNING(TAG_GUI, F("Draw buffer of %u bytes: " D_ERROR_OUT_OF_MEMORY),
+                    (uint32_t)(guiVDBsize * sizeof(lv_color_t)));
+        guiVDBsize    = line_size;
+        guiVdbBuffer1 = gui_alloc_vdb(guiVDBsize);
+    }
 
-#else
-    static lv_color_t guiVdbBuffer1[16 * 512u]; // 16 KBytes
-    // static lv_color_t guiVdbBuffer2[16 * 512u]; // 16 KBytes
-    size_t guiVDBsize = sizeof(guiVdbBuffer1) / sizeof(guiVdbBuffer1[0]);
-    // lv_disp_buf_init(&disp_buf, guiVdbBuffer1, guiVdbBuffer2, guiVDBsize);
-#endif
+    if(guiVdbBuffer1 && gui_settings.double_buffer) {
+        guiVdbBuffer2 = gui_alloc_vdb(guiVDBsize);
+        if(!guiVdbBuffer2) LOG_WARNING(TAG_GUI, F("Double buffering disabled: " D_ERROR_OUT_OF_MEMORY));
+    }
 
     /* Initialize lvgl */
     static lv_disp_buf_t disp_buf;
     if(guiVdbBuffer1 && guiVDBsize > 0) {
         lv_init();
-        lv_disp_buf_init(&disp_buf, guiVdbBuffer1, NULL, guiVDBsize);
+        lv_disp_buf_init(&disp_buf, guiVdbBuffer1, guiVdbBuffer2, guiVDBsize);
     } else {
         LOG_FATAL(TAG_GUI, F(D_ERROR_OUT_OF_MEMORY));
     }
@@ -176,6 +216,7 @@ void guiSetup(void)
     lv_disp_drv_init(&disp_drv);
     disp_drv.buffer    = &disp_buf;
     disp_drv.flush_cb  = gui_flush_cb;
+    disp_drv.wait_cb   = gui_wait_cb;
     disp_drv.hor_res   = TFT_WIDTH;
     disp_drv.ver_res   = TFT_HEIGHT;
     lv_disp_t* display = lv_disp_drv_register(&disp_drv);
@@ -205,6 +246,8 @@ void guiSetup(void)
 #if HASP_USE_PNGDECODE > 0
     png_decoder_init();
 #endif
+    hasp_background_setup();
+    hasp_img_cache_setup(); // after the other decoders, so it is tried first
 
 #ifdef USE_DMA_TO_TFT
     LOG_VERBOSE(TAG_GUI, F("DMA        : ENABLED"));
@@ -221,7 +264,8 @@ void guiSetup(void)
 #ifdef LV_MEM_SIZE
     LOG_VERBOSE(TAG_LVGL, F("MEM size   : %d"), LV_MEM_SIZE);
 #endif
-    LOG_VERBOSE(TAG_LVGL, F("VFB size   : %d"), (size_t)sizeof(lv_color_t) * guiVDBsize);
+    LOG_VERBOSE(TAG_LVGL, F("VFB size   : %u x %d"), (uint32_t)(sizeof(lv_color_t) * guiVDBsize),
+                guiVdbBuffer2 ? 2 : 1);
 
     /* Initialize the touch pad */
     lv_indev_drv_t indev_drv;
@@ -229,6 +273,8 @@ void guiSetup(void)
     indev_drv.type = LV_INDEV_TYPE_POINTER;
 #if defined(WINDOWS)
     indev_drv.read_cb = mouse_read;
+#elif TOUCH_DRIVER == 2046
+    indev_drv.read_cb = gui_touch_read;
 #else
     indev_drv.read_cb = drv_touch_read;
 #endif
@@ -267,6 +313,7 @@ void guiSetup(void)
     lv_obj_user_data_t udata = (lv_obj_user_data_t){10, 0, 10};
     lv_obj_t* bar            = lv_bar_create(lv_layer_sys(), NULL);
     lv_obj_set_user_data(bar, udata);
+    hasp_object_registry_add(bar);
     lv_obj_set_hidden(bar, true);
     lv_bar_set_range(bar, 0, 100);
     lv_bar_set_value(bar, 10, LV_ANIM_OFF);
@@ -288,6 +335,13 @@ void guiLoop(void)
     //  tick.update();
 #endif
 
+    haspTft.flush_poll(); // complete a DMA transfer that finished since the last refresh
+
+    if(gui_refresh_held && guiGetRefreshHold() == 0) { // the burst is over, redraw it at once
+        gui_refresh_held = false;
+        guiResumeRefresh();
+    }
+
 #if !defined(WINDOWS)
     drv_touch_loop(); // update touch
 #endif
@@ -318,6 +372,63 @@ void guiStop()
     // #endif
 }
 
+/* Hold back screen refreshes while a batch of updates is applied, calls can be nested.
+ * Other lvgl tasks keep running, the invalidated areas are redrawn once the refresh is resumed. */
+void guiPauseRefresh()
+{
+    lv_disp_t* disp = lv_disp_get_default();
+    if(!disp || gui_refresh_paused++ > 0) return;
+
+#if LVGL_VERSION_MAJOR == 7
+    gui_refresh_prio = disp->refr_task->prio;
+    lv_task_set_prio(disp->refr_task, LV_TASK_PRIO_OFF);
+#else
+    lv_timer_pause(disp->refr_timer);
+#endif
+}
+
+void guiResumeRefresh()
+{
+    lv_disp_t* disp = lv_disp_get_default();
+    if(!disp || gui_refresh_paused == 0 || --gui_refresh_paused > 0) return;
+
+#if LVGL_VERSION_MAJOR == 7
+    lv_task_set_prio(disp->refr_task, gui_refresh_prio);
+    lv_task_ready(disp->refr_task);
+#else
+    lv_timer_resume(disp->refr_timer);
+    lv_timer_ready(disp->refr_timer);
+#endif
+}
+
+/* Keep the refresh paused across main loop iterations while a burst of updates comes in.
+ * Each call extends the hold, guiLoop resumes the refresh GUI_REFRESH_HOLD ms after the last call
+ * or GUI_REFRESH_HOLD_MAX ms after the first one, whichever comes first. */
+void guiHoldRefresh()
+{
+    gui_refresh_hold_last = millis();
+    if(gui_refresh_held) return;
+
+    gui_refresh_held       = true;
+    gui_refresh_hold_start = gui_refresh_hold_last;
+    guiPauseRefresh();
+}
+
+// Returns the time in ms until a held refresh resumes, 0 if it is not held
+uint32_t guiGetRefreshHold()
+{
+    if(!gui_refresh_held) return 0;
+
+    uint32_t now   = millis();
+    uint32_t quiet = now - gui_refresh_hold_last;
+    uint32_t held  = now - gui_refresh_hold_start;
+    if(quiet >= GUI_REFRESH_HOLD || held >= GUI_REFRESH_HOLD_MAX) return 0;
+
+    quiet = GUI_REFRESH_HOLD - quiet;
+    held  = GUI_REFRESH_HOLD_MAX - held;
+    return quiet < held ? quiet : held;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #if HASP_USE_CONFIG > 0
 bool guiGetConfig(const JsonObject& settings)
@@ -348,6 +459,12 @@ bool guiGetConfig(const JsonObject& settings)
     if(gui_settings.invert_display != settings[FPSTR(FP_GUI_INVERT)].as<bool>()) changed = true;
     settings[FPSTR(FP_GUI_INVERT)] = gui_settings.invert_display;
 
+    if(gui_settings.vdb_size != settings[FPSTR(FP_GUI_VDBSIZE)].as<uint16_t>()) changed = true;
+    settings[FPSTR(FP_GUI_VDBSIZE)] = gui_settings.vdb_size;
+
+    if(gui_settings.double_buffer != settings[FPSTR(FP_GUI_DOUBLEBUF)].as<bool>()) changed = true;
+    settings[FPSTR(FP_GUI_DOUBLEBUF)] = (bool)gui_settings.double_buffer;
+
     /* Check CalData array has changed */
     JsonArray array = settings[FPSTR(FP_GUI_CALIBRATION)].as<JsonArray>();
     uint8_t i       = 0;
@@ -406,6 +523,8 @@ bool guiSetConfig(const JsonObject& settings)
     changed |= configSet(guiSleepTime2, settings[FPSTR(FP_GUI_IDLEPERIOD2)], F("guiSleepTime2"));
     changed |= configSet(gui_settings.rotation, settings[FPSTR(FP_GUI_ROTATION)], F("gui_settings.rotation"));
     changed |= configSet(gui_settings.invert_display, settings[FPSTR(FP_GUI_INVERT)], F("guiInvertDisplay"));
+    changed |= configSet(gui_settings.vdb_size, settings[FPSTR(FP_GUI_VDBSIZE)], F("guiVdbSize")); // after restart
+    changed |= configSet(gui_settings.double_buffer, settings[FPSTR(FP_GUI_DOUBLEBUF)], F("guiDoubleBuffer"));
 
     hasp_set_sleep_time(guiSleepTime1, guiSleepTime2);
 
@@ -453,177 +572,98 @@ bool guiSetConfig(const JsonObject& settings)
 #endif // HASP_USE_CONFIG
 
 /* **************************** SCREENSHOTS ************************************** */
-#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0 || HASP_USE_HTTP > 0
-
-static void guiSetBmpHeader(uint8_t* buffer_p, int32_t data)
-{
-    *buffer_p++ = data & 0xFF;
-    *buffer_p++ = (data >> 8) & 0xFF;
-    *buffer_p++ = (data >> 16) & 0xFF;
-    *buffer_p++ = (data >> 24) & 0xFF;
-}
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+static char gui_screenshot_file[32];
 
-/** Send Bitmap Header.
- *
- * Sends a header in BMP format for the size of the screen.
- *
- * @note: send header before refreshing the whole screen
- *
- **/
-static void gui_get_bitmap_header(uint8_t* buffer, size_t bufsize)
+static size_t gui_screenshot_to_file(const uint8_t* buf, size_t size)
 {
-    memset(buffer, 0, bufsize);
-
-    lv_disp_t* disp = lv_disp_get_default();
-    buffer[0]       = 0x42; // B
-    buffer[1]       = 0x4D; // M
-
-    buffer[10 + 0] = 122;      // full header size
-    buffer[14 + 0] = 122 - 14; // dib header size
-    buffer[26 + 0] = 1;        // number of color planes
-    buffer[28 + 0] = 16;       // or 24, bbp
-    buffer[30 + 0] = 3;        // compression, 0 = RGB / 3 = RGBA
-
-    // The refresh draws the active screen only, so we need the dimensions of the active screen
-    // This could in be diferent from the display driver width/height if the screen has been resized
-    lv_obj_t* scr = lv_disp_get_scr_act(NULL);
-
-    // file size
-    guiSetBmpHeader(&buffer[2], 122 + disp->driver.hor_res * disp->driver.ver_res * buffer[28] / 8);
-    // horizontal resolution
-    guiSetBmpHeader(&buffer[18], lv_obj_get_width(scr));
-    // guiSetBmpHeader(&buffer[18], disp->driver.hor_res);
-    // vertical resolution
-    guiSetBmpHeader(&buffer[22], -lv_obj_get_height(scr));
-    // guiSetBmpHeader(&buffer[22], -disp->driver.ver_res);
-    // bitmap size
-    guiSetBmpHeader(&buffer[34], lv_obj_get_width(scr) * lv_obj_get_height(scr) * buffer[28 + 0] / 8);
-    // guiSetBmpHeader(&buffer[34], disp->driver.hor_res * disp->driver.ver_res * buffer[28 + 0] / 8);
-    // horizontal pixels per meter
-    guiSetBmpHeader(&buffer[38], 2836);
-    // vertical pixels per meter
-    guiSetBmpHeader(&buffer[42], 2836);
-    // R: 1111 1000 | 0000 0000
-    guiSetBmpHeader(&buffer[54], 0xF800); // Red bitmask
-    // G: 0000 0111 | 1110 0000
-    guiSetBmpHeader(&buffer[58], 0x07E0); // Green bitmask
-    // B: 0000 0000 | 0001 1111
-    guiSetBmpHeader(&buffer[62], 0x001F); // Blue bitmask
-    // A: 0000 0000 | 0000 0000
-    guiSetBmpHeader(&buffer[66], 0x0000); // No Aplpha Mask
-
-    // "Win
-    buffer[70 + 3] = 0x57;
-    buffer[70 + 2] = 0x69;
-    buffer[70 + 1] = 0x6E;
-    buffer[70 + 0] = 0x20;
+    return pFileOut.write(buf, size);
 }
 
-void gui_flush_not_complete()
+/* Encode the next band of the screen, lvgl and the inputs run between the bands */
+static void gui_screenshot_task(lv_task_t* task)
 {
-    LOG_WARNING(TAG_GUI, F("Pixelbuffer not completely sent"));
-}
-#endif // HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0 || HASP_USE_HTTP > 0
+    if(gui_refresh_paused) return; // wait for the page to be complete
+    if(screenshot_step()) return;
 
-#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
-/* Flush VDB bytes to a file */
-static void gui_screenshot_to_file(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
-{
-    size_t len = (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1); /* Number of pixels */
-    len *= sizeof(lv_color_t);                                          /* Number of bytes */
-    size_t res = pFileOut.write((uint8_t*)color_p, len);
-    if(res != len) gui_flush_not_complete();
+    bool success = screenshot_end();
+    pFileOut.close();
+    lv_task_del(task);
 
-    // indirect callback to flush screenshot data to the screen
-    // drv_display_flush_cb(disp, area, color_p);
-    haspTft.flush_pixels(disp, area, color_p);
+    if(success) {
+        LOG_VERBOSE(TAG_GUI, F("Screenshot saved to %s"), gui_screenshot_file);
+    } else {
+        LOG_ERROR(TAG_GUI, F("Screenshot %s is incomplete"), gui_screenshot_file);
+    }
 }
 
 /** Take Screenshot.
  *
- * Flush buffer into a binary file.
+ * Start writing the screen to a file, the image is rendered and saved in the background.
  *
- * @note: data pixel should be formated to uint16_t RGB. Set by Bitmap header.
+ * @note: a .bmp file is saved as a raw 16-bit bitmap, all other names as a PNG image.
  *
- * @param[in] pFileName   Output binary file name.
+ * @param[in] pFileName   Output file name.
  *
  **/
 void guiTakeScreenshot(const char* pFileName)
 {
-    uint8_t buffer[128];
-    gui_get_bitmap_header(buffer, sizeof(buffer));
+    if(screenshot_busy()) {
+        LOG_WARNING(TAG_GUI, F("Screenshot already in progress"));
+        return;
+    }
 
     pFileOut = HASP_FS.open(pFileName, "w");
-    if(pFileOut) {
-
-        size_t len = pFileOut.write(buffer, 122);
-        if(len == 122) {
-            LOG_VERBOSE(TAG_GUI, F("Bitmap header written"));
-
-            /* Refresh screen to screenshot callback */
-            lv_disp_t* disp = lv_disp_get_default();
-            void (*flush_cb)(struct _disp_drv_t * disp_drv, const lv_area_t* area, lv_color_t* color_p);
-            flush_cb              = disp->driver.flush_cb; /* store callback */
-            disp->driver.flush_cb = gui_screenshot_to_file;
-
-            lv_obj_invalidate(lv_scr_act());
-            lv_refr_now(NULL);                /* Will call our disp_drv.disp_flush function */
-            disp->driver.flush_cb = flush_cb; /* restore callback */
-
-            LOG_VERBOSE(TAG_GUI, F("Bitmap data flushed to %s"), pFileName);
+    if(!pFileOut) {
+        LOG_WARNING(TAG_GUI, F("%s cannot be opened"), pFileName);
+        return;
+    }
 
-        } else {
-            LOG_ERROR(TAG_GUI, F("Data written does not match header size"));
-        }
+    const char* ext            = strrchr(pFileName, '.');
+    screenshot_format_t format = ext && !strcasecmp_P(ext, PSTR(".bmp")) ? SCREENSHOT_BMP : SCREENSHOT_PNG;
+    if(!screenshot_begin(gui_screenshot_to_file, format)) {
+        screenshot_end();
         pFileOut.close();
-
-    } else {
-        LOG_WARNING(TAG_GUI, F("%s cannot be opened"), pFileName);
+        LOG_ERROR(TAG_GUI, F("Data written does not match header size"));
+        return;
     }
+
+    strncpy(gui_screenshot_file, pFileName, sizeof(gui_screenshot_file) - 1);
+    lv_task_create(gui_screenshot_task, 1, LV_TASK_PRIO_LOW, NULL);
+    LOG_VERBOSE(TAG_GUI, F("Screenshot started"));
 }
 #endif
 
 #if HASP_USE_HTTP > 0
-/* Flush VDB bytes to a webclient */
-static void gui_screenshot_to_http(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
-{
-    size_t len = (area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1); /* Number of pixels */
-    len *= sizeof(lv_color_t);                                          /* Number of bytes */
-    size_t res = httpClientWrite((uint8_t*)color_p, len);
-    if(res != len) gui_flush_not_complete();
-
-    // indirect callback to flush screenshot data to the screen
-    // drv_display_flush_cb(disp, area, color_p);
-    haspTft.flush_pixels(disp, area, color_p);
-}
-
 /** Take Screenshot.
  *
- * Flush buffer into a http client.
+ * Stream the screen as a PNG image to the http client.
  *
- * @note: data pixel should be formated to uint16_t RGB. Set by Bitmap header.
+ * @note: lvgl and the inputs keep running between the bands of the image.
  *
  **/
 void guiTakeScreenshot()
 {
-    uint8_t buffer[128];
-    gui_get_bitmap_header(buffer, sizeof(buffer));
+    if(screenshot_busy()) {
+        LOG_WARNING(TAG_GUI, F("Screenshot already in progress"));
+        return;
+    }
 
-    if(httpClientWrite(buffer, 122) == 122) {
-        LOG_VERBOSE(TAG_GUI, F("Bitmap header sent"));
+    if(!screenshot_begin(httpClientWrite, SCREENSHOT_PNG)) {
+        screenshot_end();
+        LOG_ERROR(TAG_GUI, F("Data sent does not match header size"));
+        return;
+    }
 
-        /* Refresh screen to screenshot callback */
-        lv_disp_t* disp = lv_disp_get_default();
-        void (*flush_cb)(struct _disp_drv_t * disp_drv, const lv_area_t* area, lv_color_t* color_p);
-        flush_cb              = disp->driver.flush_cb; /* store callback */
-        disp->driver.flush_cb = gui_screenshot_to_http;
-        lv_obj_invalidate(lv_scr_act());
-        lv_refr_now(NULL);                /* Will call our disp_drv.disp_flush function */
-        disp->driver.flush_cb = flush_cb; /* restore callback */
+    while(screenshot_step()) {
+        guiLoop();
+        lv_task_handler();
+    }
 
+    if(screenshot_end()) {
         LOG_VERBOSE(TAG_GUI, F("Bitmap data flushed to webclient"));
     } else {
-        LOG_ERROR(TAG_GUI, F("Data sent does not match header size"));
+        LOG_ERROR(TAG_GUI, F("Screenshot sent to webclient is incomplete"));
     }
 }
 #endif
\ No newline at end of file
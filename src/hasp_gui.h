@@ -7,6 +7,13 @@
 #include "ArduinoJson.h"
 #include "lvgl.h"
 
+#ifndef GUI_REFRESH_HOLD
+#define GUI_REFRESH_HOLD 40 // ms without new updates before a held refresh resumes
+#endif
+#ifndef GUI_REFRESH_HOLD_MAX
+#define GUI_REFRESH_HOLD_MAX 300 // ms a burst of updates can hold back the refresh
+#endif
+
 struct gui_conf_t
 {
     bool show_pointer;
@@ -14,6 +21,8 @@ struct gui_conf_t
     uint8_t rotation;
     uint8_t invert_display;
     uint16_t cal_data[5];
+    uint16_t vdb_size;     // size of a draw buffer in KB
+    uint8_t double_buffer; // render into a second buffer while the first is flushed
 };
 
 /* ===== Default Event Processors ===== */
@@ -27,6 +36,12 @@ void guiStop(void);
 void guiCalibrate(void);
 void guiTakeScreenshot(const char* pFileName); // to file
 void guiTakeScreenshot(void);                  // webclient
+void guiPauseRefresh(void);
+void guiResumeRefresh(void);
+void guiHoldRefresh(void);
+
+/* ===== Getter and Setter Functions ===== */
+uint32_t guiGetRefreshHold(void);
 
 /* ===== Read/Write Configuration ===== */
 #if HASP_USE_CONFIG > 0
@@ -0,0 +1,411 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#include "hasp_conf.h"
+
+#include "lvgl.h"
+
+#include "hasp_debug.h"
+#include "hasp_screenshot.h"
+
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0 || HASP_USE_HTTP > 0
+
+#define BMP_HEADER_SIZE 122
+
+struct screenshot_t
+{
+    screenshot_write_cb_t write_cb;
+    void (*flush_cb)(struct _disp_drv_t* disp_drv, const lv_area_t* area, lv_color_t* color_p); // of the display
+    screenshot_format_t format;
+    bool failed;
+    uint16_t width;
+    uint16_t height;
+    uint16_t row;   // next row to encode
+    uint16_t lines; // rows rendered per step, the rows that fit in the draw buffer
+
+    /* PNG only */
+    uint32_t stride; // bytes per row, including the filter byte
+    uint32_t adler_a;
+    uint32_t adler_b;
+    uint32_t bits; // deflate bits not written yet
+    uint8_t bit_count;
+    bool has_prev;
+    uint8_t* cur;  // RGB888 of the current row
+    uint8_t* prev; // RGB888 of the row above
+    uint16_t out_len;
+    uint8_t out[SCREENSHOT_OUT_SIZE];
+};
+
+static screenshot_t* shot;
+
+/* ===== Output Helpers ===== */
+
+static void screenshot_write(const uint8_t* buf, size_t size)
+{
+    if(!shot->failed && shot->write_cb(buf, size) != size) {
+        LOG_WARNING(TAG_GUI, F("Pixelbuffer not completely sent"));
+        shot->failed = true;
+    }
+}
+
+static inline void screenshot_set_u32_le(uint8_t* buf, uint32_t data)
+{
+    buf[0] = data & 0xFF;
+    buf[1] = (data >> 8) & 0xFF;
+    buf[2] = (data >> 16) & 0xFF;
+    buf[3] = (data >> 24) & 0xFF;
+}
+
+static inline void screenshot_set_u32_be(uint8_t* buf, uint32_t data)
+{
+    buf[0] = (data >> 24) & 0xFF;
+    buf[1] = (data >> 16) & 0xFF;
+    buf[2] = (data >> 8) & 0xFF;
+    buf[3] = data & 0xFF;
+}
+
+/* ===== BMP Encoder ===== */
+
+/* Header in BMP format for a 16-bit image of the size of the screen */
+static void screenshot_bmp_header(uint8_t* buffer)
+{
+    memset(buffer, 0, BMP_HEADER_SIZE);
+
+    buffer[0] = 0x42; // B
+    buffer[1] = 0x4D; // M
+
+    buffer[10 + 0] = BMP_HEADER_SIZE;      // full header size
+    buffer[14 + 0] = BMP_HEADER_SIZE - 14; // dib header size
+    buffer[26 + 0] = 1;                    // number of color planes
+    buffer[28 + 0] = 16;                   // or 24, bbp
+    buffer[30 + 0] = 3;                    // compression, 0 = RGB / 3 = RGBA
+
+    uint32_t size = shot->width * shot->height * buffer[28] / 8;
+    screenshot_set_u32_le(&buffer[2], BMP_HEADER_SIZE + size); // file size
+    screenshot_set_u32_le(&buffer[18], shot->width);           // horizontal resolution
+    screenshot_set_u32_le(&buffer[22], -shot->height);         // vertical resolution, top to bottom
+    screenshot_set_u32_le(&buffer[34], size);                  // bitmap size
+    screenshot_set_u32_le(&buffer[38], 2836);                  // horizontal pixels per meter
+    screenshot_set_u32_le(&buffer[42], 2836);                  // vertical pixels per meter
+    screenshot_set_u32_le(&buffer[54], 0xF800);                // Red bitmask   1111 1000 | 0000 0000
+    screenshot_set_u32_le(&buffer[58], 0x07E0);                // Green bitmask 0000 0111 | 1110 0000
+    screenshot_set_u32_le(&buffer[62], 0x001F);                // Blue bitmask  0000 0000 | 0001 1111
+    screenshot_set_u32_le(&buffer[66], 0x0000);                // No Alpha Mask
+
+    // "Win
+    buffer[70 + 3] = 0x57;
+    buffer[70 + 2] = 0x69;
+    buffer[70 + 1] = 0x6E;
+    buffer[70 + 0] = 0x20;
+}
+
+/* ===== PNG Encoder ===== */
+/* A single fixed Huffman deflate block, matches only repeat the previous pixel or the pixels of the row above.
+ * This is the run-length strategy of zlib, it needs no window or hash tables and compresses the flat areas and
+ * repeated rows of a user interface well. */
+
+static const uint16_t png_length_base[] = {3,  4,  5,  6,  7,  8,  9,   10,  11,  13,  15,  17,  19,  23, 27,
+                                           31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t png_length_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                           2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t png_dist_base[]   = {1,    2,    3,    4,    5,    7,    9,    13,    17,    25,
+                                         33,   49,   65,   97,   129,  193,  257,  385,   513,   769,
+                                         1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t png_dist_extra[]   = {0, 0, 0, 0, 1, 1, 2, 2, 3,  3,  4,  4,  5,  5,  6,
+                                         6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static uint32_t png_crc32(uint32_t crc, const uint8_t* buf, size_t len)
+{
+    static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                       0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                       0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+    crc = ~crc;
+    while(len--) {
+        crc ^= *buf++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static void png_write_chunk(const char* type, const uint8_t* data, uint32_t len)
+{
+    uint8_t header[8];
+    uint8_t footer[4];
+
+    screenshot_set_u32_be(header, len);
+    memcpy(header + 4, type, 4);
+    screenshot_set_u32_be(footer, png_crc32(png_crc32(0, header + 4, 4), data, len));
+
+    screenshot_write(header, sizeof(header));
+    if(len > 0) screenshot_write(data, len);
+    screenshot_write(footer, sizeof(footer));
+}
+
+static void png_put_byte(uint8_t byte)
+{
+    shot->out[shot->out_len++] = byte;
+    if(shot->out_len == sizeof(shot->out)) {
+        png_write_chunk("IDAT", shot->out, shot->out_len);
+        shot->out_len = 0;
+    }
+}
+
+/* Deflate packs the bits starting with the least significant bit */
+static void png_put_bits(uint32_t value, uint8_t count)
+{
+    shot->bits |= value << shot->bit_count;
+    shot->bit_count += count;
+    while(shot->bit_count >= 8) {
+        png_put_byte(shot->bits & 0xFF);
+        shot->bits >>= 8;
+        shot->bit_count -= 8;
+    }
+}
+
+/* Huffman codes are packed starting with the most significant bit */
+static void png_put_code(uint16_t code, uint8_t len)
+{
+    uint16_t reversed = 0;
+    for(uint8_t i = 0; i < len; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    png_put_bits(reversed, len);
+}
+
+/* Fixed Huffman code of a literal or length symbol */
+static void png_put_symbol(uint16_t symbol)
+{
+    if(symbol < 144)
+        png_put_code(0x30 + symbol, 8);
+    else if(symbol < 256)
+        png_put_code(0x190 + symbol - 144, 9);
+    else if(symbol < 280)
+        png_put_code(symbol - 256, 7);
+    else
+        png_put_code(0xC0 + symbol - 280, 8);
+}
+
+static void png_put_match(uint16_t length, uint16_t distance)
+{
+    uint8_t i = sizeof(png_length_extra) - 1;
+    while(png_length_base[i] > length) i--;
+    png_put_symbol(257 + i);
+    png_put_bits(length - png_length_base[i], png_length_extra[i]);
+
+    i = sizeof(png_dist_extra) - 1;
+    while(png_dist_base[i] > distance) i--;
+    png_put_code(i, 5);
+    png_put_bits(distance - png_dist_base[i], png_dist_extra[i]);
+}
+
+static void png_begin()
+{
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    screenshot_write(signature, sizeof(signature));
+
+    uint8_t ihdr[13];
+    screenshot_set_u32_be(ihdr, shot->width);
+    screenshot_set_u32_be(ihdr + 4, shot->height);
+    ihdr[8]  = 8; // bit depth
+    ihdr[9]  = 2; // color type RGB
+    ihdr[10] = 0; // compression deflate
+    ihdr[11] = 0; // filter adaptive
+    ihdr[12] = 0; // no interlace
+    png_write_chunk("IHDR", ihdr, sizeof(ihdr));
+
+    shot->adler_a = 1;
+    shot->adler_b = 0;
+    png_put_byte(0x78); // zlib header, deflate with a 32K window
+    png_put_byte(0x01);
+    png_put_bits(1, 1); // final block
+    png_put_bits(1, 2); // fixed Huffman codes
+}
+
+static void png_put_row(const lv_color_t* color_p)
+{
+    uint8_t* cur = shot->cur;
+    cur[0]       = 0; // filter type none
+    for(uint16_t x = 0; x < shot->width; x++) {
+        uint32_t c     = lv_color_to32(color_p[x]);
+        cur[x * 3 + 1] = (c >> 16) & 0xFF;
+        cur[x * 3 + 2] = (c >> 8) & 0xFF;
+        cur[x * 3 + 3] = c & 0xFF;
+    }
+
+    /* Adler-32 of the uncompressed data, the sums fit in 32 bits for rows up to 5552 bytes */
+    for(uint32_t i = 0; i < shot->stride; i += 5552) {
+        uint32_t end = i + 5552 < shot->stride ? i + 5552 : shot->stride;
+        for(uint32_t j = i; j < end; j++) {
+            shot->adler_a += cur[j];
+            shot->adler_b += shot->adler_a;
+        }
+        shot->adler_a %= 65521;
+        shot->adler_b %= 65521;
+    }
+
+    uint32_t i = 0;
+    while(i < shot->stride) {
+        uint16_t length   = 0;
+        uint16_t distance = 0;
+        uint16_t max      = shot->stride - i < 258 ? shot->stride - i : 258;
+
+        if(i >= 3) { // repeat the previous pixel
+            uint16_t n = 0;
+            while(n < max && cur[i + n] == cur[i + n - 3]) n++;
+            if(n >= 3) {
+                length   = n;
+                distance = 3;
+            }
+        }
+        if(shot->has_prev) { // repeat the row above
+            uint16_t n = 0;
+            while(n < max && cur[i + n] == shot->prev[i + n]) n++;
+            if(n >= 3 && n > length) {
+                length   = n;
+                distance = shot->stride;
+            }
+        }
+
+        if(length > 0) {
+            png_put_match(length, distance);
+            i += length;
+        } else {
+            png_put_symbol(cur[i++]);
+        }
+    }
+
+    shot->cur      = shot->prev;
+    shot->prev     = cur;
+    shot->has_prev = true;
+}
+
+static void png_end()
+{
+    png_put_symbol(256);                                          // end of block
+    if(shot->bit_count > 0) png_put_bits(0, 8 - shot->bit_count); // pad to a byte
+
+    uint32_t adler = (shot->adler_b << 16) | shot->adler_a;
+    png_put_byte(adler >> 24);
+    png_put_byte((adler >> 16) & 0xFF);
+    png_put_byte((adler >> 8) & 0xFF);
+    png_put_byte(adler & 0xFF);
+    if(shot->out_len > 0) png_write_chunk("IDAT", shot->out, shot->out_len);
+
+    png_write_chunk("IEND", NULL, 0);
+}
+
+/* ===== Render Callback ===== */
+
+/* Encode the rows of the flushed area, then pass it on to the display */
+static void screenshot_flush_cb(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
+{
+    lv_coord_t width = lv_area_get_width(area);
+
+    if(area->x1 > 0 || area->x2 < shot->width - 1) {
+        shot->failed = true; // only full rows can be encoded
+    } else {
+        for(lv_coord_t y = shot->row; y <= area->y2 && y < shot->height && !shot->failed; y++) {
+            if(y < area->y1) break; // the rows are flushed top to bottom
+
+            const lv_color_t* row = color_p + (y - area->y1) * width - area->x1;
+            if(shot->format == SCREENSHOT_PNG)
+                png_put_row(row);
+            else
+                screenshot_write((const uint8_t*)row, shot->width * sizeof(lv_color_t));
+            shot->row++;
+        }
+    }
+
+    shot->flush_cb(disp, area, color_p);
+}
+
+/* ===== Default Event Processors ===== */
+
+bool screenshot_begin(screenshot_write_cb_t write_cb, screenshot_format_t format)
+{
+    lv_disp_t* disp = lv_disp_get_default();
+    if(shot || !disp) return false;
+
+    uint16_t width = lv_disp_get_hor_res(disp);
+    size_t size    = sizeof(screenshot_t);
+    if(format == SCREENSHOT_PNG) size += 2 * (width * 3 + 1);
+
+    shot = (screenshot_t*)calloc(1, size);
+    if(!shot) return false;
+
+    shot->write_cb = write_cb;
+    shot->flush_cb = disp->driver.flush_cb;
+    shot->format   = format;
+    shot->width    = width;
+    shot->height   = lv_disp_get_ver_res(disp);
+    shot->lines    = disp->driver.buffer->size / width;
+    if(shot->lines == 0) shot->lines = 1;
+
+    if(format == SCREENSHOT_PNG) {
+        shot->stride = width * 3 + 1;
+        shot->cur    = (uint8_t*)(shot + 1);
+        shot->prev   = shot->cur + shot->stride;
+        png_begin();
+    } else {
+        uint8_t buffer[BMP_HEADER_SIZE];
+        screenshot_bmp_header(buffer);
+        screenshot_write(buffer, sizeof(buffer));
+    }
+
+    return !shot->failed;
+}
+
+// Render and encode the next band of the screen, returns false when the image is complete or failed
+bool screenshot_step()
+{
+    if(!shot || shot->failed || shot->row >= shot->height) return false;
+
+    lv_disp_t* disp = lv_disp_get_default();
+    lv_refr_now(disp); // draw pending changes normally first, the next refresh only contains the band
+
+    lv_area_t band;
+    band.x1 = 0;
+    band.y1 = shot->row;
+    band.x2 = shot->width - 1;
+    band.y2 = shot->row + shot->lines - 1;
+    if(band.y2 >= shot->height) band.y2 = shot->height - 1;
+
+    uint16_t row          = shot->row;
+    disp->driver.flush_cb = screenshot_flush_cb;
+    _lv_inv_area(disp, &band);
+    lv_refr_now(disp);
+    disp->driver.flush_cb = shot->flush_cb;
+
+    if(shot->row == row) shot->failed = true; // nothing was drawn
+    return !shot->failed && shot->row < shot->height;
+}
+
+// Write the end of the image and release the engine, returns true if the complete image was written
+bool screenshot_end()
+{
+    if(!shot) return false;
+
+    if(!shot->failed && shot->row < shot->height) shot->failed = true; // aborted
+    if(!shot->failed && shot->format == SCREENSHOT_PNG) png_end();
+
+    bool success = !shot->failed;
+    free(shot);
+    shot = NULL;
+    return success;
+}
+
+/* ===== Getter and Setter Functions ===== */
+
+bool screenshot_busy()
+{
+    return shot != NULL;
+}
+
+const char* screenshot_mimetype(screenshot_format_t format)
+{
+    return format == SCREENSHOT_PNG ? PSTR("image/png") : PSTR("image/bmp");
+}
+
+#endif // HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0 || HASP_USE_HTTP > 0
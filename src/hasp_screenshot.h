@@ -0,0 +1,35 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_SCREENSHOT_H
+#define HASP_SCREENSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Screenshot engine
+ * The screen is rendered again one band of the draw buffer at a time and each band is encoded while it is
+ * flushed to the display, so the caller can let lvgl and the inputs run between the steps. The output is
+ * streamed through a write callback as a PNG compressed with run-length deflate, or as a raw 16-bit BMP.
+ */
+enum screenshot_format_t : uint8_t {
+    SCREENSHOT_BMP,
+    SCREENSHOT_PNG,
+};
+
+#ifndef SCREENSHOT_OUT_SIZE
+#define SCREENSHOT_OUT_SIZE 1024 // bytes of compressed data per PNG chunk
+#endif
+
+typedef size_t (*screenshot_write_cb_t)(const uint8_t* buf, size_t size);
+
+/* ===== Default Event Processors ===== */
+bool screenshot_begin(screenshot_write_cb_t write_cb, screenshot_format_t format);
+bool screenshot_step(void);
+bool screenshot_end(void);
+
+/* ===== Getter and Setter Functions ===== */
+bool screenshot_busy(void);
+const char* screenshot_mimetype(screenshot_format_t format);
+
+#endif
@@ -2,9 +2,13 @@
 
 #include "hasp/hasp.h"
 #include "hasp/hasp_attribute.h"
+#include "hasp/hasp_background.h"
 #include "hasp/hasp_dispatch.h"
+#include "hasp/hasp_imgcache.h"
 #include "hasp/hasp_object.h"
+#include "hasp/hasp_pagebin.h"
 #include "hasp/hasp_parser.h"
+#include "hasp/hasp_rules.h"
 #include "hasp/hasp_utilities.h"
 #include "hasp/hasp_lvfs.h"
 
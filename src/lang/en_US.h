@@ -45,6 +45,8 @@
 #define D_MQTT_INVALID_TOPIC "Message has invalid topic"
 #define D_MQTT_SUBSCRIBED "Subscribed to %s"
 #define D_MQTT_NOT_SUBSCRIBED "Failed to subscribe to %s"
+#define D_MQTT_UNSUBSCRIBED "Unsubscribed from %s"
+#define D_MQTT_NOT_UNSUBSCRIBED "Failed to unsubscribe from %s"
 #define D_MQTT_HA_AUTO_DISCOVERY "Register HA auto-discovery"
 
 #define D_TELNET_CLOSING_CONNECTION "Closing session from %s"
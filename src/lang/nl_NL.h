@@ -45,6 +45,8 @@
 #define D_MQTT_INVALID_TOPIC "Boodschap met ongeldig onderwerp"
 #define D_MQTT_SUBSCRIBED "Ingeschreven op %s"
 #define D_MQTT_NOT_SUBSCRIBED "Inschrijving op %s mislukt"
+#define D_MQTT_UNSUBSCRIBED "Uitgeschreven van %s"
+#define D_MQTT_NOT_UNSUBSCRIBED "Uitschrijving van %s mislukt"
 #define D_MQTT_HA_AUTO_DISCOVERY "Registeren HA auto-configuratie"
 
 #define D_TELNET_CLOSING_CONNECTION "Sessie sluiten van %s"
@@ -38,6 +38,11 @@
 
 #include "hasp/hasp_dispatch.h"
 #include "hasp/hasp.h"
+#include "sys/hasp_scheduler.h"
+
+#if LV_USE_FS_IF != 0
+#include "lv_fs_cache.h"
+#endif
 
 #ifdef USE_CONFIG_OVERRIDE
 #include "user_config_override.h"
@@ -47,8 +52,12 @@
 #define SERIAL_SPEED 115200
 #endif
 
+#ifndef LOG_DEFERRED_BUDGET
+#define LOG_DEFERRED_BUDGET 4 // deferred log lines printed per main loop pass
+#endif
+
 #if HASP_USE_SYSLOG > 0
-#include <WiFiUdp.h>
+#include "hasp_syslog.h"
 
 #ifndef SYSLOG_SERVER
 #define SYSLOG_SERVER ""
@@ -73,8 +82,19 @@ uint16_t debugSyslogPort    = SYSLOG_PORT;
 uint8_t debugSyslogFacility = 0;
 uint8_t debugSyslogProtocol = 0;
 
-// A UDP instance to let us send and receive packets over UDP
-WiFiUDP* syslogClient;
+// Log output that assembles the lines into batched syslog datagrams
+class SyslogPrint : public Print {
+  public:
+    size_t write(uint8_t c) override
+    {
+        return syslogWrite(&c, 1);
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        return syslogWrite(buffer, size);
+    }
+};
+SyslogPrint syslogOutput;
 #define SYSLOG_PROTO_IETF 0
 
 // Create a new syslog instance with LOG_KERN facility
@@ -107,8 +127,8 @@ ConsoleInput debugConsole(&Serial, HASP_CONSOLE_BUFFER);
 #define TERM_COLOR_RESET "\e[0m"
 #define TERM_CLEAR_LINE "\e[1000D\e[0K"
 
-unsigned long debugLastMillis = 0;
-uint16_t debugTelePeriod      = 300;
+uint16_t debugTelePeriod     = 300;
+static int8_t debugTeleTimer = -1; // scheduler timer of the tele period
 
 // Send the HASP header and version to the output device specified
 void debugPrintHaspHeader(Print* output)
@@ -150,12 +170,44 @@ void debugStart()
 // }
 // #endif
 
+/* Runs every tele period, registered with the scheduler by debugSetup */
+static void debugTelePeriodTask()
+{
+    dispatch_output_statusupdate(NULL, NULL);
+
+#if HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+    lv_zifont_cache_info_t cache;
+    lv_zifont_cache_info(&cache);
+    LOG_VERBOSE(TAG_FONT, F("Glyph cache: %u hits, %u misses, %u evictions, %u glyphs in %u/%u bytes"), cache.hits,
+                cache.misses, cache.evictions, cache.count, cache.used, cache.size);
+#endif
+#endif
+
+#if LV_USE_FS_IF != 0
+    static uint32_t fs_cache_last_accesses; // only log when the filesystem was used since the last report
+    lv_fs_cache_info_t fs_cache;
+    lv_fs_cache_info(&fs_cache);
+    uint32_t opens = fs_cache.handle_hits + fs_cache.handle_misses;
+    uint32_t reads = fs_cache.block_hits + fs_cache.block_misses;
+    if(opens + reads + fs_cache.bypassed != fs_cache_last_accesses) {
+        fs_cache_last_accesses = opens + reads + fs_cache.bypassed;
+        LOG_VERBOSE(TAG_LVFS, F("File cache: %u%% of %u opens and %u%% of %u reads hit, %u bypassed, %u evictions"),
+                    opens ? fs_cache.handle_hits * 100 / opens : 0, opens,
+                    reads ? fs_cache.block_hits * 100 / reads : 0, reads, fs_cache.bypassed, fs_cache.evictions);
+    }
+#endif
+}
+
 void debugSetup()
 {
     // memset(serialInputBuffer, 0, sizeof(serialInputBuffer));
     // serialInputIndex = 0;
     LOG_TRACE(TAG_DEBG, F(D_SERVICE_STARTING)); // Starting console
     debugConsole.setLineCallback(dispatch_text_line);
+
+    uint32_t teleperiod = debugTelePeriod * 1000u;
+    debugTeleTimer      = schedulerAdd(teleperiod, debugTelePeriodTask, teleperiod); // paused when 0
 }
 
 void debugStartSyslog()
@@ -170,13 +222,9 @@ void debugStartSyslog()
     // syslog->defaultPriority(priority);
 
     if(strlen(debugSyslogHost) > 0) {
-        if(!syslogClient) syslogClient = new WiFiUDP();
-
-        if(syslogClient) {
-            if(syslogClient->beginPacket(debugSyslogHost, debugSyslogPort)) {
-                Log.registerOutput(2, syslogClient, LOG_LEVEL_VERBOSE, true);
-                LOG_INFO(TAG_SYSL, F(D_SERVICE_STARTED));
-            }
+        if(syslogStart(debugSyslogHost, debugSyslogPort)) {
+            Log.registerOutput(2, &syslogOutput, LOG_LEVEL_VERBOSE, true);
+            LOG_INFO(TAG_SYSL, F(D_SERVICE_STARTED));
         } else {
             LOG_ERROR(TAG_SYSL, F(D_SERVICE_START_FAILED));
         }
@@ -190,6 +238,7 @@ void debugStopSyslog()
     if(strlen(debugSyslogHost) > 0) {
         LOG_WARNING(TAG_SYSL, F(D_SERVICE_STOPPED));
         Log.unregisterOutput(2);
+        syslogStop();
     }
 #endif
 }
@@ -245,7 +294,10 @@ bool debugSetConfig(const JsonObject& settings)
     changed |= configSet(debugSerialBaud, settings[FPSTR(FP_CONFIG_BAUD)], F("debugSerialBaud"));
 
     /* Teleperiod Settings*/
-    changed |= configSet(debugTelePeriod, settings[FPSTR(FP_DEBUG_TELEPERIOD)], F("debugTelePeriod"));
+    if(configSet(debugTelePeriod, settings[FPSTR(FP_DEBUG_TELEPERIOD)], F("debugTelePeriod"))) {
+        schedulerSetInterval(debugTeleTimer, debugTelePeriod * 1000u);
+        changed = true;
+    }
 
 /* Syslog Settings*/
 #if HASP_USE_SYSLOG > 0
@@ -366,7 +418,7 @@ static void debugPrintTimestamp(int level, Print* _logOutput)
         _logOutput->print(buffer);
         _logOutput->printf(PSTR("%03lu]"), tval.tv_usec / 1000);
     } else {
-        uint32_t msecs = millis();
+        uint32_t msecs = Log.getTimestamp(); // the time of the log call, also for deferred lines
         _logOutput->printf(PSTR("[%15d.%03d]"), msecs / 1000, msecs % 1000);
     }
 }
@@ -409,6 +461,28 @@ static void debugPrintLvglMemory(int level, Print* _logOutput)
 }
 #endif
 
+#if HASP_USE_SYSLOG > 0
+// Memory info for syslog lines, queried at most once per flush interval instead of for every line
+static void debugPrintSyslogMemory()
+{
+    static char buffer[36];
+    static uint32_t lastMillis;
+
+    if(buffer[0] == 0 || millis() - lastMillis >= SYSLOG_FLUSH_MS) {
+        size_t len = snprintf_P(buffer, sizeof(buffer), PSTR("[%5u/%5u%3u]"), haspDevice.get_free_max_block(),
+                                haspDevice.get_free_heap(), haspDevice.get_heap_fragmentation());
+#if LV_MEM_CUSTOM == 0
+        lv_mem_monitor_t mem_mon;
+        lv_mem_monitor(&mem_mon);
+        snprintf_P(buffer + len, sizeof(buffer) - len, PSTR("[%5u/%5u%3u]"), mem_mon.free_biggest_size,
+                   mem_mon.free_size, mem_mon.frag_pct);
+#endif
+        lastMillis = millis();
+    }
+    syslogOutput.print(buffer);
+}
+#endif
+
 static void debugPrintPriority(int level, Print* _logOutput)
 {
     // if(_logOutput == &syslogClient) {
@@ -551,35 +625,30 @@ void debugPrintPrefix(uint8_t tag, int level, Print* _logOutput)
 {
 #if HASP_USE_SYSLOG > 0
 
-    if(_logOutput == syslogClient && syslogClient) {
-        if(syslogClient->beginPacket(debugSyslogHost, debugSyslogPort)) {
+    if(_logOutput == &syslogOutput) {
+        // IETF Doc: https://tools.ietf.org/html/rfc5424 - The Syslog Protocol
+        // BSD Doc: https://tools.ietf.org/html/rfc3164 - The BSD syslog Protocol
 
-            // IETF Doc: https://tools.ietf.org/html/rfc5424 - The Syslog Protocol
-            // BSD Doc: https://tools.ietf.org/html/rfc3164 - The BSD syslog Protocol
-
-            syslogClient->print(F("<"));
-            syslogClient->print((16 + debugSyslogFacility) * 8 + level);
-            syslogClient->print(F(">"));
-
-            if(debugSyslogProtocol == SYSLOG_PROTO_IETF) {
-                syslogClient->print(F("1 - "));
-            }
+        syslogMessageBegin();
+        syslogOutput.print(F("<"));
+        syslogOutput.print((16 + debugSyslogFacility) * 8 + level);
+        syslogOutput.print(F(">"));
 
-            syslogClient->print(haspDevice.get_hostname());
-            syslogClient->print(F(" "));
-            debugPrintTag(tag, _logOutput);
+        if(debugSyslogProtocol == SYSLOG_PROTO_IETF) {
+            syslogOutput.print(F("1 - "));
+        }
 
-            if(debugSyslogProtocol == SYSLOG_PROTO_IETF) {
-                syslogClient->print(F(" - - - \xEF\xBB\xBF")); // include UTF-8 BOM
-            } else {
-                syslogClient->print(F(": "));
-            }
+        syslogOutput.print(haspDevice.get_hostname());
+        syslogOutput.print(F(" "));
+        debugPrintTag(tag, _logOutput);
 
-            debugPrintHaspMemory(level, _logOutput);
-#if LV_MEM_CUSTOM == 0
-            debugPrintLvglMemory(level, _logOutput);
-#endif
+        if(debugSyslogProtocol == SYSLOG_PROTO_IETF) {
+            syslogOutput.print(F(" - - - \xEF\xBB\xBF")); // include UTF-8 BOM
+        } else {
+            syslogOutput.print(F(": "));
         }
+
+        debugPrintSyslogMemory();
         return;
     }
 #endif // HASP_USE_SYSLOG
@@ -608,8 +677,8 @@ void debugPrintPrefix(uint8_t tag, int level, Print* _logOutput)
 void debugPrintSuffix(uint8_t tag, int level, Print* _logOutput)
 {
 #if HASP_USE_SYSLOG > 0
-    if(_logOutput == syslogClient && syslogClient) {
-        syslogClient->endPacket();
+    if(_logOutput == &syslogOutput) {
+        syslogMessageEnd();
         return;
     }
 #endif
@@ -693,6 +762,20 @@ void debugLvglLogEvent(lv_log_level_t level, const char* file, uint32_t line, co
 
 void debugLoop(void)
 {
+#if LOG_DEFERRED_SLOTS > 0
+    // Setup has finished when the loop runs, from here on log calls only store their arguments
+    static bool deferred = false;
+    if(!deferred) {
+        Log.setDeferred(true);
+        deferred = true;
+    }
+    Log.drain(LOG_DEFERRED_BUDGET);
+#endif
+
+#if HASP_USE_SYSLOG > 0
+    syslogLoop();
+#endif
+
     int16_t keypress;
     do {
         switch(keypress = debugConsole.readKey()) {
@@ -751,9 +834,27 @@ void printLocalTime()
 
 void debugEverySecond()
 {
-    if(debugTelePeriod > 0 && (millis() - debugLastMillis) >= debugTelePeriod * 1000) {
-        dispatch_output_statusupdate(NULL, NULL);
-        debugLastMillis = millis();
+#if HASP_USE_SYSLOG > 0
+    static uint32_t syslog_last_dropped = 0;
+    syslog_stats_t syslog;
+    syslogGetStats(&syslog);
+    if(syslog.dropped != syslog_last_dropped) {
+        LOG_WARNING(TAG_SYSL, F("%u messages dropped, %u sent in %u datagrams, backlog %u/%u"),
+                    syslog.dropped - syslog_last_dropped, syslog.messages, syslog.datagrams, syslog.backlog,
+                    syslog.backlog_max);
+        syslog_last_dropped = syslog.dropped;
+    }
+#endif
+
+#if LOG_DEFERRED_SLOTS > 0
+    static uint32_t log_last_overflow = 0;
+    LogDeferredStats stats;
+    Log.getDeferredStats(&stats);
+    if(stats.overflow != log_last_overflow) {
+        LOG_WARNING(TAG_DEBG, F("Log ring: %u lines dropped, %u captured, depth %u/%u"),
+                    stats.overflow - log_last_overflow, stats.captured, stats.depth, stats.depth_max);
+        log_last_overflow = stats.overflow;
     }
+#endif
     // printLocalTime();
 }
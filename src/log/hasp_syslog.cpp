@@ -0,0 +1,251 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Batched syslog transport
+ * Log lines are collected into a datagram of up to SYSLOG_BATCH_SIZE bytes, one message per line.
+ * The datagram is sent when the next message does not fit or SYSLOG_FLUSH_MS after its first message.
+ * Datagrams that fail to send are kept in a backlog of SYSLOG_BACKLOG entries and retried, when the
+ * backlog is full the oldest datagram is dropped and its messages are counted as lost. */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "hasp_conf.h"
+
+#if HASP_USE_SYSLOG > 0
+
+#include "hasp_syslog.h"
+
+#if defined(ARDUINO)
+#include <WiFiUdp.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+struct syslog_datagram_t
+{
+    uint16_t len;      // bytes of complete messages
+    uint16_t messages; // number of complete messages
+};
+
+static char* syslogBuffer; // SYSLOG_BACKLOG + 1 datagrams, the last one is being filled
+static syslog_datagram_t syslogDatagram[SYSLOG_BACKLOG + 1];
+static uint8_t syslogQueued = 0; // full datagrams waiting in front of the one being filled
+static uint16_t syslogCursor;    // write position of the current message
+static bool syslogInMessage = false;
+static bool syslogOverflow  = false;
+static uint32_t syslogFirstMillis; // time of the first message in the current datagram
+static syslog_stats_t syslogStats;
+
+#if defined(ARDUINO)
+static WiFiUDP* syslogClient;
+static char syslogHost[32];
+static uint16_t syslogPort;
+#else
+static int syslogSocket = -1;
+static struct sockaddr_in syslogAddress;
+#endif
+
+static inline char* syslogSlot(uint8_t index)
+{
+    return syslogBuffer + index * SYSLOG_BATCH_SIZE;
+}
+
+/* ===== Transport ===== */
+
+static bool syslogSendDatagram(const char* data, size_t len)
+{
+#if defined(ARDUINO)
+    if(!syslogClient || !syslogClient->beginPacket(syslogHost, syslogPort)) return false;
+    syslogClient->write((const uint8_t*)data, len);
+    return syslogClient->endPacket();
+#else
+    return sendto(syslogSocket, data, len, 0, (struct sockaddr*)&syslogAddress, sizeof(syslogAddress)) == (ssize_t)len;
+#endif
+}
+
+// Send the queued datagrams in order, stop at the first failure
+static void syslogSendQueued()
+{
+    uint8_t sent = 0;
+    while(sent < syslogQueued) {
+        if(!syslogSendDatagram(syslogSlot(sent), syslogDatagram[sent].len)) break;
+        syslogStats.datagrams++;
+        sent++;
+    }
+    if(sent == 0) return;
+
+    // Shift the remaining datagrams and the one being filled to the front
+    uint8_t remaining = syslogQueued - sent + 1;
+    memmove(syslogBuffer, syslogSlot(sent), remaining * SYSLOG_BATCH_SIZE);
+    memmove(syslogDatagram, syslogDatagram + sent, remaining * sizeof(syslog_datagram_t));
+    syslogQueued -= sent;
+}
+
+// Close the datagram being filled and queue it, the message in progress moves to a new datagram
+static void syslogQueueCurrent()
+{
+    syslog_datagram_t* current = &syslogDatagram[syslogQueued];
+    if(current->messages == 0) return;
+
+    if(syslogQueued == SYSLOG_BACKLOG) {
+        // Backlog is full, drop the oldest datagram
+        syslogStats.dropped += syslogDatagram[0].messages;
+        memmove(syslogBuffer, syslogSlot(1), SYSLOG_BACKLOG * SYSLOG_BATCH_SIZE);
+        memmove(syslogDatagram, syslogDatagram + 1, SYSLOG_BACKLOG * sizeof(syslog_datagram_t));
+        syslogQueued--;
+        current = &syslogDatagram[syslogQueued];
+    }
+
+    char* from   = syslogSlot(syslogQueued) + current->len;
+    size_t carry = syslogInMessage ? syslogCursor - current->len : 0;
+
+    syslogQueued++;
+    if(syslogQueued > syslogStats.backlog_max) syslogStats.backlog_max = syslogQueued;
+
+    syslogDatagram[syslogQueued].len      = 0;
+    syslogDatagram[syslogQueued].messages = 0;
+    memmove(syslogSlot(syslogQueued), from, carry);
+    syslogCursor      = carry;
+    syslogFirstMillis = millis();
+
+    syslogSendQueued();
+}
+
+/* ===== Message Assembly ===== */
+
+void syslogMessageBegin()
+{
+    if(!syslogBuffer) return;
+    if(syslogInMessage) syslogMessageEnd();
+
+    if(syslogDatagram[syslogQueued].messages == 0) syslogFirstMillis = millis();
+    syslogCursor    = syslogDatagram[syslogQueued].len;
+    syslogInMessage = true;
+    syslogOverflow  = false;
+}
+
+size_t syslogWrite(const uint8_t* data, size_t len)
+{
+    if(!syslogBuffer || !syslogInMessage) return 0;
+
+    // Keep one byte for the line separator
+    if(syslogCursor + len >= SYSLOG_BATCH_SIZE) {
+        if(syslogDatagram[syslogQueued].messages > 0) syslogQueueCurrent();
+
+        if(syslogCursor + len >= SYSLOG_BATCH_SIZE) {
+            // A single message larger than a datagram
+            len            = SYSLOG_BATCH_SIZE - 1 - syslogCursor;
+            syslogOverflow = true;
+        }
+    }
+
+    memcpy(syslogSlot(syslogQueued) + syslogCursor, data, len);
+    syslogCursor += len;
+    return len;
+}
+
+void syslogMessageEnd()
+{
+    if(!syslogBuffer || !syslogInMessage) return;
+
+    syslogSlot(syslogQueued)[syslogCursor++] = '\n';
+    syslogDatagram[syslogQueued].len        = syslogCursor;
+    syslogDatagram[syslogQueued].messages++;
+    syslogInMessage = false;
+
+    syslogStats.messages++;
+    if(syslogOverflow) syslogStats.truncated++;
+
+    // Send right away when another short message would not fit anymore
+    if(syslogCursor > SYSLOG_BATCH_SIZE - 64) syslogQueueCurrent();
+}
+
+void syslogFlush()
+{
+    if(!syslogBuffer) return;
+    syslogQueueCurrent();
+    syslogSendQueued();
+}
+
+void syslogLoop()
+{
+    if(!syslogBuffer || syslogInMessage || millis() - syslogFirstMillis < SYSLOG_FLUSH_MS) return;
+
+    syslogFirstMillis = millis(); // also paces the retries of the backlog
+    syslogFlush();
+}
+
+/* ===== Service ===== */
+
+bool syslogStart(const char* host, uint16_t port)
+{
+    if(!syslogBuffer) {
+        syslogBuffer = (char*)malloc((SYSLOG_BACKLOG + 1) * SYSLOG_BATCH_SIZE);
+        if(!syslogBuffer) return false;
+        memset(syslogDatagram, 0, sizeof(syslogDatagram));
+        syslogQueued    = 0;
+        syslogCursor    = 0;
+        syslogInMessage = false;
+    }
+
+#if defined(ARDUINO)
+    strncpy(syslogHost, host, sizeof(syslogHost) - 1);
+    syslogPort = port;
+    if(!syslogClient) syslogClient = new WiFiUDP();
+    if(!syslogClient) return false;
+#else
+    struct addrinfo hints;
+    struct addrinfo* result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if(getaddrinfo(host, NULL, &hints, &result) != 0) return false;
+    memcpy(&syslogAddress, result->ai_addr, sizeof(syslogAddress));
+    syslogAddress.sin_port = htons(port);
+    freeaddrinfo(result);
+
+    if(syslogSocket < 0) syslogSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if(syslogSocket < 0) return false;
+#endif
+
+    syslogFirstMillis = millis();
+    return true;
+}
+
+void syslogStop()
+{
+    if(!syslogBuffer) return;
+    syslogFlush(); // last attempt, the backlog is lost if the network is gone
+
+    for(uint8_t i = 0; i < syslogQueued; i++) syslogStats.dropped += syslogDatagram[i].messages;
+    free(syslogBuffer);
+    syslogBuffer = NULL;
+
+#if defined(ARDUINO)
+    if(syslogClient) {
+        syslogClient->stop();
+        delete syslogClient;
+        syslogClient = NULL;
+    }
+#else
+    if(syslogSocket >= 0) close(syslogSocket);
+    syslogSocket = -1;
+#endif
+}
+
+bool syslogIsStarted()
+{
+    return syslogBuffer != NULL;
+}
+
+void syslogGetStats(syslog_stats_t* stats)
+{
+    *stats         = syslogStats;
+    stats->backlog = syslogQueued;
+}
+
+#endif // HASP_USE_SYSLOG
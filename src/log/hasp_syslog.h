@@ -0,0 +1,57 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_SYSLOG_H
+#define HASP_SYSLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hasp_conf.h"
+
+#if HASP_USE_SYSLOG > 0
+
+#ifndef SYSLOG_BATCH_SIZE
+#define SYSLOG_BATCH_SIZE 1400 // bytes per datagram, stay below the MTU
+#endif
+
+#ifndef SYSLOG_FLUSH_MS
+#define SYSLOG_FLUSH_MS 250 // maximum time a message waits in a partial datagram
+#endif
+
+#ifndef SYSLOG_BACKLOG
+#if defined(ARDUINO_ARCH_ESP8266)
+#define SYSLOG_BACKLOG 1 // full datagrams kept when sending fails
+#else
+#define SYSLOG_BACKLOG 4
+#endif
+#endif
+
+struct syslog_stats_t
+{
+    uint32_t messages;  // messages completed
+    uint32_t datagrams; // datagrams sent
+    uint32_t dropped;   // messages lost because the backlog was full
+    uint32_t truncated; // messages cut off at SYSLOG_BATCH_SIZE
+    uint8_t backlog;    // full datagrams waiting to be sent
+    uint8_t backlog_max;
+};
+
+/* ===== Default Event Processors ===== */
+bool syslogStart(const char* host, uint16_t port);
+void syslogStop(void);
+void syslogLoop(void);
+
+/* ===== Special Event Processors ===== */
+void syslogMessageBegin(void);
+size_t syslogWrite(const uint8_t* data, size_t len);
+void syslogMessageEnd(void);
+void syslogFlush(void);
+
+/* ===== Getter and Setter Functions ===== */
+bool syslogIsStarted(void);
+void syslogGetStats(syslog_stats_t* stats);
+
+#endif // HASP_USE_SYSLOG
+
+#endif
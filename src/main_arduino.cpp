@@ -1,7 +1,7 @@
 /* MIT License - Copyright (c) 2019-2021 Francis Van Roie
    For full license information read the LICENSE file in the project folder */
 
-#ifndef WINDOWS
+#if !defined(WINDOWS) && !defined(POSIX)
 
 #include <Arduino.h>
 #include "lvgl.h"
@@ -22,12 +22,44 @@
 #include "hasp/hasp.h"
 
 #include "sys/net/hasp_network.h"
+#include "sys/hasp_profiler.h"
+#include "sys/hasp_scheduler.h"
 
 #include "dev/device.h"
 
 bool isConnected;
-uint8_t mainLoopCounter        = 0;
-unsigned long mainLastLoopTime = 0;
+
+/* Runs Every Second */
+static void mainEverySecond()
+{
+    haspEverySecond();  // sleep timer
+    debugEverySecond(); // statusupdate
+}
+
+/* Runs Every 5 Seconds */
+static void mainEvery5Seconds()
+{
+    isConnected = networkEvery5Seconds(); // Check connection
+
+#if HASP_USE_HTTP > 0
+    // httpEvery5Seconds();
+#endif
+
+#if HASP_USE_MQTT > 0
+    mqttEvery5Seconds(isConnected);
+#endif
+
+#if HASP_USE_GPIO > 0
+    //   gpioEvery5Seconds();
+#endif
+
+    haspDevice.loop_5s();
+}
+
+static void mainTelePeriod()
+{
+    dispatch_output_statusupdate(NULL, NULL);
+}
 
 void setup()
 {
@@ -104,64 +136,43 @@ void setup()
     slaveSetup();
 #endif
 
-    mainLastLoopTime = millis() - 1000; // reset loop counter
+    /* Timers, the main loop sleeps until the next one is due */
+    uint32_t teleperiod = dispatch_get_teleperiod() * 1000;
+    schedulerAdd(1000, mainEverySecond, 0);
+    schedulerAdd(5000, mainEvery5Seconds, 0);
+    schedulerAdd(teleperiod, mainTelePeriod, teleperiod); // paused when 0
+
     delay(250);
     // guiStart();
 }
 
 void loop()
 {
+    PROFILER_START();
     guiLoop();
-    haspLoop();
+    PROFILER_LAP(PROFILER_GUI);
+    uint32_t guiNext = haspLoop();
+    PROFILER_LAP(PROFILER_HASP);
     networkLoop();
+    PROFILER_LAP(PROFILER_NETWORK);
 
 #if HASP_USE_MQTT > 0
     mqttLoop();
+    PROFILER_LAP(PROFILER_MQTT);
 #endif // MQTT
 
     debugLoop(); // Console
+    PROFILER_LAP(PROFILER_DEBUG);
     haspDevice.loop();
+    PROFILER_LAP(PROFILER_DEVICE);
 
     /* Timer Loop */
-    if(millis() - mainLastLoopTime >= 1000) {
-
-        /* Runs Every Second */
-        haspEverySecond();  // sleep timer
-        debugEverySecond(); // statusupdate
-
-        /* Runs Every 5 Seconds */
-        if(mainLoopCounter == 0 || mainLoopCounter == 5) {
-            isConnected = networkEvery5Seconds(); // Check connection
-
-#if HASP_USE_HTTP > 0
-            // httpEvery5Seconds();
-#endif
-
-#if HASP_USE_MQTT > 0
-            mqttEvery5Seconds(isConnected);
-#endif
-
-#if HASP_USE_GPIO > 0
-            //   gpioEvery5Seconds();
-#endif
-
-            haspDevice.loop_5s();
-        }
-
-        /* Reset loop counter every 10 seconds */
-        if(mainLoopCounter >= 9) {
-            mainLoopCounter = 0;
-        } else {
-            mainLoopCounter++;
-        }
-        mainLastLoopTime += 1000;
+    if(schedulerLoop() > 0) {
+        PROFILER_LAP(PROFILER_TIMERS);
     }
+    PROFILER_END();
 
-#ifdef ARDUINO_ARCH_ESP8266
-    delay(2);
-#else
-    delay(6);
-#endif
+    schedulerSleep(guiNext); // until the next gui task or timer
 }
 
 #endif
\ No newline at end of file
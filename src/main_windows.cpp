@@ -20,12 +20,35 @@
 #include "hasp/hasp.h"
 
 #include "dev/device.h"
+#include "sys/hasp_scheduler.h"
 
 bool isConnected;
 bool isRunning = 1;
 
-uint8_t mainLoopCounter        = 0;
-unsigned long mainLastLoopTime = 0;
+/* Runs Every Second */
+static void mainEverySecond()
+{
+    haspEverySecond(); // sleep timer
+
+#if HASP_USE_OTA > 0
+    otaEverySecond(); // progressbar
+#endif
+}
+
+/* Runs Every 5 Seconds */
+static void mainEvery5Seconds()
+{
+    haspDevice.loop_5s();
+
+#if HASP_USE_MQTT > 0
+    mqttEvery5Seconds(true);
+#endif
+}
+
+static void mainTelePeriod()
+{
+    dispatch_output_statusupdate(NULL, NULL);
+}
 
 // https://gist.github.com/kingseva/a918ec66079a9475f19642ec31276a21
 void BindStdHandlesToConsole()
@@ -119,45 +142,27 @@ void setup()
     mqttStart();
 #endif
 
-    mainLastLoopTime = millis() - 1000; // reset loop counter
+    /* Timers, the main loop sleeps until the next one is due */
+    uint32_t teleperiod = dispatch_get_teleperiod() * 1000;
+    schedulerAdd(1000, mainEverySecond, 0);
+    schedulerAdd(5000, mainEvery5Seconds, 0);
+    schedulerAdd(teleperiod, mainTelePeriod, teleperiod); // paused when 0
+
     delay(250);
 }
 
 void loop()
 {
-    haspLoop();
-    mqttLoop();
+    uint32_t guiNext = haspLoop();
 
     //    debugLoop(); // Console
     haspDevice.loop();
     guiLoop();
+    mqttLoop(); // the queued commands run after the gui has rendered
 
     /* Timer Loop */
-    if(millis() - mainLastLoopTime >= 1000) {
-        /* Runs Every Second */
-        haspEverySecond();     // sleep timer
-        dispatchEverySecond(); // sleep timer
-
-#if HASP_USE_OTA > 0
-        otaEverySecond(); // progressbar
-#endif
-
-        /* Runs Every 5 Seconds */
-        if(mainLoopCounter == 0 || mainLoopCounter == 5) {
-
-            haspDevice.loop_5s();
-        }
-
-        /* Reset loop counter every 10 seconds */
-        if(mainLoopCounter >= 9) {
-            mainLoopCounter = 0;
-        } else {
-            mainLoopCounter++;
-        }
-        mainLastLoopTime += 1000;
-    }
-
-    // delay(6);
+    schedulerLoop();
+    schedulerSleep(guiNext); // until the next gui task or timer
 }
 
 #ifdef WINDOWS
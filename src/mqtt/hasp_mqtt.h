@@ -25,6 +25,80 @@ void mqtt_send_state(const __FlashStringHelper* subtopic, const char* payload);
 bool mqttPublish(const char* topic, const char* payload, size_t len, bool retain);
 
 bool mqttIsConnected();
+bool mqttSubscribe(const char* topic);
+bool mqttUnsubscribe(const char* topic);
+
+/* ===== Topic Bindings ===== */
+#ifndef MQTT_BIND_TOPIC_SIZE
+#define MQTT_BIND_TOPIC_SIZE 128 // longest bound topic
+#endif
+
+#ifndef MQTT_BIND_VALUE_SIZE
+#define MQTT_BIND_VALUE_SIZE 64 // longest value after formatting
+#endif
+
+#ifndef MQTT_BIND_JSON_SIZE
+#define MQTT_BIND_JSON_SIZE 1024 // memory to parse a bound payload with a json path
+#endif
+
+uint8_t mqtt_bind_add(uint8_t pageid, uint8_t objid, const char* spec);
+uint8_t mqtt_bind_remove(uint8_t pageid, uint8_t objid);
+bool mqtt_bind_message(const char* topic, const char* payload);
+void mqtt_bind_subscribe_all();
+uint8_t mqtt_bind_count(uint8_t pageid, uint8_t objid);
+
+#if HASP_USE_MQTT_ASYNC > 0
+struct mqtt_inbound_stats_t
+{
+    uint32_t received;    // messages received on the mqtt thread
+    uint32_t dropped;     // messages dropped because the queue was full
+    uint32_t executed;    // messages executed by the main loop
+    uint16_t depth;       // messages waiting in the queue
+    uint16_t depth_max;   // peak number of messages waiting
+    uint32_t latency_avg; // ms between receiving and executing a message
+    uint32_t latency_max;
+};
+
+void mqtt_get_inbound_stats(mqtt_inbound_stats_t* stats);
+#endif
+
+#ifdef USE_PUBSUBCLIENT
+#ifndef MQTT_JOURNAL_SIZE
+#if defined(ARDUINO_ARCH_ESP32)
+#define MQTT_JOURNAL_SIZE 4096 // bytes of RAM for messages published while disconnected
+#else
+#define MQTT_JOURNAL_SIZE 1024
+#endif
+#endif
+
+#ifndef MQTT_JOURNAL_SPILL_SIZE
+#define MQTT_JOURNAL_SPILL_SIZE 16384 // bytes on the filesystem once the RAM journal is full
+#endif
+
+#ifndef MQTT_JOURNAL_REPLAY_MS
+#define MQTT_JOURNAL_REPLAY_MS 50 // pace of the replay after reconnecting
+#endif
+
+#ifndef MQTT_JOURNAL_REPLAY_BURST
+#define MQTT_JOURNAL_REPLAY_BURST 4 // messages replayed per MQTT_JOURNAL_REPLAY_MS
+#endif
+
+struct mqtt_journal_stats_t
+{
+    uint32_t journaled;    // messages stored while disconnected
+    uint32_t deduplicated; // states replaced by a newer value of the same topic
+    uint32_t replayed;     // messages published after reconnecting
+    uint32_t spilled;      // messages moved from RAM to the filesystem
+    uint32_t dropped;      // messages lost because the journal was full
+    uint16_t depth;        // messages waiting in RAM
+    uint16_t depth_max;
+};
+
+bool mqtt_journal_append(const char* topic, const char* payload);
+bool mqtt_journal_is_empty();
+void mqtt_journal_replay();
+void mqtt_get_journal_stats(mqtt_journal_stats_t* stats);
+#endif
 
 #if HASP_USE_CONFIG > 0
 bool mqttGetConfig(const JsonObject& settings);
@@ -0,0 +1,469 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Topic bindings
+ * An object attribute can follow any MQTT topic, declared in the page config with the bind attribute:
+ *
+ *  {"page":1,"id":2,"obj":"label","bind":{"topic":"sensors/kitchen","path":"temp","attr":"text","format":"%.1f °C"}}
+ *
+ * The topics are kept in a trie with one node per topic level, an inbound message walks the trie once
+ * and updates every object bound to it, + and # wildcards are supported. The JSON path is optional,
+ * without it the whole payload is the value. The format is checked and rewritten once when the binding
+ * is added, so applying it is a single snprintf. */
+
+#include "hasp_conf.h"
+
+#if HASP_USE_MQTT > 0
+
+#include "hasp_mqtt.h"
+#include "hasp_debug.h"
+
+#include "hasp/hasp_object.h"
+#include "hasp/hasp_attribute.h"
+
+enum mqtt_bind_format_t : uint8_t { MQTT_BIND_RAW, MQTT_BIND_INT, MQTT_BIND_FLOAT, MQTT_BIND_STRING };
+
+struct mqtt_bind_t
+{
+    mqtt_bind_t* next; // next binding of the same topic
+    uint8_t pageid;
+    uint8_t objid;
+    uint8_t type; // mqtt_bind_format_t of the format
+    const char* attr;
+    const char* path;   // NULL uses the whole payload
+    const char* format; // NULL uses the value as is
+    // followed by attr\0 path\0 format\0
+};
+
+struct mqtt_bind_node_t
+{
+    mqtt_bind_node_t* child;
+    mqtt_bind_node_t* sibling;
+    mqtt_bind_t* binds;
+    uint8_t len;
+    // followed by the topic level, not terminated
+};
+
+static mqtt_bind_node_t bind_root;
+static uint16_t bind_count = 0;
+
+static inline const char* bind_level(const mqtt_bind_node_t* node)
+{
+    return (const char*)(node + 1);
+}
+
+static inline bool bind_level_is(const mqtt_bind_node_t* node, const char* level, size_t len)
+{
+    return node->len == len && !memcmp(bind_level(node), level, len);
+}
+
+// Length of the topic level at the start of topic
+static inline size_t bind_level_len(const char* topic)
+{
+    const char* slash = strchr(topic, '/');
+    return slash ? slash - topic : strlen(topic);
+}
+
+/* ===== Format Template ===== */
+
+/**
+ * Check a printf format with a single conversion and rewrite it for the argument type it will receive
+ * @param format char*: the format from the page config, e.g. "%.1f °C"
+ * @param buffer char*: receives the rewritten format, integer conversions get the l length modifier
+ * @param size size_t: size of the buffer
+ * @return the mqtt_bind_format_t, MQTT_BIND_RAW when the format is invalid
+ */
+static uint8_t bind_compile_format(const char* format, char* buffer, size_t size)
+{
+    uint8_t type = MQTT_BIND_RAW;
+    size_t len   = 0;
+
+    for(const char* p = format; *p; p++) {
+        if(len + 3 >= size) return MQTT_BIND_RAW;
+        buffer[len++] = *p;
+        if(*p != '%') continue;
+
+        if(p[1] == '%') { // literal %
+            buffer[len++] = *++p;
+            continue;
+        }
+        if(type != MQTT_BIND_RAW) return MQTT_BIND_RAW; // only one value per format
+
+        p++;
+        while(*p && strchr("-+ #0123456789.", *p)) {
+            if(len + 3 >= size) return MQTT_BIND_RAW;
+            buffer[len++] = *p++;
+        }
+
+        if(*p && strchr("dioxXu", *p)) {
+            type          = MQTT_BIND_INT;
+            buffer[len++] = 'l';
+        } else if(*p && strchr("feEgG", *p)) {
+            type = MQTT_BIND_FLOAT;
+        } else if(*p == 's') {
+            type = MQTT_BIND_STRING;
+        } else {
+            return MQTT_BIND_RAW; // length modifiers and other conversions are not allowed
+        }
+        buffer[len++] = *p;
+    }
+
+    buffer[len] = 0;
+    return type;
+}
+
+static void bind_format_value(const mqtt_bind_t* bind, const char* value, char* buffer, size_t size)
+{
+    switch(bind->type) {
+        case MQTT_BIND_INT: {
+            double number = strtod(value, NULL);
+            snprintf(buffer, size, bind->format, (long)(number < 0 ? number - 0.5 : number + 0.5));
+            break;
+        }
+        case MQTT_BIND_FLOAT:
+            snprintf(buffer, size, bind->format, strtod(value, NULL));
+            break;
+        case MQTT_BIND_STRING:
+            snprintf(buffer, size, bind->format, value);
+            break;
+        default:
+            strncpy(buffer, value, size - 1);
+            buffer[size - 1] = 0;
+    }
+}
+
+/* ===== Value Extraction ===== */
+
+// Follow a dot separated path of keys and array indexes, e.g. sensors.0.temp
+static JsonVariant bind_resolve_path(JsonVariant value, const char* path)
+{
+    char key[32];
+
+    while(*path && !value.isNull()) {
+        size_t len = strcspn(path, ".");
+        if(len >= sizeof(key)) return JsonVariant();
+        memcpy(key, path, len);
+        key[len] = 0;
+
+        if(value.is<JsonArray>() && isdigit(key[0])) {
+            value = value[atoi(key)];
+        } else {
+            value = value[(const char*)key];
+        }
+
+        path += len;
+        if(*path == '.') path++;
+    }
+    return value;
+}
+
+static bool bind_get_value(const mqtt_bind_t* bind, const char* payload, DynamicJsonDocument*& doc, char* buffer,
+                           size_t size)
+{
+    if(!bind->path) {
+        strncpy(buffer, payload, size - 1);
+        buffer[size - 1] = 0;
+        return true;
+    }
+
+    if(!doc) { // parse the payload only once for all bindings of the topic
+        doc = new DynamicJsonDocument(MQTT_BIND_JSON_SIZE);
+        if(deserializeJson(*doc, payload)) LOG_WARNING(TAG_MQTT, F("Binding payload is not valid json"));
+    }
+
+    JsonVariant value = bind_resolve_path(doc->as<JsonVariant>(), bind->path);
+    if(value.isNull()) {
+        LOG_VERBOSE(TAG_MQTT, F("Binding path %s not found"), bind->path);
+        return false;
+    }
+
+    if(value.is<const char*>()) {
+        strncpy(buffer, value.as<const char*>(), size - 1);
+        buffer[size - 1] = 0;
+    } else {
+        serializeJson(value, buffer, size);
+    }
+    return true;
+}
+
+static void bind_apply(mqtt_bind_node_t* node, const char* payload, DynamicJsonDocument*& doc)
+{
+    char value[MQTT_BIND_VALUE_SIZE];
+    char text[MQTT_BIND_VALUE_SIZE];
+
+    for(mqtt_bind_t* bind = node->binds; bind; bind = bind->next) {
+        lv_obj_t* obj = hasp_find_obj_from_page_id(bind->pageid, bind->objid);
+        if(!obj) continue; // the page is not loaded
+
+        if(!bind_get_value(bind, payload, doc, value, sizeof(value))) continue;
+        bind_format_value(bind, value, text, sizeof(text));
+        hasp_process_obj_attribute(obj, bind->attr, text, true);
+    }
+}
+
+/* ===== Topic Trie ===== */
+
+static mqtt_bind_node_t* bind_find_child(mqtt_bind_node_t* node, const char* level, size_t len)
+{
+    for(mqtt_bind_node_t* child = node->child; child; child = child->sibling) {
+        if(bind_level_is(child, level, len)) return child;
+    }
+    return NULL;
+}
+
+static mqtt_bind_node_t* bind_add_child(mqtt_bind_node_t* node, const char* level, size_t len)
+{
+    mqtt_bind_node_t* child = (mqtt_bind_node_t*)calloc(1, sizeof(mqtt_bind_node_t) + len);
+    if(!child) return NULL;
+
+    memcpy(child + 1, level, len);
+    child->len     = len;
+    child->sibling = node->child;
+    node->child    = child;
+    return child;
+}
+
+// Walk the remaining topic levels, applying the bindings of every matching node
+static uint8_t bind_match(mqtt_bind_node_t* node, const char* topic, const char* payload, DynamicJsonDocument*& doc)
+{
+    uint8_t matches  = 0;
+    size_t len       = bind_level_len(topic);
+    const char* rest = topic[len] == '/' ? topic + len + 1 : NULL;
+
+    for(mqtt_bind_node_t* child = node->child; child; child = child->sibling) {
+        if(bind_level_is(child, "#", 1)) {
+            bind_apply(child, payload, doc); // matches all remaining levels
+            matches++;
+        } else if(bind_level_is(child, topic, len) || bind_level_is(child, "+", 1)) {
+            if(rest) {
+                matches += bind_match(child, rest, payload, doc);
+                continue;
+            }
+            if(child->binds) {
+                bind_apply(child, payload, doc);
+                matches++;
+            }
+            if(mqtt_bind_node_t* hash = bind_find_child(child, "#", 1)) {
+                bind_apply(hash, payload, doc);
+                matches++;
+            }
+        }
+    }
+    return matches;
+}
+
+static void bind_subscribe_node(mqtt_bind_node_t* node, char* topic, size_t len)
+{
+    for(mqtt_bind_node_t* child = node->child; child; child = child->sibling) {
+        size_t sublen = len + (len ? 1 : 0) + child->len;
+        if(sublen >= MQTT_BIND_TOPIC_SIZE) continue;
+
+        if(len) topic[len] = '/';
+        memcpy(topic + sublen - child->len, bind_level(child), child->len);
+        topic[sublen] = 0;
+
+        if(child->binds) mqttSubscribe(topic);
+        bind_subscribe_node(child, topic, sublen);
+    }
+}
+
+/**
+ * Remove the bindings of an object from a branch of the trie
+ * Topics that lose their last binding are unsubscribed and the levels left without bindings or children are freed.
+ * @param node mqtt_bind_node_t*: the branch to search
+ * @param topic char*: buffer of MQTT_BIND_TOPIC_SIZE holding the topic of the node
+ * @param len size_t: length of the topic of the node
+ * @param attr char*: only remove the binding of this attribute, NULL removes all of them
+ * @return the number of bindings removed
+ */
+static uint8_t bind_remove_node(mqtt_bind_node_t* node, char* topic, size_t len, uint8_t pageid, uint8_t objid,
+                                const char* attr)
+{
+    uint8_t removed = 0;
+
+    mqtt_bind_t** link = &node->binds;
+    while(mqtt_bind_t* bind = *link) {
+        if(bind->pageid == pageid && bind->objid == objid && (!attr || !strcasecmp(bind->attr, attr))) {
+            *link = bind->next;
+            free(bind);
+            removed++;
+        } else {
+            link = &bind->next;
+        }
+    }
+    if(removed && !node->binds && len && mqttIsConnected()) mqttUnsubscribe(topic);
+
+    mqtt_bind_node_t** child_link = &node->child;
+    while(mqtt_bind_node_t* child = *child_link) {
+        size_t sublen = len + (len ? 1 : 0) + child->len;
+        if(sublen < MQTT_BIND_TOPIC_SIZE) {
+            if(len) topic[len] = '/';
+            memcpy(topic + sublen - child->len, bind_level(child), child->len);
+            topic[sublen] = 0;
+            removed += bind_remove_node(child, topic, sublen, pageid, objid, attr);
+            topic[len] = 0;
+        }
+
+        if(!child->binds && !child->child) {
+            *child_link = child->sibling; // nothing is left on this level
+            free(child);
+        } else {
+            child_link = &child->sibling;
+        }
+    }
+    return removed;
+}
+
+// Remove bindings of an object from the whole trie, returns the number removed
+static uint8_t bind_remove(uint8_t pageid, uint8_t objid, const char* attr)
+{
+    char topic[MQTT_BIND_TOPIC_SIZE];
+    topic[0]        = 0;
+    uint8_t removed = bind_remove_node(&bind_root, topic, 0, pageid, objid, attr);
+    bind_count -= removed;
+    return removed;
+}
+
+static uint8_t bind_count_node(mqtt_bind_node_t* node, uint8_t pageid, uint8_t objid)
+{
+    uint8_t count = 0;
+    for(mqtt_bind_t* bind = node->binds; bind; bind = bind->next) {
+        if(bind->pageid == pageid && bind->objid == objid) count++;
+    }
+    for(mqtt_bind_node_t* child = node->child; child; child = child->sibling) {
+        count += bind_count_node(child, pageid, objid);
+    }
+    return count;
+}
+
+static bool bind_add_one(uint8_t pageid, uint8_t objid, JsonObjectConst spec)
+{
+    const char* topic  = spec["topic"];
+    const char* attr   = spec["attr"] | "text";
+    const char* path   = spec["path"];
+    const char* format = spec["format"];
+
+    if(!topic || !*topic || strlen(topic) >= MQTT_BIND_TOPIC_SIZE) {
+        LOG_WARNING(TAG_MQTT, F("Binding " HASP_OBJECT_NOTATION " has no valid topic"), pageid, objid);
+        return false;
+    }
+
+    char compiled[MQTT_BIND_VALUE_SIZE];
+    uint8_t type = MQTT_BIND_RAW;
+    if(format && *format) {
+        type = bind_compile_format(format, compiled, sizeof(compiled));
+        if(type == MQTT_BIND_RAW) {
+            LOG_WARNING(TAG_MQTT, F("Binding " HASP_OBJECT_NOTATION " has an invalid format %s"), pageid, objid,
+                        format);
+            return false;
+        }
+    }
+    if(path && !*path) path = NULL;
+
+    size_t attr_len   = strlen(attr) + 1;
+    size_t path_len   = path ? strlen(path) + 1 : 0;
+    size_t format_len = type != MQTT_BIND_RAW ? strlen(compiled) + 1 : 0;
+
+    mqtt_bind_t* bind = (mqtt_bind_t*)malloc(sizeof(mqtt_bind_t) + attr_len + path_len + format_len);
+    if(!bind) {
+        LOG_ERROR(TAG_MQTT, F(D_ERROR_OUT_OF_MEMORY));
+        return false;
+    }
+
+    char* strings = (char*)(bind + 1);
+    bind->pageid  = pageid;
+    bind->objid   = objid;
+    bind->type    = type;
+    bind->attr    = (const char*)memcpy(strings, attr, attr_len);
+    bind->path    = path ? (const char*)memcpy(strings + attr_len, path, path_len) : NULL;
+    bind->format  = format_len ? (const char*)memcpy(strings + attr_len + path_len, compiled, format_len) : NULL;
+
+    // Find or grow the branch of the topic
+    mqtt_bind_node_t* node = &bind_root;
+    for(const char* level = topic; node;) {
+        size_t len              = bind_level_len(level);
+        mqtt_bind_node_t* child = bind_find_child(node, level, len);
+        node                    = child ? child : bind_add_child(node, level, len);
+        if(!level[len]) break;
+        level += len + 1;
+    }
+    if(!node) {
+        free(bind);
+        LOG_ERROR(TAG_MQTT, F(D_ERROR_OUT_OF_MEMORY));
+        return false;
+    }
+
+    bool subscribe = !node->binds;
+    bind->next     = node->binds;
+    node->binds    = bind;
+    bind_count++;
+
+    if(subscribe && mqttIsConnected()) mqttSubscribe(topic);
+    LOG_VERBOSE(TAG_MQTT, F("Bound " HASP_OBJECT_NOTATION ".%s to %s"), pageid, objid, attr, topic);
+    return true;
+}
+
+/* ===== Special Event Processors ===== */
+
+/**
+ * Bind attributes of an object to MQTT topics, replacing earlier bindings of the same attributes
+ * @param pageid uint8_t: the page of the object
+ * @param objid uint8_t: the id of the object
+ * @param spec char*: a json binding object, or an array of them
+ * @return the number of bindings added
+ */
+uint8_t mqtt_bind_add(uint8_t pageid, uint8_t objid, const char* spec)
+{
+    DynamicJsonDocument doc(256 + strlen(spec) * 2);
+    if(deserializeJson(doc, spec)) {
+        LOG_WARNING(TAG_MQTT, F("Binding " HASP_OBJECT_NOTATION " is not valid json"), pageid, objid);
+        return 0;
+    }
+
+    uint8_t added = 0;
+    if(doc.is<JsonArray>()) {
+        for(JsonObjectConst item : doc.as<JsonArrayConst>()) {
+            bind_remove(pageid, objid, item["attr"] | "text");
+            added += bind_add_one(pageid, objid, item);
+        }
+    } else if(doc.is<JsonObject>()) {
+        bind_remove(pageid, objid, doc["attr"] | "text");
+        added += bind_add_one(pageid, objid, doc.as<JsonObjectConst>());
+    }
+    return added;
+}
+
+// Remove all bindings of an object, returns the number removed
+uint8_t mqtt_bind_remove(uint8_t pageid, uint8_t objid)
+{
+    if(bind_count == 0) return 0;
+
+    return bind_remove(pageid, objid, NULL);
+}
+
+// Apply an inbound message to the bound objects, returns false when no binding matches the topic
+bool mqtt_bind_message(const char* topic, const char* payload)
+{
+    if(bind_count == 0) return false;
+
+    DynamicJsonDocument* doc = NULL; // created by the first binding with a path
+    uint8_t matches          = bind_match(&bind_root, topic, payload, doc);
+    delete doc;
+    return matches > 0;
+}
+
+// Subscribe to every bound topic, called after (re)connecting
+void mqtt_bind_subscribe_all()
+{
+    char topic[MQTT_BIND_TOPIC_SIZE];
+    bind_subscribe_node(&bind_root, topic, 0);
+}
+
+/* ===== Getter and Setter Functions ===== */
+
+uint8_t mqtt_bind_count(uint8_t pageid, uint8_t objid)
+{
+    return bind_count ? bind_count_node(&bind_root, pageid, objid) : 0;
+}
+
+#endif // HASP_USE_MQTT
@@ -0,0 +1,352 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Outbound journal
+ * State and event messages published while the broker is unreachable are kept in a fixed-size ring
+ * and replayed in order once the connection is back. A newer state message replaces the pending one
+ * of the same topic and attribute, events are all kept and get their original timestamp on replay.
+ * When the ring is full the oldest records spill to the filesystem, if there is one. */
+
+#include <time.h>
+
+#include "hasp_conf.h"
+
+#if HASP_USE_MQTT > 0
+#ifdef USE_PUBSUBCLIENT
+
+#include "hasp_mqtt.h"
+#include "hasp_debug.h"
+
+#if defined(ARDUINO) && (HASP_USE_SPIFFS > 0 || HASP_USE_LITTLEFS > 0)
+#define MQTT_JOURNAL_SPILL 1
+#define MQTT_JOURNAL_SPILL_FILE "/journal.bin"
+#else
+#define MQTT_JOURNAL_SPILL 0
+#endif
+
+#define MQTT_JOURNAL_EVENT 0x01 // record is an event, never deduplicated
+#define MQTT_JOURNAL_DEAD 0x02  // record was replaced by a newer state
+
+struct mqtt_journal_record_t
+{
+    uint16_t size; // total record size including this header
+    uint8_t flags;
+    uint8_t topic_len;
+    uint16_t key_len;  // length of the payload prefix identifying the attribute
+    uint16_t reserved;
+    uint32_t millis;   // uptime at the time of publishing
+    uint32_t epoch;    // wall clock at the time of publishing, 0 if not synchronized
+    // followed by topic\0 payload\0
+};
+
+static uint8_t journal_buf[MQTT_JOURNAL_SIZE] __attribute__((aligned(4)));
+static uint16_t journal_head  = 0; // oldest record
+static uint16_t journal_tail  = 0; // next free byte
+static uint16_t journal_wrap  = MQTT_JOURNAL_SIZE; // end of the data at the head once the tail has wrapped
+static uint16_t journal_used  = 0; // bytes in use, including the unused gap before a wrap
+static uint16_t journal_count = 0; // live records in the ring
+static uint32_t journal_last_replay;
+static mqtt_journal_stats_t journal_stats;
+
+#if MQTT_JOURNAL_SPILL > 0
+static uint32_t journal_spill_read    = 0; // offset of the next spilled record to replay
+static uint16_t journal_spill_pending = 0; // spilled records not replayed yet
+#endif
+
+static inline mqtt_journal_record_t* journal_record(uint16_t offset)
+{
+    return (mqtt_journal_record_t*)(journal_buf + offset);
+}
+
+static inline const char* journal_topic(mqtt_journal_record_t* record)
+{
+    return (const char*)(record + 1);
+}
+
+static inline const char* journal_payload(mqtt_journal_record_t* record)
+{
+    return journal_topic(record) + record->topic_len + 1;
+}
+
+// The attribute of a JSON state payload is everything up to the first colon, e.g. {"val":
+static uint16_t journal_key_len(const char* payload)
+{
+    if(payload[0] != '{') return 0;
+    const char* colon = strchr(payload, ':');
+    return colon ? colon - payload + 1 : 0;
+}
+
+static inline bool journal_is_event(const char* payload)
+{
+    return !strncmp_P(payload, PSTR("{\"event\":"), 9);
+}
+
+static uint32_t journal_epoch()
+{
+    time_t now = time(NULL);
+    return now > 1577836800 ? (uint32_t)now : 0; // only trust a clock set after 2020
+}
+
+// The tail has wrapped around to the start while older records remain at the end
+static inline bool journal_is_wrapped()
+{
+    return journal_used > 0 && journal_tail <= journal_head;
+}
+
+static inline uint16_t journal_next(uint16_t offset)
+{
+    offset += journal_record(offset)->size;
+    return journal_is_wrapped() && offset >= journal_wrap ? 0 : offset;
+}
+
+/* ===== Ring Operations ===== */
+
+static void journal_pop()
+{
+    mqtt_journal_record_t* record = journal_record(journal_head);
+    if(!(record->flags & MQTT_JOURNAL_DEAD)) journal_count--;
+    journal_used -= record->size;
+
+    uint16_t next = journal_head + record->size;
+    if(next >= journal_wrap) {
+        journal_used -= MQTT_JOURNAL_SIZE - journal_wrap;
+        journal_wrap = MQTT_JOURNAL_SIZE;
+        next         = 0;
+    }
+    journal_head = next;
+
+    if(journal_used == 0) {
+        journal_head = journal_tail = 0;
+        journal_wrap                = MQTT_JOURNAL_SIZE;
+    }
+}
+
+// Drop dead records at the head so the ring always starts with a live record
+static void journal_trim()
+{
+    while(journal_used > 0 && (journal_record(journal_head)->flags & MQTT_JOURNAL_DEAD)) journal_pop();
+}
+
+#if MQTT_JOURNAL_SPILL > 0
+static bool journal_spill(mqtt_journal_record_t* record)
+{
+    // Start a new file when nothing is pending, a leftover from a previous boot is stale
+    File file = HASP_FS.open(MQTT_JOURNAL_SPILL_FILE, journal_spill_pending ? "a" : "w");
+    if(!file) return false;
+
+    bool res = file.size() + record->size <= MQTT_JOURNAL_SPILL_SIZE &&
+               file.write((const uint8_t*)record, record->size) == record->size;
+    file.close();
+
+    if(res) {
+        journal_spill_pending++;
+        journal_stats.spilled++;
+    }
+    return res;
+}
+#endif
+
+// Make room for the oldest record to go, either to the filesystem or lost
+static void journal_evict()
+{
+    mqtt_journal_record_t* record = journal_record(journal_head);
+
+#if MQTT_JOURNAL_SPILL > 0
+    if(!journal_spill(record))
+#endif
+        journal_stats.dropped++;
+
+    journal_pop();
+    journal_trim();
+}
+
+// Returns the offset of a contiguous free block of size bytes, evicting old records as needed
+static uint16_t journal_reserve(uint16_t size)
+{
+    while(true) {
+        if(journal_used == 0) {
+            journal_head = journal_tail = 0;
+            return 0;
+        }
+
+        if(!journal_is_wrapped()) {
+            // Data runs from head to tail, free space at the end and before the head
+            if(MQTT_JOURNAL_SIZE - journal_tail >= size) return journal_tail;
+            if(journal_head >= size) {
+                journal_used += MQTT_JOURNAL_SIZE - journal_tail; // skip the gap at the end
+                journal_wrap = journal_tail;
+                journal_tail = 0;
+                return 0;
+            }
+        } else if(journal_head - journal_tail >= size) {
+            // Data runs from head to the wrap and from the start to tail, free space in between
+            return journal_tail;
+        }
+
+        journal_evict();
+    }
+}
+
+static void journal_remove_state(const char* topic, const char* payload, uint16_t key_len)
+{
+    if(journal_used == 0) return;
+
+    uint16_t offset = journal_head;
+    do {
+        mqtt_journal_record_t* record = journal_record(offset);
+        if(!(record->flags & (MQTT_JOURNAL_EVENT | MQTT_JOURNAL_DEAD)) && record->key_len == key_len &&
+           !strcmp(journal_topic(record), topic) && !strncmp(journal_payload(record), payload, key_len)) {
+            record->flags |= MQTT_JOURNAL_DEAD;
+            journal_count--;
+            journal_stats.deduplicated++;
+            break; // there is never more than one live state per key
+        }
+        offset = journal_next(offset);
+    } while(offset != journal_tail);
+
+    journal_trim();
+}
+
+/* ===== Public Interface ===== */
+
+bool mqtt_journal_append(const char* topic, const char* payload)
+{
+    size_t topic_len   = strlen(topic);
+    size_t payload_len = strlen(payload);
+    size_t size        = (sizeof(mqtt_journal_record_t) + topic_len + payload_len + 2 + 3) & ~3;
+
+    if(topic_len > 255 || size > MQTT_JOURNAL_SIZE / 4) {
+        journal_stats.dropped++;
+        LOG_WARNING(TAG_MQTT_PUB, F("Journal: message too long %s"), topic);
+        return false;
+    }
+
+    bool event       = journal_is_event(payload);
+    uint16_t key_len = event ? 0 : journal_key_len(payload);
+    if(!event) journal_remove_state(topic, payload, key_len);
+
+    uint16_t offset               = journal_reserve(size);
+    mqtt_journal_record_t* record = journal_record(offset);
+
+    record->size      = size;
+    record->flags     = event ? MQTT_JOURNAL_EVENT : 0;
+    record->topic_len = topic_len;
+    record->key_len   = key_len;
+    record->reserved  = 0;
+    record->millis    = millis();
+    record->epoch     = journal_epoch();
+    memcpy((char*)journal_topic(record), topic, topic_len + 1);
+    memcpy((char*)journal_payload(record), payload, payload_len + 1);
+
+    journal_tail = offset + size;
+    journal_used += size;
+    journal_count++;
+    journal_stats.journaled++;
+    if(journal_count > journal_stats.depth_max) journal_stats.depth_max = journal_count;
+
+    LOG_TRACE(TAG_MQTT_PUB, F("Journal: %s => %s"), topic, payload);
+    return true;
+}
+
+bool mqtt_journal_is_empty()
+{
+#if MQTT_JOURNAL_SPILL > 0
+    if(journal_spill_pending > 0) return false;
+#endif
+    return journal_count == 0;
+}
+
+// Publish a journaled record, events get their original time so stale ones can be discarded
+static bool journal_publish(mqtt_journal_record_t* record)
+{
+    const char* payload = journal_payload(record);
+    size_t len          = strlen(payload);
+
+    if(!(record->flags & MQTT_JOURNAL_EVENT) || len < 2) {
+        return mqttPublish(journal_topic(record), payload, len, false);
+    }
+
+    char stamped[len + 48];
+    memcpy(stamped, payload, len - 1); // strip the closing brace
+    if(record->epoch) {
+        len = len - 1 + snprintf_P(stamped + len - 1, sizeof(stamped) - len + 1, PSTR(",\"time\":%u}"), record->epoch);
+    } else {
+        len = len - 1 + snprintf_P(stamped + len - 1, sizeof(stamped) - len + 1, PSTR(",\"age\":%u}"),
+                                   (uint32_t)(millis() - record->millis));
+    }
+    return mqttPublish(journal_topic(record), stamped, len, false);
+}
+
+#if MQTT_JOURNAL_SPILL > 0
+// Replay one record from the spill file, which always holds older records than the ring
+// Returns false when the record could not be published
+static bool journal_replay_spill()
+{
+    File file = HASP_FS.open(MQTT_JOURNAL_SPILL_FILE, "r");
+    mqtt_journal_record_t header;
+    bool valid = false;
+
+    if(file && file.seek(journal_spill_read) && file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+       header.size >= sizeof(header) && header.size <= MQTT_JOURNAL_SIZE / 4) {
+        uint32_t buf[MQTT_JOURNAL_SIZE / 16];
+        mqtt_journal_record_t* record = (mqtt_journal_record_t*)buf;
+        memcpy(record, &header, sizeof(header));
+
+        if(file.read((uint8_t*)(record + 1), header.size - sizeof(header)) == header.size - sizeof(header)) {
+            if(!journal_publish(record)) {
+                file.close();
+                return false; // try again later
+            }
+            journal_stats.replayed++;
+            journal_spill_read += header.size;
+            journal_spill_pending--;
+            valid = true;
+        }
+    }
+    if(file) file.close();
+
+    if(!valid) { // missing or corrupt file, the remaining spilled records are lost
+        journal_stats.dropped += journal_spill_pending;
+        journal_spill_pending = 0;
+    }
+    if(journal_spill_pending == 0) {
+        HASP_FS.remove(MQTT_JOURNAL_SPILL_FILE);
+        journal_spill_read = 0;
+    }
+    return true;
+}
+#endif
+
+void mqtt_journal_replay()
+{
+    if(millis() - journal_last_replay < MQTT_JOURNAL_REPLAY_MS) return;
+    journal_last_replay = millis();
+
+    for(uint8_t i = 0; i < MQTT_JOURNAL_REPLAY_BURST; i++) {
+#if MQTT_JOURNAL_SPILL > 0
+        if(journal_spill_pending > 0) {
+            if(!journal_replay_spill()) return;
+            continue;
+        }
+#endif
+        if(journal_count == 0) return;
+
+        if(!journal_publish(journal_record(journal_head))) return; // keep it for the next round
+        journal_stats.replayed++;
+        journal_pop();
+        journal_trim();
+
+        if(journal_count == 0) {
+            LOG_INFO(TAG_MQTT_PUB, F("Journal: %u messages replayed"), journal_stats.replayed);
+        }
+    }
+}
+
+void mqtt_get_journal_stats(mqtt_journal_stats_t* stats)
+{
+    *stats       = journal_stats;
+    stats->depth = journal_count;
+}
+
+#endif // PUBSUBCLIENT
+#endif // HASP_USE_MQTT
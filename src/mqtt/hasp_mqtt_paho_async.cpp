@@ -32,6 +32,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <mutex>
+#include <atomic>
 
 #include "MQTTAsync.h"
 
@@ -93,6 +94,16 @@ bool mqttHAautodiscover = true;
 
 #define LWT_TOPIC "LWT"
 
+#ifndef MQTT_INBOUND_QUEUE_SIZE
+#define MQTT_INBOUND_QUEUE_SIZE 32 // Messages waiting for the main loop, must be a power of 2
+#endif
+#ifndef MQTT_INBOUND_BUDGET
+#define MQTT_INBOUND_BUDGET 8 // Messages executed per loop
+#endif
+#ifndef MQTT_INBOUND_BUDGET_MS
+#define MQTT_INBOUND_BUDGET_MS 10 // Time after which the remaining messages wait for the next loop
+#endif
+
 std::recursive_mutex dispatch_mtx;
 std::recursive_mutex publish_mtx;
 
@@ -111,6 +122,30 @@ int connected     = 0;
 
 static bool mqttPublish(const char* topic, const char* payload, size_t len, bool retain = false);
 
+/* ===== Inbound message queue =====
+ * Single producer, single consumer: the paho thread only queues a copy of each message
+ * and the main loop executes them, so the commands never run concurrently with lvgl */
+
+struct mqtt_inbound_msg_t
+{
+    char* topic;       // owned, the payload is stored in the same allocation
+    char* payload;     // null terminated
+    unsigned int length;
+    uint32_t enqueued; // millis
+};
+
+static mqtt_inbound_msg_t inbound_queue[MQTT_INBOUND_QUEUE_SIZE];
+static std::atomic<uint16_t> inbound_head(0); // next free slot, written by the paho thread
+static std::atomic<uint16_t> inbound_tail(0); // next message to execute, written by the main loop
+static std::atomic<uint32_t> inbound_received(0);
+static std::atomic<uint32_t> inbound_dropped(0);
+static std::atomic<uint16_t> inbound_depth_max(0);
+static std::atomic<bool> inbound_resubscribe(false); // set by onConnect, the bindings are subscribed by the main loop
+static uint32_t inbound_executed;
+static uint32_t inbound_latency_total;
+static uint32_t inbound_latency_max;
+static uint32_t inbound_last_received;
+
 /* ===== Paho event callbacks ===== */
 
 void connlost(void* context, char* cause)
@@ -122,7 +157,7 @@ void connlost(void* context, char* cause)
     mqttStart();
 }
 
-// Receive incoming messages
+// Receive incoming messages, called from the main loop
 static void mqtt_message_cb(char* topic, char* payload, unsigned int length)
 { // Handle incoming commands from MQTT
     if(length + 1 >= MQTT_MAX_PACKET_SIZE) {
@@ -143,9 +178,7 @@ static void mqtt_message_cb(char* topic, char* payload, unsigned int length)
 
         // Group topic
         topic += strlen(mqttGroupTopic); // shorten topic
-        dispatch_mtx.lock();
         dispatch_topic_payload(topic, (const char*)payload);
-        dispatch_mtx.unlock();
         return;
 
     } else if(topic == strstr_P(topic, PSTR("homeassistant/status"))) { // HA discovery topic
@@ -155,6 +188,9 @@ static void mqtt_message_cb(char* topic, char* payload, unsigned int length)
         }
         return;
 
+    } else if(mqtt_bind_message(topic, (const char*)payload)) { // Bound to object attributes
+        return;
+
     } else {
         // Other topic
         LOG_ERROR(TAG_MQTT, F(D_MQTT_INVALID_TOPIC));
@@ -178,9 +214,67 @@ static void mqtt_message_cb(char* topic, char* payload, unsigned int length)
             // LOG_TRACE(TAG_MQTT, F("ignoring LWT = online"));
         }
     } else {
-        dispatch_mtx.lock();
         dispatch_topic_payload(topic, (const char*)payload);
-        dispatch_mtx.unlock();
+    }
+}
+
+/* Runs on the paho thread: queue a copy of the message for the main loop */
+static void mqtt_inbound_push(const char* topic, const char* payload, unsigned int length)
+{
+    uint16_t head = inbound_head.load(std::memory_order_relaxed);
+    uint16_t tail = inbound_tail.load(std::memory_order_acquire);
+    inbound_received++;
+
+    if((uint16_t)(head - tail) >= MQTT_INBOUND_QUEUE_SIZE) {
+        inbound_dropped++;
+        return;
+    }
+
+    size_t topic_len = strlen(topic);
+    char* buffer     = (char*)malloc(topic_len + 1 + length + 1);
+    if(!buffer) {
+        inbound_dropped++;
+        return;
+    }
+
+    mqtt_inbound_msg_t& msg = inbound_queue[head & (MQTT_INBOUND_QUEUE_SIZE - 1)];
+    msg.topic               = buffer;
+    msg.payload             = buffer + topic_len + 1;
+    msg.length              = length;
+    msg.enqueued            = millis();
+    memcpy(msg.topic, topic, topic_len + 1);
+    memcpy(msg.payload, payload, length);
+    msg.payload[length] = '\0';
+
+    inbound_head.store(head + 1, std::memory_order_release);
+
+    uint16_t depth = head + 1 - tail;
+    if(depth > inbound_depth_max.load(std::memory_order_relaxed)) inbound_depth_max = depth;
+}
+
+/* Runs on the main loop: execute the queued messages within the loop budget */
+static void mqtt_inbound_drain()
+{
+    uint32_t start = millis();
+
+    // The binding trie belongs to the main loop, subscribe to its topics before the first new message runs
+    if(inbound_resubscribe.exchange(false, std::memory_order_acquire)) mqtt_bind_subscribe_all();
+
+    for(uint8_t count = 0; count < MQTT_INBOUND_BUDGET; count++) {
+        uint16_t tail = inbound_tail.load(std::memory_order_relaxed);
+        if(tail == inbound_head.load(std::memory_order_acquire)) break; // empty
+
+        mqtt_inbound_msg_t& msg = inbound_queue[tail & (MQTT_INBOUND_QUEUE_SIZE - 1)];
+        uint32_t latency        = millis() - msg.enqueued;
+        inbound_latency_total += latency;
+        if(latency > inbound_latency_max) inbound_latency_max = latency;
+        inbound_executed++;
+
+        mqtt_message_cb(msg.topic, msg.payload, msg.length);
+        free(msg.topic);
+
+        inbound_tail.store(tail + 1, std::memory_order_release);
+        if(millis() - start >= MQTT_INBOUND_BUDGET_MS) break;
     }
 }
 
@@ -189,11 +283,7 @@ int msgarrvd(void* context, char* topicName, int topicLen, MQTTAsync_message* me
     // printf("MQT RCV >> ");
     // printf("%s => %.*s (%d)\n", topicName, message->payloadlen, (char *)message->payload, message->payloadlen);
 
-    char msg[message->payloadlen + 1];
-    memcpy(msg, (char*)message->payload, message->payloadlen);
-    msg[message->payloadlen] = '\0';
-
-    mqtt_message_cb(topicName, (char*)message->payload, message->payloadlen);
+    mqtt_inbound_push(topicName, (const char*)message->payload, message->payloadlen);
 
     MQTTAsync_freeMessage(&message);
     MQTTAsync_free(topicName);
@@ -245,6 +335,24 @@ void mqtt_subscribe(void* context, const char* topic)
     }
 }
 
+bool mqttSubscribe(const char* topic)
+{
+    mqtt_subscribe(mqtt_client, topic);
+    return true; // the result is reported to onSubscribe
+}
+
+bool mqttUnsubscribe(const char* topic)
+{
+    MQTTAsync_responseOptions opts = MQTTAsync_responseOptions_initializer;
+    int rc;
+
+    if((rc = MQTTAsync_unsubscribe(mqtt_client, topic, &opts)) != MQTTASYNC_SUCCESS) {
+        LOG_ERROR(TAG_MQTT, F(D_MQTT_NOT_UNSUBSCRIBED), topic);
+        return false;
+    }
+    return true;
+}
+
 void onConnect(void* context, MQTTAsync_successData* response)
 {
     MQTTAsync client = (MQTTAsync)context;
@@ -256,6 +364,7 @@ void onConnect(void* context, MQTTAsync_successData* response)
     mqtt_subscribe(context, TOPIC "command");
     mqtt_subscribe(context, TOPIC "light");
     mqtt_subscribe(context, TOPIC "dim");
+    inbound_resubscribe.store(true, std::memory_order_release);
 
     mqttPublish(TOPIC LWT_TOPIC, "online", false);
 
@@ -426,11 +535,36 @@ void mqttStop()
     //     return rc;
 }
 
+void mqtt_get_inbound_stats(mqtt_inbound_stats_t* stats)
+{
+    uint16_t tail = inbound_tail.load(std::memory_order_relaxed);
+
+    stats->received    = inbound_received;
+    stats->dropped     = inbound_dropped;
+    stats->executed    = inbound_executed;
+    stats->depth       = inbound_head.load(std::memory_order_acquire) - tail;
+    stats->depth_max   = inbound_depth_max;
+    stats->latency_avg = inbound_executed ? inbound_latency_total / inbound_executed : 0;
+    stats->latency_max = inbound_latency_max;
+}
+
 void mqttSetup(){};
 
-void mqttLoop(){};
+void mqttLoop()
+{
+    mqtt_inbound_drain();
+}
+
+void mqttEvery5Seconds(bool wifiIsConnected)
+{
+    mqtt_inbound_stats_t stats;
+    mqtt_get_inbound_stats(&stats);
+    if(stats.received == inbound_last_received) return;
+    inbound_last_received = stats.received;
 
-void mqttEvery5Seconds(bool wifiIsConnected){};
+    LOG_VERBOSE(TAG_MQTT_RCV, F("Queue: %u received, %u dropped, depth %u/%u, latency %ums avg %ums max"),
+                stats.received, stats.dropped, stats.depth, stats.depth_max, stats.latency_avg, stats.latency_max);
+}
 
 #endif // USE_PAHO
 #endif // USE_MQTT
\ No newline at end of file
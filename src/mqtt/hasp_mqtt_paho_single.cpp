@@ -150,6 +150,9 @@ static void mqtt_message_cb(char* topic, char* payload, unsigned int length)
         }
         return;
 
+    } else if(mqtt_bind_message(topic, (const char*)payload)) { // Bound to object attributes
+        return;
+
     } else {
         // Other topic
         LOG_ERROR(TAG_MQTT, F(D_MQTT_INVALID_TOPIC));
@@ -205,6 +208,16 @@ void mqtt_subscribe(void* context, const char* topic)
     }
 }
 
+bool mqttSubscribe(const char* topic)
+{
+    return MQTTClient_subscribe(mqtt_client, topic, QOS) == MQTTCLIENT_SUCCESS;
+}
+
+bool mqttUnsubscribe(const char* topic)
+{
+    return MQTTClient_unsubscribe(mqtt_client, topic) == MQTTCLIENT_SUCCESS;
+}
+
 /* ===== Local HASP MQTT functions ===== */
 
 bool mqttPublish(const char* topic, const char* payload, size_t len, bool retain)
@@ -275,6 +288,7 @@ static void onConnect(void* context)
 
     /* Home Assistant auto-configuration */
     if(mqttHAautodiscover) mqtt_subscribe(mqtt_client, "homeassistant/status");
+    mqtt_bind_subscribe_all();
 
     mqttPublish(TOPIC LWT_TOPIC, "online", 6, false);
 
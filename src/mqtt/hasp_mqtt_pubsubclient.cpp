@@ -132,18 +132,29 @@ void mqtt_send_lwt(bool online)
     bool res   = mqttPublish(tmp_topic, tmp_payload, len, true);
 }
 
+// State and event messages are kept in the journal while the broker is unreachable, and queue up
+// behind the journaled ones until the replay has caught up so they arrive in order
+static void mqtt_send_journaled(const char* topic, const char* payload)
+{
+    if(mqttEnabled && (!mqttClient.connected() || !mqtt_journal_is_empty())) {
+        mqtt_journal_append(topic, payload);
+    } else {
+        mqttPublish(topic, payload, false);
+    }
+}
+
 void mqtt_send_object_state(uint8_t pageid, uint8_t btnid, char* payload)
 {
     char tmp_topic[strlen(mqttNodeTopic) + 16];
     snprintf_P(tmp_topic, sizeof(tmp_topic), PSTR("%sstate/" HASP_OBJECT_NOTATION), mqttNodeTopic, pageid, btnid);
-    mqttPublish(tmp_topic, payload, false);
+    mqtt_send_journaled(tmp_topic, payload);
 }
 
 void mqtt_send_state(const __FlashStringHelper* subtopic, const char* payload)
 {
     char tmp_topic[strlen(mqttNodeTopic) + 20];
     snprintf_P(tmp_topic, sizeof(tmp_topic), PSTR("%sstate/%s"), mqttNodeTopic, subtopic);
-    mqttPublish(tmp_topic, payload, false);
+    mqtt_send_journaled(tmp_topic, payload);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -178,6 +189,9 @@ static void mqtt_message_cb(char* topic, byte* payload, unsigned int length)
         }
         return;
 
+    } else if(mqtt_bind_message(topic, (const char*)payload)) { // Bound to object attributes
+        return;
+
     } else {
         // Other topic
         LOG_ERROR(TAG_MQTT, F(D_MQTT_INVALID_TOPIC));
@@ -205,15 +219,33 @@ static void mqtt_message_cb(char* topic, byte* payload, unsigned int length)
     }
 }
 
+bool mqttSubscribe(const char* topic)
+{
+    if(mqttClient.subscribe(topic)) {
+        LOG_VERBOSE(TAG_MQTT, F(D_BULLET D_MQTT_SUBSCRIBED), topic);
+        return true;
+    } else {
+        LOG_ERROR(TAG_MQTT, F(D_MQTT_NOT_SUBSCRIBED), topic);
+        return false;
+    }
+}
+
+bool mqttUnsubscribe(const char* topic)
+{
+    if(mqttClient.unsubscribe(topic)) {
+        LOG_VERBOSE(TAG_MQTT, F(D_BULLET D_MQTT_UNSUBSCRIBED), topic);
+        return true;
+    } else {
+        LOG_ERROR(TAG_MQTT, F(D_MQTT_NOT_UNSUBSCRIBED), topic);
+        return false;
+    }
+}
+
 static void mqttSubscribeTo(const __FlashStringHelper* format, const char* data)
 {
     char tmp_topic[strlen_P((PGM_P)format) + 2 + strlen(data)];
     snprintf_P(tmp_topic, sizeof(tmp_topic), (PGM_P)format, data);
-    if(mqttClient.subscribe(tmp_topic)) {
-        LOG_VERBOSE(TAG_MQTT, F(D_BULLET D_MQTT_SUBSCRIBED), tmp_topic);
-    } else {
-        LOG_ERROR(TAG_MQTT, F(D_MQTT_NOT_SUBSCRIBED), tmp_topic);
-    }
+    mqttSubscribe(tmp_topic);
 }
 
 void mqttStart()
@@ -305,6 +337,9 @@ void mqttStart()
     /* Home Assistant auto-configuration */
     if(mqttHAautodiscover) mqttSubscribeTo(F("homeassistant/status"), mqttClientId);
 
+    /* Topics bound to object attributes */
+    mqtt_bind_subscribe_all();
+
     // Force any subscribed clients to toggle offline/online when we first connect to
     // make sure we get a full panel refresh at power on.  Sending offline,
     // "online" will be sent by the mqttStatusTopic subscription action.
@@ -337,7 +372,10 @@ void mqttSetup()
 
 void mqttLoop(void)
 {
-    if(mqttEnabled) mqttClient.loop();
+    if(!mqttEnabled) return;
+
+    mqttClient.loop();
+    if(mqttClient.connected() && !mqtt_journal_is_empty()) mqtt_journal_replay();
 }
 
 void mqttEvery5Seconds(bool networkIsConnected)
@@ -346,6 +384,16 @@ void mqttEvery5Seconds(bool networkIsConnected)
         LOG_TRACE(TAG_MQTT, F(D_MQTT_RECONNECTING));
         mqttStart();
     }
+
+    static uint32_t journal_last_journaled = 0;
+    mqtt_journal_stats_t stats;
+    mqtt_get_journal_stats(&stats);
+    if(stats.journaled == journal_last_journaled) return;
+    journal_last_journaled = stats.journaled;
+
+    LOG_VERBOSE(TAG_MQTT_PUB, F("Journal: %u stored, %u deduplicated, %u replayed, %u spilled, %u dropped, depth %u/%u"),
+                stats.journaled, stats.deduplicated, stats.replayed, stats.spilled, stats.dropped, stats.depth,
+                stats.depth_max);
 }
 
 // String mqttGetNodename()
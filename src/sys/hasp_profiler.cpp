@@ -0,0 +1,162 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Main loop profiler
+ * Every instrumented section of the main loop records its duration in a histogram with two buckets per
+ * power of two. Min, max and average are exact, the p99 is the upper bound of its bucket.
+ * When a bucket saturates all buckets are halved, so the percentiles follow the recent behaviour. */
+
+#include "hasp_conf.h"
+
+#if HASP_USE_PROFILER > 0
+
+#include "hasp_profiler.h"
+
+struct profiler_histogram_t
+{
+    uint16_t bucket[PROFILER_BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+};
+
+static profiler_histogram_t profilerHistogram[PROFILER_SECTIONS];
+static uint32_t profilerLoopStart;
+static bool profilerRunning = false;
+
+static const char* const profilerSectionName[PROFILER_SECTIONS] = {
+    "cycle", "loop", "gui", "hasp", "network", "mqtt", "debug", "device", "timers"};
+
+static inline uint8_t profilerBucket(uint32_t duration)
+{
+    if(duration < 4) return duration;
+
+    uint8_t octave = 31 - __builtin_clz(duration);
+    if(octave >= PROFILER_OCTAVES) return PROFILER_BUCKETS - 1;
+    return 4 + (octave - 2) * 2 + ((duration >> (octave - 1)) & 1);
+}
+
+static uint32_t profilerBucketLimit(uint8_t bucket)
+{
+    if(bucket < 4) return bucket;
+
+    uint8_t octave = 2 + (bucket - 4) / 2;
+    return (1UL << octave) + ((((bucket - 4) & 1) + 1UL) << (octave - 1)) - 1;
+}
+
+static void profilerAdd(uint8_t section, uint32_t duration)
+{
+    profiler_histogram_t* histogram = &profilerHistogram[section];
+    uint16_t* bucket                = &histogram->bucket[profilerBucket(duration)];
+
+    if(*bucket == UINT16_MAX) {
+        for(uint8_t i = 0; i < PROFILER_BUCKETS; i++) histogram->bucket[i] >>= 1;
+    }
+    (*bucket)++;
+
+    if(histogram->count == 0 || duration < histogram->min) histogram->min = duration;
+    if(duration > histogram->max) histogram->max = duration;
+    histogram->sum += duration;
+    histogram->count++;
+}
+
+/* ===== Default Event Processors ===== */
+
+// Call first thing in the main loop, returns the start time for the first lap
+uint32_t profilerLoopBegin()
+{
+    uint32_t now = micros();
+    if(profilerRunning) profilerAdd(PROFILER_CYCLE, now - profilerLoopStart);
+    profilerLoopStart = now;
+    profilerRunning   = true;
+    return now;
+}
+
+// Record the time since start for section, returns the start time for the next lap
+uint32_t profilerRecord(uint8_t section, uint32_t start)
+{
+    uint32_t now = micros();
+    if(section < PROFILER_SECTIONS) profilerAdd(section, now - start);
+    return now;
+}
+
+// Call before the delay at the end of the main loop
+void profilerLoopEnd()
+{
+    profilerAdd(PROFILER_LOOP, micros() - profilerLoopStart);
+}
+
+/* ===== Getter and Setter Functions ===== */
+
+void profilerReset()
+{
+    memset(profilerHistogram, 0, sizeof(profilerHistogram));
+    profilerRunning = false; // the current cycle started before the reset
+}
+
+void profilerGetStats(uint8_t section, profiler_stats_t* stats)
+{
+    memset(stats, 0, sizeof(profiler_stats_t));
+    if(section >= PROFILER_SECTIONS) return;
+
+    profiler_histogram_t* histogram = &profilerHistogram[section];
+    if(histogram->count == 0) return;
+
+    stats->count = histogram->count;
+    stats->min   = histogram->min;
+    stats->max   = histogram->max;
+    stats->avg   = histogram->sum / histogram->count;
+
+    // The buckets may have been halved, take the percentile of what is left
+    uint32_t total = 0;
+    for(uint8_t i = 0; i < PROFILER_BUCKETS; i++) total += histogram->bucket[i];
+
+    uint32_t rank = total - total / 100; // samples at or below the p99
+    uint32_t seen = 0;
+    for(uint8_t i = 0; i < PROFILER_BUCKETS; i++) {
+        seen += histogram->bucket[i];
+        if(seen >= rank) {
+            stats->p99 = profilerBucketLimit(i);
+            break;
+        }
+    }
+    if(stats->p99 > stats->max) stats->p99 = stats->max;
+    if(stats->p99 < stats->min) stats->p99 = stats->min;
+}
+
+// Loops per second since the last reset
+uint32_t profilerGetFrequency()
+{
+    profiler_histogram_t* histogram = &profilerHistogram[PROFILER_CYCLE];
+    if(histogram->sum == 0) return 0;
+    return (uint64_t)histogram->count * 1000000 / histogram->sum;
+}
+
+// JSON object with the loop frequency and [min,avg,p99,max] in microseconds per section
+// Sections that do not fit in the buffer are left out, the object is always closed
+size_t profilerGetStatus(char* buffer, size_t size)
+{
+    if(size == 0) return 0;
+
+    int len = snprintf_P(buffer, size, PSTR("{\"hz\":%u"), profilerGetFrequency());
+    if(len < 0 || (size_t)len + 2 > size) { // no room for the closing brace
+        buffer[0] = 0;
+        return 0;
+    }
+
+    for(uint8_t i = 0; i < PROFILER_SECTIONS; i++) {
+        profiler_stats_t stats;
+        profilerGetStats(i, &stats);
+        int added = snprintf_P(buffer + len, size - len, PSTR(",\"%s\":[%u,%u,%u,%u]"), profilerSectionName[i],
+                               stats.min, stats.avg, stats.p99, stats.max);
+        if(added < 0 || (size_t)(len + added) + 2 > size) break; // keep the room for the closing brace
+        len += added;
+    }
+
+    buffer[len++] = '}';
+    buffer[len]   = 0;
+    return len;
+}
+
+#endif // HASP_USE_PROFILER
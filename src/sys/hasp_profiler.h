@@ -0,0 +1,67 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_PROFILER_H
+#define HASP_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hasp_conf.h"
+
+#if HASP_USE_PROFILER > 0
+
+#ifndef PROFILER_OCTAVES
+#define PROFILER_OCTAVES 22 // durations are bucketed up to 2^PROFILER_OCTAVES us
+#endif
+
+/* Two buckets per power of two, the reported p99 is accurate to within 50% */
+#define PROFILER_BUCKETS (4 + 2 * (PROFILER_OCTAVES - 2))
+
+enum profiler_section_t {
+    PROFILER_CYCLE = 0, // time between the start of two loops, including the delay
+    PROFILER_LOOP,      // busy time of one loop, excluding the delay
+    PROFILER_GUI,
+    PROFILER_HASP,
+    PROFILER_NETWORK,
+    PROFILER_MQTT,
+    PROFILER_DEBUG,
+    PROFILER_DEVICE,
+    PROFILER_TIMERS, // the 1 and 5 second timers, only measured when they run
+    PROFILER_SECTIONS
+};
+
+struct profiler_stats_t
+{
+    uint32_t count; // samples since the last reset
+    uint32_t min;   // all durations in microseconds
+    uint32_t avg;
+    uint32_t p99;
+    uint32_t max;
+};
+
+/* ===== Default Event Processors ===== */
+uint32_t profilerLoopBegin(void);
+uint32_t profilerRecord(uint8_t section, uint32_t start);
+void profilerLoopEnd(void);
+
+/* ===== Getter and Setter Functions ===== */
+void profilerReset(void);
+void profilerGetStats(uint8_t section, profiler_stats_t* stats);
+uint32_t profilerGetFrequency(void);
+size_t profilerGetStatus(char* buffer, size_t size);
+
+/* Instrument a sequence of calls, each lap records the time since the previous one */
+#define PROFILER_START() uint32_t profilerLap = profilerLoopBegin()
+#define PROFILER_LAP(section) profilerLap = profilerRecord(section, profilerLap)
+#define PROFILER_END() profilerLoopEnd()
+
+#else
+
+#define PROFILER_START()
+#define PROFILER_LAP(section)
+#define PROFILER_END()
+
+#endif // HASP_USE_PROFILER
+
+#endif
@@ -0,0 +1,114 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+/* Main loop scheduler
+ * Periodic tasks register a callback and an interval, the main loop runs the expired ones and then sleeps
+ * until the next timer or gui deadline. The earliest expiry is cached, so an idle loop only compares it
+ * to the clock. Timers keep their phase, a timer that fell a full interval behind skips the missed runs. */
+
+#include "hasp_scheduler.h"
+
+struct scheduler_timer_t
+{
+    scheduler_callback_t callback;
+    uint32_t interval; // ms, 0 = paused
+    uint32_t expiry;   // millis() of the next run
+};
+
+static scheduler_timer_t schedulerTimer[SCHEDULER_TIMERS];
+static uint8_t schedulerCount = 0;
+static uint32_t schedulerNext; // earliest expiry of all running timers
+static bool schedulerIdle = true; // no timer is running
+
+static inline bool schedulerIsDue(uint32_t expiry, uint32_t now)
+{
+    return (int32_t)(now - expiry) >= 0;
+}
+
+static void schedulerUpdateNext()
+{
+    schedulerIdle = true;
+    for(uint8_t i = 0; i < schedulerCount; i++) {
+        if(schedulerTimer[i].interval == 0) continue;
+        if(schedulerIdle || (int32_t)(schedulerTimer[i].expiry - schedulerNext) < 0) {
+            schedulerNext = schedulerTimer[i].expiry;
+            schedulerIdle = false;
+        }
+    }
+}
+
+/* ===== Default Event Processors ===== */
+
+// Run the expired timers, returns the number of callbacks that ran
+uint8_t schedulerLoop()
+{
+    uint32_t now = millis();
+    if(schedulerIdle || !schedulerIsDue(schedulerNext, now)) return 0;
+
+    uint8_t ran = 0;
+    for(uint8_t i = 0; i < schedulerCount; i++) {
+        scheduler_timer_t* timer = &schedulerTimer[i];
+        if(timer->interval == 0 || !schedulerIsDue(timer->expiry, now)) continue;
+
+        timer->expiry += timer->interval;
+        if(schedulerIsDue(timer->expiry, now)) timer->expiry = now + timer->interval; // skip missed runs
+
+        timer->callback();
+        ran++;
+    }
+
+    schedulerUpdateNext();
+    return ran;
+}
+
+// Sleep until the next timer or until gui_next ms have passed, whichever comes first
+void schedulerSleep(uint32_t gui_next)
+{
+    uint32_t sleep = schedulerGetNext();
+    if(gui_next < sleep) sleep = gui_next;
+    if(sleep > SCHEDULER_MAX_SLEEP_MS) sleep = SCHEDULER_MAX_SLEEP_MS;
+
+    delay(sleep); // a delay of 0 still yields to the system tasks
+}
+
+/* ===== Getter and Setter Functions ===== */
+
+/**
+ * Register a periodic task
+ * @param interval time between two runs in ms
+ * @param callback function to run
+ * @param first time until the first run in ms
+ * @return id of the timer or -1 when all timers are in use
+ */
+int8_t schedulerAdd(uint32_t interval, scheduler_callback_t callback, uint32_t first)
+{
+    if(schedulerCount >= SCHEDULER_TIMERS || !callback) return -1;
+
+    scheduler_timer_t* timer = &schedulerTimer[schedulerCount];
+    timer->callback          = callback;
+    timer->interval          = interval;
+    timer->expiry            = millis() + first;
+    schedulerCount++;
+
+    schedulerUpdateNext();
+    return schedulerCount - 1;
+}
+
+// Change the interval of a timer, the next run is one interval from now, 0 pauses the timer
+void schedulerSetInterval(int8_t id, uint32_t interval)
+{
+    if(id < 0 || id >= schedulerCount) return;
+
+    schedulerTimer[id].interval = interval;
+    schedulerTimer[id].expiry   = millis() + interval;
+    schedulerUpdateNext();
+}
+
+// Time in ms until the next timer expires
+uint32_t schedulerGetNext()
+{
+    if(schedulerIdle) return UINT32_MAX;
+
+    int32_t remaining = schedulerNext - millis();
+    return remaining > 0 ? remaining : 0;
+}
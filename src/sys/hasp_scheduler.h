@@ -0,0 +1,30 @@
+/* MIT License - Copyright (c) 2019-2021 Francis Van Roie
+   For full license information read the LICENSE file in the project folder */
+
+#ifndef HASP_SCHEDULER_H
+#define HASP_SCHEDULER_H
+
+#include <stdint.h>
+
+#include "hasp_conf.h"
+
+#ifndef SCHEDULER_TIMERS
+#define SCHEDULER_TIMERS 8 // number of periodic tasks that can be registered
+#endif
+
+#ifndef SCHEDULER_MAX_SLEEP_MS
+#define SCHEDULER_MAX_SLEEP_MS 50 // longest idle time of the main loop, bounds the latency of polled services
+#endif
+
+typedef void (*scheduler_callback_t)(void);
+
+/* ===== Default Event Processors ===== */
+uint8_t schedulerLoop(void);
+void schedulerSleep(uint32_t gui_next);
+
+/* ===== Getter and Setter Functions ===== */
+int8_t schedulerAdd(uint32_t interval, scheduler_callback_t callback, uint32_t first);
+void schedulerSetInterval(int8_t id, uint32_t interval);
+uint32_t schedulerGetNext(void);
+
+#endif
@@ -14,18 +14,25 @@
 #include "dev/device.h"
 
 #include "hasp_gui.h"
+#include "hasp_screenshot.h"
 #include "hal/hasp_hal.h"
 #include "hasp_debug.h"
 #include "hasp_config.h"
 
 #include "hasp/hasp_utilities.h"
 #include "hasp/hasp_dispatch.h"
+#include "hasp/hasp_imgcache.h"
 #include "hasp/hasp.h"
 
+#if LV_USE_FS_IF != 0
+#include "lv_fs_cache.h"
+#endif
+
 #if HASP_USE_HTTP > 0
 
 #if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
 File fsUploadFile;
+static char fsUploadPath[32]; // path of the file being uploaded, its caches are dropped again when it is complete
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -266,7 +273,12 @@ void saveConfig()
         if(webServer.hasArg(PSTR("save"))) {
             String save = webServer.arg(PSTR("save"));
 
-            StaticJsonDocument<256> settings;
+            // Room for every form field and its copied name and value, plus the gui checkboxes added below
+            size_t maxsize = JSON_OBJECT_SIZE(webServer.args() + 3) + sizeof(FP_GUI_POINTER) +
+                             sizeof(FP_GUI_INVERT) + sizeof(FP_GUI_DOUBLEBUF);
+            for(int i = 0; i < webServer.args(); i++)
+                maxsize += webServer.argName(i).length() + webServer.arg(i).length() + 2;
+            DynamicJsonDocument settings(maxsize);
             for(int i = 0; i < webServer.args(); i++) settings[webServer.argName(i)] = webServer.arg(i);
 
             if(save == String(PSTR("hasp"))) {
@@ -278,8 +290,9 @@ void saveConfig()
 #endif
 
             } else if(save == String(PSTR("gui"))) {
-                settings[FPSTR(FP_GUI_POINTER)] = webServer.hasArg(PSTR("cur"));
-                settings[FPSTR(FP_GUI_INVERT)]  = webServer.hasArg(PSTR("inv"));
+                settings[FPSTR(FP_GUI_POINTER)]   = webServer.hasArg(PSTR("cur"));
+                settings[FPSTR(FP_GUI_INVERT)]    = webServer.hasArg(PSTR("inv"));
+                settings[FPSTR(FP_GUI_DOUBLEBUF)] = webServer.hasArg(PSTR("dblbuf"));
                 guiSetConfig(settings.as<JsonObject>());
 
             } else if(save == String(PSTR("debug"))) {
@@ -381,10 +394,10 @@ void webHandleScreenshot()
     }
 
     if(webServer.hasArg(F("q"))) {
-        lv_disp_t* disp = lv_disp_get_default();
-        webServer.setContentLength(122 + disp->driver.hor_res * disp->driver.ver_res * sizeof(lv_color_t));
-        webServer.send_P(200, PSTR("image/bmp"), "");
+        webServer.setContentLength(CONTENT_LENGTH_UNKNOWN); // the size of the compressed image is not known yet
+        webServer.send_P(200, screenshot_mimetype(SCREENSHOT_PNG), "");
         guiTakeScreenshot();
+        webServer.sendContent(""); // last chunk
         webServer.client().stop();
 
     } else {
@@ -883,6 +896,11 @@ void handleFileUpload()
             filename += upload->filename;
         }
         if(filename.length() < 32) {
+#if LV_USE_FS_IF != 0
+            lv_fs_cache_invalidate(filename.c_str()); // drop the pooled handle of the old file
+#endif
+            hasp_img_cache_invalidate(filename.c_str());
+            strncpy(fsUploadPath, filename.c_str(), sizeof(fsUploadPath));
             fsUploadFile = HASP_FS.open(filename, "w");
             LOG_TRACE(TAG_HTTP, F("handleFileUpload Name: %s"), filename.c_str());
             haspProgressMsg(fsUploadFile.name());
@@ -902,6 +920,12 @@ void handleFileUpload()
         if(fsUploadFile) {
             LOG_INFO(TAG_HTTP, F("Uploaded %s (%u bytes)"), fsUploadFile.name(), upload->totalSize);
             fsUploadFile.close();
+
+            /* lvgl may have opened the partial file during the upload */
+#if LV_USE_FS_IF != 0
+            lv_fs_cache_invalidate(fsUploadPath);
+#endif
+            hasp_img_cache_invalidate(fsUploadPath);
         }
         haspProgressVal(255);
 
@@ -930,6 +954,10 @@ void handleFileDelete()
     if(!HASP_FS.exists(path)) {
         return webServer.send_P(404, mimetype, PSTR("FileNotFound"));
     }
+#if LV_USE_FS_IF != 0
+    lv_fs_cache_invalidate(path.c_str());
+#endif
+    hasp_img_cache_invalidate(path.c_str());
     HASP_FS.remove(path);
     webServer.send_P(200, mimetype, PSTR(""));
     // path.clear();
@@ -1188,6 +1216,15 @@ void webHandleGuiConfig()
         if(settings[FPSTR(FP_GUI_POINTER)].as<bool>()) httpMessage += F(" checked");
         httpMessage += F("><b>Show Pointer</b>");
 
+        httpMessage += F("<p><b>Draw Buffer (KB)</b> <input id='vdbsize' required "
+                         "name='vdbsize' type='number' min='1' max='256' value='");
+        httpMessage += settings[FPSTR(FP_GUI_VDBSIZE)].as<String>();
+        httpMessage += F("'></p>");
+
+        httpMessage += F("<p><input id='dblbuf' name='dblbuf' type='checkbox' ");
+        if(settings[FPSTR(FP_GUI_DOUBLEBUF)].as<bool>()) httpMessage += F(" checked");
+        httpMessage += F("><b>Double Buffering</b> (after restart)");
+
         int8_t bcklpin = settings[FPSTR(FP_GUI_BACKLIGHTPIN)].as<int8_t>();
         httpMessage += F("<p><b>Backlight Control</b> <select id='bckl' name='bckl'>");
         httpMessage += getOption(-1, F("None"), bcklpin == -1);
@@ -2108,12 +2145,9 @@ size_t httpClientWrite(const uint8_t* buf, size_t size)
     size_t bytes_sent = 0;
     while(bytes_sent < size) {
         if(!webServer.client()) return bytes_sent;
-        if(size - bytes_sent >= 2048) {
-            bytes_sent += webServer.client().write(buf + bytes_sent, 2048);
-        } else {
-            bytes_sent += webServer.client().write(buf + bytes_sent, size - bytes_sent);
-        }
-        // Serial.println(bytes_sent);
+        size_t len = size - bytes_sent >= 2048 ? 2048 : size - bytes_sent;
+        webServer.sendContent((const char*)buf + bytes_sent, len); // adds the chunk header if the length is unknown
+        bytes_sent += len;
 
         // stm32_eth_scheduler(); // already in write
         // webServer.client().flush();
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+# MIT License - Copyright (c) 2019-2021 Francis Van Roie
+# For full license information read the LICENSE file in the project folder
+#
+# Convert an image into the strip-streamed background format drawn by src/hasp/hasp_background.cpp
+# Pick a strip height close to the number of lines in the lvgl draw buffer, the device holds one decoded strip
+# of an RLE file in RAM. Raw files need no RAM at all but take more flash.
+#
+# Usage: python tools/img2bg.py [--rle] [--strip 16] [--size 480x320] image.png [image.bg]
+# Requires Pillow: pip install pillow
+
+import argparse
+import re
+import struct
+import sys
+
+MAGIC = b"HSPS"
+VERSION = 1
+HEADER_SIZE = 16
+
+FLAG_RLE = 0x01
+
+MAX_PACKET = 128
+
+
+def rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def encode_rle(pixels):
+    """Packets of up to 128 pixels, 0x80 | (n - 1) repeats the next pixel and n - 1 prefixes n literal pixels"""
+    output = bytearray()
+    literals = []
+
+    def flush_literals():
+        while literals:
+            chunk = literals[:MAX_PACKET]
+            del literals[:MAX_PACKET]
+            output.append(len(chunk) - 1)
+            for px in chunk:
+                output.extend(struct.pack("<H", px))
+
+    i = 0
+    while i < len(pixels):
+        run = 1
+        while i + run < len(pixels) and run < MAX_PACKET and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 2:
+            flush_literals()
+            output.append(0x80 | (run - 1))
+            output += struct.pack("<H", pixels[i])
+        else:
+            literals.append(pixels[i])
+        i += run
+
+    flush_literals()
+    return output
+
+
+def encode_background(pixels, width, height, strip_lines, rle):
+    """pixels is a list of RGB565 values, row by row"""
+    header = MAGIC + struct.pack("<BBHHHI", VERSION, FLAG_RLE if rle else 0, strip_lines, width, height, 0)
+    if not rle:
+        return header + b"".join(struct.pack("<H", px) for px in pixels)
+
+    strips = []
+    for y in range(0, height, strip_lines):
+        strips.append(encode_rle(pixels[y * width:min(y + strip_lines, height) * width]))
+
+    offset = HEADER_SIZE + 4 * (len(strips) + 1)
+    table = bytearray()
+    for strip in strips:
+        table += struct.pack("<I", offset)
+        offset += len(strip)
+    table += struct.pack("<I", offset)
+
+    return header + table + b"".join(strips)
+
+
+def load_image(source, size):
+    from PIL import Image
+
+    image = Image.open(source).convert("RGB")
+    if size:
+        image = image.resize(size, Image.LANCZOS)
+    width, height = image.size
+    return [rgb565(r, g, b) for r, g, b in image.getdata()], width, height
+
+
+def parse_size(text):
+    match = re.match(r"^(\d+)x(\d+)$", text)
+    if not match:
+        raise argparse.ArgumentTypeError("size must be WIDTHxHEIGHT")
+    return int(match.group(1)), int(match.group(2))
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Convert an image into a strip-streamed .bg background")
+    parser.add_argument("--rle", action="store_true", help="compress the strips with run-length encoding")
+    parser.add_argument("--strip", type=int, default=16, help="lines per strip (default 16)")
+    parser.add_argument("--size", type=parse_size, help="resize the image to WIDTHxHEIGHT first")
+    parser.add_argument("source")
+    parser.add_argument("target", nargs="?")
+    args = parser.parse_args(argv[1:])
+
+    if not 1 <= args.strip <= 0xFFFF:
+        print("Strip height must be between 1 and 65535 lines", file=sys.stderr)
+        return 2
+
+    pixels, width, height = load_image(args.source, args.size)
+    if width > 0xFFFF or height > 0xFFFF:
+        print("Image is too large", file=sys.stderr)
+        return 1
+
+    target = args.target or re.sub(r"\.[^./\\]*$", "", args.source) + ".bg"
+    data = encode_background(pixels, width, height, args.strip, args.rle)
+    with open(target, "wb") as f:
+        f.write(data)
+
+    strip_ram = args.strip * width * 2 if args.rle else 0
+    print("%s: %ux%u, %d bytes written, %d bytes of RAM per open image" % (target, width, height, len(data), strip_ram))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
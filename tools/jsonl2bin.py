@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+# MIT License - Copyright (c) 2019-2021 Francis Van Roie
+# For full license information read the LICENSE file in the project folder
+#
+# Compile a pages.jsonl file into the binary pages.bin format read by hasp_pagebin_load()
+# Object types and attribute names are stored pre-hashed and colors and numbers pre-decoded
+#
+# Usage: python tools/jsonl2bin.py data/pages.jsonl [data/pages.bin]
+
+import json
+import re
+import struct
+import sys
+
+MAGIC = b"HSPB"
+VERSION = 1
+
+FLAG_PAGE = 0x01
+FLAG_OBJ = 0x02
+
+VALUE_STRING = 0
+VALUE_INT32 = 1
+VALUE_COLOR = 2
+
+MAX_RECORD = 2048  # HASP_JSONL_MAX_LINE on ESP8266, the smallest target
+
+# Same table as haspNamedColors in src/hasp/hasp_parser.h
+NAMED_COLORS = {
+    "red": (0xFF, 0x00, 0x00), "tan": (0xD2, 0xB4, 0x8C), "aqua": (0x00, 0xFF, 0xFF),
+    "blue": (0x00, 0x00, 0xFF), "cyan": (0x00, 0xFF, 0xFF), "gold": (0xFF, 0xD7, 0x00),
+    "gray": (0x80, 0x80, 0x80), "grey": (0x80, 0x80, 0x80), "lime": (0x00, 0xFF, 0x00),
+    "navy": (0x00, 0x00, 0x80), "peru": (0xCD, 0x85, 0x3F), "pink": (0xFF, 0xC0, 0xCB),
+    "plum": (0xDD, 0xA0, 0xDD), "snow": (0xFF, 0xFA, 0xFA), "teal": (0x00, 0x80, 0x80),
+    "azure": (0xF0, 0xFF, 0xFF), "beige": (0xF5, 0xF5, 0xDC), "black": (0x00, 0x00, 0x00),
+    "blush": (0xB0, 0x00, 0x00), "brown": (0xA5, 0x2A, 0x2A), "coral": (0xFF, 0x7F, 0x50),
+    "green": (0x00, 0x80, 0x00), "ivory": (0xFF, 0xFF, 0xF0), "khaki": (0xF0, 0xE6, 0x8C),
+    "linen": (0xFA, 0xF0, 0xE6), "olive": (0x80, 0x80, 0x00), "wheat": (0xF5, 0xDE, 0xB3),
+    "white": (0xFF, 0xFF, 0xFF), "bisque": (0xFF, 0xE4, 0xC4), "indigo": (0x4B, 0x00, 0x82),
+    "maroon": (0x80, 0x00, 0x00), "orange": (0xFF, 0xA5, 0x00), "orchid": (0xDA, 0x70, 0xD6),
+    "purple": (0x80, 0x00, 0x80), "salmon": (0xFA, 0x80, 0x72), "sienna": (0xA0, 0x52, 0x2D),
+    "silver": (0xC0, 0xC0, 0xC0), "tomato": (0xFF, 0x63, 0x47), "violet": (0xEE, 0x82, 0xEE),
+    "yellow": (0xFF, 0xFF, 0x00), "fuchsia": (0xFF, 0x00, 0xFF), "magenta": (0xFF, 0x00, 0xFF),
+}
+
+# Style color properties, e.g. bg_color, text_color20, image_recolor
+COLOR_ATTRIBUTE = re.compile(r"_(re)?color\d*$", re.IGNORECASE)
+
+# Keys consumed by the object creator, see hasp_new_object()
+OBJECT_KEYS = ("page", "id", "obj", "objid", "parentid")
+
+
+def sdbm(text):
+    """Utilities::get_sdbm()"""
+    hash = 0
+    for c in text.encode("utf-8"):
+        hash = (tolower(c) + (hash << 6) - hash) & 0xFFFF
+    return hash
+
+
+def tolower(c):
+    return c + 32 if 65 <= c <= 90 else c
+
+
+def attribute_hashes(name):
+    """hasp_attribute_hash(): the full hash and the hash without a trailing index digit"""
+    hash = sdbm(name)
+    if name[-1:].isdigit():
+        return hash, sdbm(name[:-1])
+    return hash, hash
+
+
+def rgb565(value):
+    r5 = (value >> 11) & 0b11111
+    g6 = (value >> 5) & 0b111111
+    b5 = value & 0b11111
+    return ((r5 * 527 + 23) >> 6, (g6 * 259 + 33) >> 6, (b5 * 527 + 23) >> 6)
+
+
+def parse_color(value):
+    """Parser::haspPayloadToColor(), returns None when the device has to parse the value itself"""
+    if isinstance(value, bool):
+        return None
+    if isinstance(value, int):
+        return rgb565(value) if 0 <= value <= 0xFFFF else None
+    if not isinstance(value, str):
+        return None
+
+    if re.fullmatch(r"#[0-9a-fA-F]{6}", value):
+        return tuple(bytes.fromhex(value[1:]))
+    if re.fullmatch(r"#[0-9a-fA-F]{3}", value):
+        return tuple(int(c, 16) * 17 for c in value[1:])
+    if re.fullmatch(r"[0-9]+", value) and int(value) <= 0xFFFF:
+        return rgb565(int(value))
+    return NAMED_COLORS.get(value.lower())
+
+
+def as_string(value):
+    """The text the device gets from JsonVariant::as<String>()"""
+    if isinstance(value, str):
+        return value
+    if isinstance(value, bool):
+        return "true" if value else "false"
+    if value is None:
+        return "null"
+    if isinstance(value, (int, float)):
+        return str(value)
+    return json.dumps(value, separators=(",", ":"), ensure_ascii=False)
+
+
+def as_uint8(value):
+    """JsonVariant::as<uint8_t>()"""
+    if isinstance(value, bool) or not isinstance(value, int):
+        return 0
+    return value & 0xFF
+
+
+def encode_attribute(name, value):
+    if name.startswith("."):
+        name = name[1:]
+    hash, hash_noindex = attribute_hashes(name)
+
+    color = parse_color(value) if COLOR_ATTRIBUTE.search(name) else None
+    if color is not None:
+        type, data = VALUE_COLOR, bytes(color)
+    elif isinstance(value, int) and not isinstance(value, bool) and -(2**31) <= value < 2**31:
+        type, data = VALUE_INT32, struct.pack("<i", value)
+    else:
+        type, data = VALUE_STRING, as_string(value).encode("utf-8") + b"\0"
+
+    name = name.encode("utf-8") + b"\0"
+    if len(name) > 255 or len(data) > 0xFFFF:
+        raise ValueError("attribute %s is too long" % name)
+    return struct.pack("<HHBBH", hash, hash_noindex, type, len(name), len(data)) + name + data
+
+
+def encode_record(config):
+    flags = 0
+    pageid = 0
+    if config.get("page") is not None:
+        flags |= FLAG_PAGE
+        pageid = as_uint8(config["page"])
+
+    if config.get("objid") is not None:  # TODO: obsolete objid
+        flags |= FLAG_OBJ
+        objtype = as_uint8(config["objid"])
+    elif config.get("obj") is not None:
+        flags |= FLAG_OBJ
+        objtype = sdbm(as_string(config["obj"]))
+    else:
+        objtype = 0
+
+    attributes = [encode_attribute(k, v) for k, v in config.items() if k not in OBJECT_KEYS]
+    if len(attributes) > 255:
+        raise ValueError("too many attributes")
+
+    body = struct.pack(
+        "<BBBBHB",
+        flags,
+        pageid,
+        as_uint8(config.get("id")),
+        as_uint8(config.get("parentid")),
+        objtype,
+        len(attributes),
+    )
+    body += b"".join(attributes)
+    if len(body) > MAX_RECORD:
+        raise ValueError("record is %d bytes, the maximum is %d" % (len(body), MAX_RECORD))
+    return struct.pack("<H", len(body)) + body
+
+
+def read_jsonl(text):
+    """Yield (line, value) for every json value, values may span multiple lines like on the device"""
+    decoder = json.JSONDecoder()
+    pos = 0
+    while True:
+        while pos < len(text) and text[pos].isspace():
+            pos += 1
+        if pos >= len(text):
+            return
+        line = text.count("\n", 0, pos) + 1
+        try:
+            value, pos = decoder.raw_decode(text, pos)
+        except json.JSONDecodeError as e:
+            print("JSONL parsing failed at line %d: %s" % (line, e.msg), file=sys.stderr)
+            end = text.find("\n", pos)
+            pos = len(text) if end < 0 else end + 1
+            continue
+        yield line, value
+
+
+def compile_pages(text):
+    output = bytearray(MAGIC + struct.pack("<BBH", VERSION, 0, 0))
+    errors = 0
+    for line, config in read_jsonl(text):
+        if not isinstance(config, dict):
+            print("Line %d is not a json object, skipping" % line, file=sys.stderr)
+            errors += 1
+            continue
+        try:
+            output += encode_record(config)
+        except ValueError as e:
+            print("Line %d: %s" % (line, e), file=sys.stderr)
+            errors += 1
+    return bytes(output), errors
+
+
+def main(argv):
+    if len(argv) < 2 or len(argv) > 3:
+        print("Usage: %s pages.jsonl [pages.bin]" % argv[0], file=sys.stderr)
+        return 2
+
+    source = argv[1]
+    target = argv[2] if len(argv) == 3 else re.sub(r"\.jsonl?$", "", source) + ".bin"
+
+    with open(source, "r", encoding="utf-8") as f:
+        data, errors = compile_pages(f.read())
+    with open(target, "wb") as f:
+        f.write(data)
+
+    print("%s: %d bytes written, %d errors" % (target, len(data), errors))
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))